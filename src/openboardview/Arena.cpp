@@ -0,0 +1,40 @@
+#include "Arena.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+Arena::~Arena() {
+	for (auto block : m_blocks) free(block);
+}
+
+void *Arena::alloc(size_t size, size_t align) {
+	size_t pad = -reinterpret_cast<uintptr_t>(m_next) & (align - 1);
+	if (size + pad > static_cast<size_t>(m_end - m_next)) {
+		// malloc() memory is aligned for any type
+		if (size > block_size / 4) { // Big allocations get a block of their own, the current one stays in use
+			char *big = (char *)malloc(size);
+			assert(big != nullptr);
+			m_blocks.push_back(big);
+			m_size += size;
+			return big;
+		}
+		m_next = (char *)malloc(block_size);
+		assert(m_next != nullptr);
+		m_end = m_next + block_size;
+		m_blocks.push_back(m_next);
+		m_size += block_size;
+		pad = 0;
+	}
+	char *p = m_next + pad;
+	m_next  = p + size;
+	return p;
+}
+
+void Arena::adopt(Arena &other) {
+	m_blocks.insert(m_blocks.end(), other.m_blocks.begin(), other.m_blocks.end());
+	m_size += other.m_size;
+	other.m_blocks.clear();
+	other.m_next = other.m_end = nullptr;
+	other.m_size = 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Bump allocator for everything a board owns: names, pin lists, hulls and
+ * other derived geometry, and the strings its file parser had to rewrite (see
+ * fix_to_utf8()). Allocations are never freed one by one, the whole arena goes
+ * at once when it is destroyed, so only trivially destructible data may be put
+ * in it. Blocks are taken on the first allocation, so an arena nothing is put
+ * in costs nothing.
+ */
+class Arena {
+  public:
+	Arena() = default;
+	~Arena();
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+	// Returns size uninitialised bytes aligned to align, a power of two
+	void *alloc(size_t size, size_t align);
+
+	// Returns room for count T, uninitialised
+	template <class T>
+	T *alloc(size_t count) {
+		static_assert(std::is_trivially_destructible<T>::value, "Arena memory is never destructed");
+		return static_cast<T *>(alloc(count * sizeof(T), alignof(T)));
+	}
+
+	// Takes over the memory of other, which is left empty
+	void adopt(Arena &other);
+
+	// Bytes taken from the system
+	size_t size() const {
+		return m_size;
+	}
+
+  private:
+	static const size_t block_size = 256 * 1024;
+
+	std::vector<char *> m_blocks;
+	char *m_next  = nullptr; // Free space in the last block
+	char *m_end   = nullptr;
+	size_t m_size = 0;
+};
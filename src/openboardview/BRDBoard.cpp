@@ -2,7 +2,10 @@
 
 #include "FileFormats/BRDFile.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -16,188 +19,284 @@ using namespace std::placeholders;
 const string BRDBoard::kNetUnconnectedPrefix = "UNCONNECTED";
 const string BRDBoard::kComponentDummyName   = "...";
 
+// Like is_prefix(), without copying either string
+static bool has_prefix(const char *str, const string &prefix) {
+	return strncmp(str, prefix.c_str(), prefix.size()) == 0;
+}
+
+// What is known of a pin until all parts are in
+struct BRDBoard::PendingPin {
+	Name number;
+	Point position;
+	float diameter;
+	Pin::EPinType type;
+	uint32_t component; // Index in Pending::comps, dummy_component for test pads
+	uint32_t net;       // Index in Pending::nets
+};
+
+// State of a board being built, dropped by finish()
+struct BRDBoard::Pending {
+	// Unique nets, found by the symbol of their name. They get their final place once sorted by name
+	vector<Net> nets;
+	vector<uint32_t> symbol_net; // Net of each symbol, UINT32_MAX if it does not name one
+	uint32_t unconnected_net = 0;
+
+	// Real parts, all dummy parts share a single component added at the end
+	vector<Component> comps;
+	vector<uint32_t> part_comp; // Component of each part begun
+
+	vector<PendingPin> pins;
+
+	// NOTE: originally the pin diameter depended on part.name[0] == 'U' ?
+	unsigned int pin_idx  = 0;
+	unsigned int part_idx = 1;
+};
+
+static const uint32_t dummy_component = UINT32_MAX;
+
+BRDBoard::BRDBoard()
+    : pending_(new Pending) {
+	// adding special net 'UNCONNECTED'
+	pending_->unconnected_net = AddNet(names_.intern(kNetUnconnectedPrefix.c_str()));
+}
+
 BRDBoard::BRDBoard(const BRDFile *const boardFile)
-    : m_file(boardFile) {
-	// TODO: strip / trim all strings, especially those used as keys
-	// TODO: just loop through original arrays?
-	vector<BRDPart> m_parts   = m_file->parts;
-	vector<BRDPin> m_pins     = m_file->pins;
-	vector<BRDNail> m_nails   = m_file->nails;
-	vector<BRDPoint> m_points = m_file->format;
+    : BRDBoard() {
+	boardFile->build(*this);
+	finish();
+}
 
-	// Set outline
-	{
-		for (auto &brdPoint : m_points) {
-			auto point = make_shared<Point>(brdPoint.x, brdPoint.y);
-			outline_.push_back(point);
-		}
+uint32_t BRDBoard::AddNet(Symbol name) {
+	Pending &p = *pending_;
+	if (name >= p.symbol_net.size()) p.symbol_net.resize(names_.size(), UINT32_MAX);
+	if (p.symbol_net[name] == UINT32_MAX) {
+		p.symbol_net[name] = p.nets.size();
+		p.nets.emplace_back();
+		p.nets.back().name      = names_.name(name);
+		p.nets.back().number    = 0;
+		p.nets.back().is_ground = false;
 	}
+	return p.symbol_net[name];
+}
 
-	// Populate map of unique nets
-	SharedStringMap<Net> net_map;
-	{
-		// adding special net 'UNCONNECTED'
-		auto net_nc           = make_shared<Net>();
-		net_nc->name          = kNetUnconnectedPrefix;
-		net_nc->is_ground     = false;
-		net_map[net_nc->name] = net_nc;
+void BRDBoard::addOutlinePoint(const BRDPoint &point) {
+	outline_store_.push_back(Point(point.x, point.y));
+}
 
-		// handle all the others
-		for (auto &brd_nail : m_nails) {
-			auto net = make_shared<Net>();
+void BRDBoard::addNail(const BRDNail &brd_nail) {
+	// avoid having multiple UNCONNECTED<XXX> references
+	if (has_prefix(brd_nail.net, kNetUnconnectedPrefix)) return;
 
-			// copy NET name and number (probe)
-			net->name = string(brd_nail.net);
+	// so we can find nets later by name (making unique by name)
+	Net &net = pending_->nets[AddNet(names_.intern(brd_nail.net))];
 
-			// avoid having multiple UNCONNECTED<XXX> references
-			if (is_prefix(kNetUnconnectedPrefix, net->name)) continue;
+	// copy NET number (probe) and check whether the pin represents ground
+	net.is_ground = (strcmp(brd_nail.net, "GND") == 0);
+	net.number    = brd_nail.probe;
 
-			// check whether the pin represents ground
-			net->is_ground = (net->name == "GND");
-			net->number    = brd_nail.probe;
+	// NOTE: brd_nail.side not handled here
+}
 
-			// NOTE: brd_nail.side not handled here
+void BRDBoard::beginPart(const BRDPart &brd_part) {
+	Pending &p = *pending_;
 
-			// so we can find nets later by name (making unique by name)
-			net_map[net->name] = net;
-		}
+	// is it some dummy component to indicate test pads?
+	if (has_prefix(brd_part.name, kComponentDummyName)) {
+		p.part_comp.push_back(dummy_component);
+		return;
 	}
 
-	// Populate parts
-	{
-		for (auto &brd_part : m_parts) {
-			auto comp = make_shared<Component>();
+	Component comp;
+
+	comp.name    = names_.name(names_.intern(brd_part.name));
+	comp.mfgcode = names_.name(names_.intern(brd_part.mfgcode.c_str(), brd_part.mfgcode.size()));
 
-			comp->name    = string(brd_part.name);
-			comp->mfgcode = std::move(brd_part.mfgcode);
+	comp.p1 = {brd_part.p1.x, brd_part.p1.y};
+	comp.p2 = {brd_part.p2.x, brd_part.p2.y};
 
-			comp->p1 = {brd_part.p1.x, brd_part.p1.y};
-			comp->p2 = {brd_part.p2.x, brd_part.p2.y};
+	// check what side the board is on (sorcery?)
+	if (brd_part.type < 8 && brd_part.type >= 4) {
+		comp.board_side = kBoardSideTop;
+	} else if (brd_part.type >= 8) {
+		comp.board_side = kBoardSideBottom;
+	} else {
+		comp.board_side = kBoardSideBoth; // ???
+	}
+
+	comp.mount_type = (brd_part.type & 0xc) ? Component::kMountTypeSMD : Component::kMountTypeDIP;
 
-			// is it some dummy component to indicate test pads?
-			if (is_prefix(kComponentDummyName, comp->name)) comp->component_type = Component::kComponentTypeDummy;
+	p.part_comp.push_back(p.comps.size());
+	p.comps.push_back(std::move(comp));
+}
+
+void BRDBoard::addPin(const BRDPin &brd_pin) {
+	// (originally from BoardView::DrawPins)
+	Pending &p = *pending_;
+	PendingPin pin;
+
+	// component is virtual, i.e. "...", pin is test pad
+	pin.component = p.part_comp[brd_pin.part - 1];
+	pin.type      = pin.component == dummy_component ? Pin::kPinTypeTestPad : Pin::kPinTypeComponent;
+
+	// determine pin number on part
+	++p.pin_idx;
+	if (brd_pin.part != p.part_idx) {
+		p.part_idx = brd_pin.part;
+		p.pin_idx  = 1;
+	}
+	if (brd_pin.snum) {
+		pin.number = names_.name(names_.intern(brd_pin.snum));
+	} else {
+		char number[16];
+		snprintf(number, sizeof(number), "%u", p.pin_idx);
+		pin.number = names_.name(names_.intern(number));
+	}
 
-			// check what side the board is on (sorcery?)
-			if (brd_part.type < 8 && brd_part.type >= 4) {
-				comp->board_side = kBoardSideTop;
-			} else if (brd_part.type >= 8) {
-				comp->board_side = kBoardSideBottom;
+	// copy position
+	pin.position = Point(brd_pin.pos.x, brd_pin.pos.y);
+
+	// set net reference (here's our NET key string again)
+	Symbol net_name = names_.find(brd_pin.net, strlen(brd_pin.net));
+	if (net_name < p.symbol_net.size() && p.symbol_net[net_name] != UINT32_MAX) {
+		// there is a net with that name already
+		pin.net = p.symbol_net[net_name];
+	} else {
+		// no net with that name registered, so create one
+		if (brd_pin.net[0]) {
+			if (has_prefix(brd_pin.net, kNetUnconnectedPrefix)) {
+				// pin is unconnected, so reference our special net
+				pin.net  = p.unconnected_net;
+				pin.type = Pin::kPinTypeNotConnected;
 			} else {
-				comp->board_side = kBoardSideBoth; // ???
+				// indeed a new net
+				pin.net = AddNet(names_.intern(brd_pin.net));
+				// NOTE: net->number not set
 			}
+		} else {
+			// not sure this can happen -> no info
+			// It does happen in .fz apparently and produces a SEGFAULT… Use
+			// unconnected net.
+			pin.net  = p.unconnected_net;
+			pin.type = Pin::kPinTypeNotConnected;
+		}
+	}
+
+	// TODO: should either depend on file specs or type etc
+	//
+	//  if(brd_pin.radius) pin->diameter = brd_pin.radius; // some format
+	//  (.fz) contains a radius field
+	//    else pin->diameter = 0.5f;
+	pin.diameter = brd_pin.radius; // some format (.fz) contains a radius field
+
+	p.pins.push_back(pin);
+}
+
+void BRDBoard::finish() {
+	// TODO: strip / trim all strings, especially those used as keys
+	Pending &p = *pending_;
 
-			comp->mount_type = (brd_part.type & 0xc) ? Component::kMountTypeSMD : Component::kMountTypeDIP;
+	// generate dummy component as reference
+	{
+		Component comp_dummy;
+		comp_dummy.name           = names_.name(names_.intern(kComponentDummyName.c_str()));
+		comp_dummy.component_type = Component::kComponentTypeDummy;
+		for (auto &pin : p.pins)
+			if (pin.component == dummy_component) pin.component = p.comps.size();
+		p.comps.push_back(std::move(comp_dummy));
+	}
 
-			components_.push_back(comp);
+	// Sort components by name
+	{
+		vector<uint32_t> order(p.comps.size());
+		for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+		stable_sort(begin(order), end(order), [&](uint32_t lhs, uint32_t rhs) { return p.comps[lhs].name < p.comps[rhs].name; });
+
+		vector<uint32_t> rank(p.comps.size());
+		component_store_.reserve(p.comps.size());
+		for (uint32_t i = 0; i < order.size(); i++) {
+			rank[order[i]] = i;
+			component_store_.push_back(std::move(p.comps[order[i]]));
 		}
+		for (auto &pin : p.pins) pin.component = rank[pin.component];
 	}
 
-	// Populate pins
+	// Populate Net vector (sorted by name)
 	{
-		// generate dummy component as reference
-		auto comp_dummy            = make_shared<Component>();
-		comp_dummy->name           = kComponentDummyName;
-		comp_dummy->component_type = Component::kComponentTypeDummy;
-
-		// NOTE: originally the pin diameter depended on part.name[0] == 'U' ?
-		unsigned int pin_idx  = 0;
-		unsigned int part_idx = 1;
-		auto pins             = m_pins;
-		auto parts            = m_parts;
-
-		for (size_t i = 0; i < pins.size(); i++) {
-			// (originally from BoardView::DrawPins)
-			const BRDPin &brd_pin = pins[i];
-			Component *comp       = components_[brd_pin.part - 1].get();
-
-			if (!comp) continue;
-
-			auto pin = make_shared<Pin>();
-
-			if (comp->is_dummy()) {
-				// component is virtual, i.e. "...", pin is test pad
-				pin->type      = Pin::kPinTypeTestPad;
-				pin->component = comp_dummy.get();
-				comp_dummy->pins.push_back(pin.get());
-			} else {
-				// component is regular / not virtual
-				pin->type      = Pin::kPinTypeComponent;
-				pin->component = comp;
-				comp->pins.push_back(pin.get());
-			}
+		vector<uint32_t> order(p.nets.size());
+		for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+		sort(begin(order), end(order), [&](uint32_t lhs, uint32_t rhs) { return p.nets[lhs].name < p.nets[rhs].name; });
+
+		vector<uint32_t> rank(p.nets.size());
+		net_store_.reserve(p.nets.size());
+		for (uint32_t i = 0; i < order.size(); i++) {
+			rank[order[i]] = i;
+			net_store_.push_back(std::move(p.nets[order[i]]));
+		}
+		for (auto &pin : p.pins) pin.net = rank[pin.net];
+	}
 
-			// determine pin number on part
-			++pin_idx;
-			if (brd_pin.part != part_idx) {
-				part_idx = brd_pin.part;
-				pin_idx  = 1;
-			}
-			if (brd_pin.snum)
-				pin->number = brd_pin.snum;
-			else
-				pin->number = std::to_string(pin_idx);
-
-			// copy position
-			pin->position = Point(brd_pin.pos.x, brd_pin.pos.y);
-
-			// set net reference (here's our NET key string again)
-			string net_name = string(brd_pin.net);
-			if (net_map.count(net_name)) {
-				// there is a net with that name in our map
-				pin->net = net_map[net_name].get();
-			} else {
-				// no net with that name registered, so create one
-				if (!net_name.empty()) {
-					if (is_prefix(kNetUnconnectedPrefix, net_name)) {
-						// pin is unconnected, so reference our special net
-						pin->net  = net_map[kNetUnconnectedPrefix].get();
-						pin->type = Pin::kPinTypeNotConnected;
-					} else {
-						// indeed a new net
-						auto net        = make_shared<Net>();
-						net->name       = net_name;
-						net->board_side = pin->board_side;
-						// NOTE: net->number not set
-						net_map[net_name] = net;
-						pin->net          = net.get();
-					}
-				} else {
-					// not sure this can happen -> no info
-					// It does happen in .fz apparently and produces a SEGFAULT… Use
-					// unconnected net.
-					pin->net  = net_map[kNetUnconnectedPrefix].get();
-					pin->type = Pin::kPinTypeNotConnected;
-				}
-			}
+	// Populate pins, grouped by component. Pins keep their file order within a component
+	{
+		component_first_pin_.assign(component_store_.size() + 1, 0);
+		for (auto &pin : p.pins) component_first_pin_[pin.component + 1]++;
+		for (size_t c = 0; c < component_store_.size(); c++) component_first_pin_[c + 1] += component_first_pin_[c];
+		vector<uint32_t> next_slot(component_first_pin_.begin(), component_first_pin_.end() - 1);
+
+		pin_store_.resize(p.pins.size());
+		for (auto &pending : p.pins) {
+			Pin &pin      = pin_store_[next_slot[pending.component]++];
+			pin.type      = pending.type;
+			pin.number    = pending.number;
+			pin.position  = pending.position;
+			pin.diameter  = pending.diameter;
+			pin.component = &component_store_[pending.component];
+			pin.net       = &net_store_[pending.net];
+		}
 
-			// TODO: should either depend on file specs or type etc
-			//
-			//  if(brd_pin.radius) pin->diameter = brd_pin.radius; // some format
-			//  (.fz) contains a radius field
-			//    else pin->diameter = 0.5f;
-			pin->diameter = brd_pin.radius; // some format (.fz) contains a radius field
+		// Pin lists of components and nets in file order, both in one array from the arena
+		Pin **component_pins = arena_.alloc<Pin *>(2 * pin_store_.size());
+		Pin **net_pins       = component_pins + pin_store_.size();
 
-			pin->net->pins.push_back(pin.get());
-			pins_.push_back(pin);
+		// Pins of a component are already stored in file order
+		for (size_t i = 0; i < pin_store_.size(); i++) component_pins[i] = &pin_store_[i];
+		for (size_t c = 0; c < component_store_.size(); c++) {
+			uint32_t first           = component_first_pin_[c];
+			component_store_[c].pins = Span<Pin *>(component_pins + first, component_first_pin_[c + 1] - first);
 		}
 
-		// remove all dummy components from vector, add our official dummy
-		components_.erase(
-		    remove_if(begin(components_), end(components_), [](shared_ptr<Component> &comp) { return comp->is_dummy(); }),
-		    end(components_));
-
-		components_.push_back(comp_dummy);
+		vector<uint32_t> net_first(net_store_.size() + 1, 0);
+		for (auto &pending : p.pins) net_first[pending.net + 1]++;
+		for (size_t n = 0; n < net_store_.size(); n++) net_first[n + 1] += net_first[n];
+		vector<uint32_t> next_net_pin(net_first.begin(), net_first.end() - 1);
+		for (size_t c = 0; c < component_store_.size(); c++) next_slot[c]  = component_first_pin_[c];
+		for (auto &pending : p.pins) net_pins[next_net_pin[pending.net]++] = &pin_store_[next_slot[pending.component]++];
+		for (size_t n = 0; n < net_store_.size(); n++)
+			net_store_[n].pins = Span<Pin *>(net_pins + net_first[n], net_first[n + 1] - net_first[n]);
 	}
-
-	// Populate Net vector by using the map. (sorted by keys)
-	for (auto &net : net_map) {
-		nets_.push_back(net.second);
+	pending_.reset();
+
+	// Hot fields in their own arrays
+	pin_table_.position.resize(pin_store_.size());
+	pin_table_.diameter.resize(pin_store_.size());
+	pin_table_.type.resize(pin_store_.size());
+	pin_table_.side.resize(pin_store_.size());
+	pin_table_.net.resize(pin_store_.size());
+	pin_table_.component.resize(pin_store_.size());
+	for (uint32_t i = 0; i < pin_store_.size(); i++) {
+		const Pin &pin          = pin_store_[i];
+		pin_table_.position[i]  = pin.position;
+		pin_table_.diameter[i]  = pin.diameter;
+		pin_table_.type[i]      = pin.type;
+		pin_table_.side[i]      = pin.component->board_side;
+		pin_table_.net[i]       = pin.net - net_store_.data();
+		pin_table_.component[i] = pin.component - component_store_.data();
 	}
 
-	// Sort components by name
-	sort(begin(components_), end(components_), [](shared_ptr<Component> &lhs, shared_ptr<Component> &rhs) {
-		return lhs->name < rhs->name;
-	});
+	// The shared vectors only alias the elements, copying them costs no reference counting
+	for (auto &net : net_store_) nets_.push_back(shared_ptr<Net>(shared_ptr<Net>(), &net));
+	for (auto &comp : component_store_) components_.push_back(shared_ptr<Component>(shared_ptr<Component>(), &comp));
+	for (auto &pin : pin_store_) pins_.push_back(shared_ptr<Pin>(shared_ptr<Pin>(), &pin));
+	for (auto &point : outline_store_) outline_.push_back(shared_ptr<Point>(shared_ptr<Point>(), &point));
 }
 
 BRDBoard::~BRDBoard() {}
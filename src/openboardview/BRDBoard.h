@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Board.h"
+#include "FileFormats/BoardBuilder.h"
 
 #include <memory>
 #include <string.h>
@@ -8,12 +9,24 @@
 
 using namespace std;
 
-class BRDBoard : public Board {
+/*
+ * Board built from BRDFile records. Either construct it from a parsed file,
+ * or default-construct it, stream the board through the BoardBuilder calls
+ * and finish() it before use.
+ */
+class BRDBoard : public Board, public BoardBuilder {
   public:
+	BRDBoard();
 	BRDBoard(const BRDFile *const boardFile);
 	~BRDBoard();
 
-	const BRDFile *m_file;
+	void beginPart(const BRDPart &part);
+	void addPin(const BRDPin &pin);
+	void addNail(const BRDNail &nail);
+	void addOutlinePoint(const BRDPoint &point);
+
+	// Lays out the elements received so far, nothing may be added afterwards
+	void finish();
 
 	EBoardType BoardType();
 
@@ -26,6 +39,12 @@ class BRDBoard : public Board {
 	static const string kNetUnconnectedPrefix;
 	static const string kComponentDummyName;
 
+	struct PendingPin;
+	struct Pending;
+	unique_ptr<Pending> pending_; // Only while building
+
+	uint32_t AddNet(Symbol name);
+
 	SharedVector<Net> nets_;
 	SharedVector<Component> components_;
 	SharedVector<Pin> pins_;
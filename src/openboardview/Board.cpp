@@ -0,0 +1,63 @@
+#include "Board.h"
+
+#include <cmath>
+
+void Board::IndexElements() {
+	std::vector<GridBox> boxes;
+
+	boxes.reserve(pin_table_.position.size());
+	max_pin_diameter_ = 0;
+	for (size_t i = 0; i < pin_table_.position.size(); i++) {
+		const Point &p = pin_table_.position[i];
+		boxes.push_back(GridBox{p.x, p.y, p.x, p.y});
+		max_pin_diameter_ = std::max(max_pin_diameter_, pin_table_.diameter[i]);
+	}
+	pin_grid_.Build(boxes);
+
+	// Parts without an outline are left out, bar the pinless ones drawn as a box from p1 to p2
+	boxes.clear();
+	for (auto &part : component_store_) {
+		GridBox box = {1, 1, 0, 0}; // Empty
+		if (!part.is_dummy() && part.pins.size() == 0) {
+			box = GridBox{std::min(part.p1.x, part.p2.x), std::min(part.p1.y, part.p2.y), std::max(part.p1.x, part.p2.x),
+			              std::max(part.p1.y, part.p2.y)};
+		} else if (part.outline_done) {
+			box = GridBox{INFINITY, INFINITY, -INFINITY, -INFINITY};
+			for (auto &pt : part.outline) {
+				box.min_x = std::min(box.min_x, float(pt.x));
+				box.min_y = std::min(box.min_y, float(pt.y));
+				box.max_x = std::max(box.max_x, float(pt.x));
+				box.max_y = std::max(box.max_y, float(pt.y));
+			}
+		}
+		boxes.push_back(box);
+	}
+	part_grid_.Build(boxes);
+
+	size_t nets = net_store_.size();
+	net_table_.bounds.assign(nets, GridBox{INFINITY, INFINITY, -INFINITY, -INFINITY});
+	net_table_.centroid.assign(nets, Point());
+	net_table_.pin_count.assign(nets, 0);
+	net_table_.top_pins.assign(nets, 0);
+	net_table_.bottom_pins.assign(nets, 0);
+	std::vector<double> sum_x(nets), sum_y(nets); // Floats lose whole units summing a large net
+	for (size_t i = 0; i < pin_table_.position.size(); i++) {
+		uint32_t n     = pin_table_.net[i];
+		const Point &p = pin_table_.position[i];
+		GridBox &box   = net_table_.bounds[n];
+		box.min_x      = std::min(box.min_x, p.x);
+		box.min_y      = std::min(box.min_y, p.y);
+		box.max_x      = std::max(box.max_x, p.x);
+		box.max_y      = std::max(box.max_y, p.y);
+		sum_x[n] += p.x;
+		sum_y[n] += p.y;
+		net_table_.pin_count[n]++;
+		if (pin_table_.side[i] == kBoardSideTop) net_table_.top_pins[n]++;
+		if (pin_table_.side[i] == kBoardSideBottom) net_table_.bottom_pins[n]++;
+	}
+	for (size_t n = 0; n < nets; n++) {
+		if (net_table_.pin_count[n] == 0) continue;
+		net_table_.centroid[n].x = sum_x[n] / net_table_.pin_count[n];
+		net_table_.centroid[n].y = sum_y[n] / net_table_.pin_count[n];
+	}
+}
@@ -1,12 +1,15 @@
 #pragma once
 
 #include "FileFormats/BRDFile.h"
+#include "SpatialGrid.h"
+#include "StringPool.h"
 
 #include "imgui/imgui.h"
 #include <algorithm>
 #include <functional>
 #include <map>
 #include <memory>
+#include <stdint.h>
 #include <string>
 #include <vector>
 
@@ -33,6 +36,33 @@ using SharedVector = vector<shared_ptr<T>>;
 template <class T>
 using SharedStringMap = map<string, shared_ptr<T>>;
 
+// Non-owning view of contiguous elements
+template <class T>
+class Span {
+  public:
+	Span() {}
+	Span(T *first, size_t count)
+	    : m_first(first)
+	    , m_count(count) {}
+
+	T *begin() const {
+		return m_first;
+	}
+	T *end() const {
+		return m_first + m_count;
+	}
+	size_t size() const {
+		return m_count;
+	}
+	T &operator[](size_t i) const {
+		return m_first[i];
+	}
+
+  private:
+	T *m_first     = nullptr;
+	size_t m_count = 0;
+};
+
 enum EBoardSide {
 	kBoardSideTop    = 0,
 	kBoardSideBottom = 1,
@@ -100,13 +130,13 @@ struct Point {
 // Shared potential between multiple Pins/Contacts.
 struct Net : BoardElement {
 	int number;
-	string name;
+	Name name;
 	bool is_ground;
 
-	vector<Pin *> pins;
+	Span<Pin *> pins; // In the board's arena
 
 	string UniqueId() const {
-		return kBoardNetPrefix + name;
+		return string(kBoardNetPrefix) + name.c_str();
 	}
 };
 
@@ -129,7 +159,7 @@ struct Pin : BoardElement {
 	EPinType type;
 
 	// Pin number / Nail count.
-	string number;
+	Name number;
 
 	// Position according to board file. (probably in inches)
 	Point position;
@@ -144,7 +174,7 @@ struct Pin : BoardElement {
 	Component *component;
 
 	string UniqueId() const {
-		return kBoardPinPrefix + number;
+		return string(kBoardPinPrefix) + number.c_str();
 	}
 };
 
@@ -172,13 +202,13 @@ struct Component : BoardElement {
 	EComponentType component_type = kComponentTypeUnknown;
 
 	// Part name as stored in board file.
-	string name;
+	Name name;
 
 	// Part manufacturing code (aka. part number).
-	string mfgcode;
+	Name mfgcode;
 
 	// Pins belonging to this component.
-	vector<Pin *> pins;
+	Span<Pin *> pins; // In the board's arena
 
 	// Post calculated outlines
 	//
@@ -186,7 +216,7 @@ struct Component : BoardElement {
 	Point p1{0.0f, 0.0f}, p2{0.0f, 0.0f}; // for debugging
 
 	bool outline_done = false;
-	outline_pt *hull  = NULL;
+	outline_pt *hull  = NULL; // In the board's arena
 	int hull_count    = 0;
 	outline_pt centerpoint;
 	double expanse = 0.0f; // quick measure of distance between pins.
@@ -211,10 +241,38 @@ struct Component : BoardElement {
 	}
 
 	string UniqueId() const {
-		return kBoardComponentPrefix + name;
+		return string(kBoardComponentPrefix) + name.c_str();
 	}
 };
 
+/*
+ * The pin fields every frame goes through, as parallel arrays indexed like
+ * Board::PinSpan(). Loops that only test positions or sides stay in a few
+ * dense arrays instead of visiting each Pin.
+ */
+struct PinTable {
+	vector<Point> position;
+	vector<float> diameter;
+	vector<uint8_t> type;       // Pin::EPinType
+	vector<uint8_t> side;       // EBoardSide of the pin's component
+	vector<uint32_t> net;       // Index in Board::NetSpan()
+	vector<uint32_t> component; // Index in Board::ComponentSpan()
+};
+
+/*
+ * What net operations need to know about each net, worked out from its pins
+ * and indexed like Board::NetSpan(); the pins themselves are Net::pins. Lets
+ * the net web, zooming to a net and the info pane cost the size of the net
+ * rather than of the board.
+ */
+struct NetTable {
+	vector<GridBox> bounds;       // Of the pin positions, empty for a net without pins
+	vector<Point> centroid;       // Mean pin position
+	vector<uint32_t> pin_count;
+	vector<uint32_t> top_pins;    // Pins of parts on the top side
+	vector<uint32_t> bottom_pins; // and on the bottom, the rest are on both
+};
+
 class Board {
   public:
 	enum EBoardType { kBoardTypeUnknown = 0, kBoardTypeBRD = 0x01, kBoardTypeBDV = 0x02 };
@@ -229,4 +287,94 @@ class Board {
 	EBoardType BoardType() {
 		return kBoardTypeUnknown;
 	}
+
+	/*
+	 * Elements live in contiguous arrays, the vectors above only alias them.
+	 * Pins are grouped by component, in file order within each component.
+	 */
+	Span<Pin> PinSpan() {
+		return Span<Pin>(pin_store_.data(), pin_store_.size());
+	}
+	Span<Component> ComponentSpan() {
+		return Span<Component>(component_store_.data(), component_store_.size());
+	}
+	Span<Net> NetSpan() {
+		return Span<Net>(net_store_.data(), net_store_.size());
+	}
+	const PinTable &PinData() const {
+		return pin_table_;
+	}
+
+	// Part and net names and pin numbers
+	const StringPool &Names() const {
+		return names_;
+	}
+
+	// Pins of the component at index component in ComponentSpan()
+	Span<Pin> ComponentPins(uint32_t component) {
+		uint32_t first = component_first_pin_[component];
+		return Span<Pin>(pin_store_.data() + first, component_first_pin_[component + 1] - first);
+	}
+
+	uint32_t PinIndex(const Pin *pin) const {
+		return static_cast<uint32_t>(pin - pin_store_.data());
+	}
+	uint32_t NetIndex(const Net *net) const {
+		return static_cast<uint32_t>(net - net_store_.data());
+	}
+
+	/*
+	 * Memory that lives as long as the board, for anything derived from it
+	 * (hulls...). Apart from the element arrays, everything a board owns comes
+	 * from here, so deleting a board is a handful of frees.
+	 */
+	Arena &Memory() {
+		return arena_;
+	}
+
+	/*
+	 * Grids of the pins by position and of the parts by outline, for finding
+	 * what is at a point or in view, and the NetTable. Built by IndexElements()
+	 * from the current positions, outlines and pin sizes, which has to run
+	 * again when they change.
+	 */
+	void IndexElements();
+	const NetTable &NetData() const {
+		return net_table_;
+	}
+	const SpatialGrid &PinGrid() const {
+		return pin_grid_;
+	}
+	const SpatialGrid &PartGrid() const {
+		return part_grid_;
+	}
+
+	// Largest pin diameter as of IndexElements(), how far around a point to look for pins
+	float MaxPinDiameter() const {
+		return max_pin_diameter_;
+	}
+
+	// Pin fields mirrored in the PinTable must only be changed through these
+	void SetPinDiameter(Pin *pin, float diameter) {
+		pin->diameter                      = diameter;
+		pin_table_.diameter[PinIndex(pin)] = diameter;
+	}
+	void SetPinPosition(Pin *pin, Point position) {
+		pin->position                      = position;
+		pin_table_.position[PinIndex(pin)] = position;
+	}
+
+  protected:
+	vector<Pin> pin_store_;
+	vector<Component> component_store_;
+	vector<Net> net_store_;
+	vector<Point> outline_store_;
+	vector<uint32_t> component_first_pin_; // Pins of component c are [first[c], first[c + 1])
+	PinTable pin_table_;
+	SpatialGrid pin_grid_;
+	SpatialGrid part_grid_;
+	NetTable net_table_;
+	float max_pin_diameter_ = 0;
+	Arena arena_;
+	StringPool names_{arena_};
 };
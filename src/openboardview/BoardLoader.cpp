@@ -0,0 +1,167 @@
+#include "platform.h" // Should be kept first
+#include "BoardLoader.h"
+
+#include "BRDBoard.h"
+#include "BoardView.h"
+#include "FileFormats/ASCFile.h"
+#include "FileFormats/BDVFile.h"
+#include "FileFormats/BRD2File.h"
+#include "FileFormats/BRDFile.h"
+#include "FileFormats/BVRFile.h"
+#include "FileFormats/BoardCache.h"
+#include "FileFormats/FZFile.h"
+#include "FileFormats/FormatSniffer.h"
+#include "PartAnalysis.h"
+#include "mappedfile.h"
+#include "utils.h"
+#include <fstream>
+#include <string.h>
+
+BoardLoadJob::~BoardLoadJob() {
+	delete board;
+}
+
+BoardLoader::~BoardLoader() {
+	Cancel();
+	Reap(true);
+}
+
+void BoardLoader::Start(const std::string &filename, const uint32_t *fz_key, float pin_diameter, bool use_cache, bool debug) {
+	Cancel();
+
+	m_current               = std::unique_ptr<BoardLoadJob>(new BoardLoadJob);
+	m_current->filename     = filename;
+	m_current->pin_diameter = pin_diameter;
+	m_current->use_cache    = use_cache;
+	m_current->debug        = debug;
+	memcpy(m_current->fz_key, fz_key, sizeof(m_current->fz_key));
+	m_current->status.entered[0] = std::chrono::steady_clock::now();
+
+	m_thread = std::thread(Run, m_current.get());
+}
+
+void BoardLoader::Cancel() {
+	if (!m_current) return;
+	m_current->status.cancelled = true;
+	m_cancelled.push_back(Worker{std::move(m_current), std::move(m_thread)});
+}
+
+std::unique_ptr<BoardLoadJob> BoardLoader::TakeFinished() {
+	Reap(false);
+	if (!m_current || m_current->status.Stage() != LoadStage::Done) return nullptr;
+	m_thread.join();
+	return std::move(m_current);
+}
+
+// Joins the threads of cancelled jobs that are done, or of all of them if wait is set
+void BoardLoader::Reap(bool wait) {
+	for (auto it = m_cancelled.begin(); it != m_cancelled.end();) {
+		if (wait || it->job->status.Stage() == LoadStage::Done) {
+			it->thread.join();
+			it = m_cancelled.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void BoardLoader::Run(BoardLoadJob *job) {
+	LoadStatus &status          = job->status;
+	const std::string &filename = job->filename;
+	thread_load_status()        = &status;
+
+	// Parsers decode and terminate strings in place, the mapping keeps those writes private
+	MappedFile mapping(filename, MappedFile::Mode::CopyOnWrite);
+	BRDFile *file          = nullptr;
+	BoardCacheFile *cached = nullptr; // file, when it came from a snapshot
+	BRDBoard *streamed     = nullptr; // Board the parser builds as it goes, when no snapshot needs the file's records
+	bool cacheable         = false;
+	uint64_t source_hash   = 0;
+	uint64_t source_size   = mapping.size();
+	std::string cache_path;
+
+	if (!mapping.empty() && !status.cancelled) {
+		/*
+		 * A snapshot of the parsed board is kept in the cache dir, named after
+		 * the hash of the file (and FZ key, which changes what it decodes to).
+		 * ASC boards are spread over several files and are not cached.
+		 */
+		bool is_fz = check_fileext(filename, ".fz");
+		cacheable  = job->use_cache && !check_fileext(filename, ".bom") && !check_fileext(filename, ".asc");
+		if (cacheable) {
+			uint64_t seed = is_fz ? content_hash(reinterpret_cast<const char *>(job->fz_key), sizeof(job->fz_key)) : 0;
+			source_hash   = content_hash(mapping.data(), mapping.size(), seed);
+			cache_path    = get_user_dir(UserDir::Cache) + BoardCacheFile::filename(source_hash);
+			if (std::ifstream(cache_path).good()) {
+				cached = new BoardCacheFile(MappedFile(cache_path), source_hash, source_size);
+				if (cached->valid) {
+					file = cached;
+				} else { // Stale or damaged, parse again and replace it
+					delete cached;
+					cached = nullptr;
+				}
+			}
+		}
+
+		if (!file) {
+			status.Enter(LoadStage::Decode); // Parsers move on to Parse themselves
+			if (!cacheable) streamed = new BRDBoard();
+
+			if (is_fz) { // Since it is encrypted we cannot use the below logic. Trust the ext.
+				file = new FZFile(std::move(mapping), job->fz_key, streamed);
+			} else if (check_fileext(filename, ".bom") || check_fileext(filename, ".asc"))
+				file = new ASCFile(filename);
+			else {
+				switch (sniff_format(mapping.data(), mapping.size()).format) {
+					case BoardFormat::BRD: file  = new BRDFile(std::move(mapping), streamed); break;
+					case BoardFormat::BRD2: file = new BRD2File(std::move(mapping)); break;
+					case BoardFormat::BDV: file  = new BDVFile(std::move(mapping), streamed); break;
+					case BoardFormat::BVR: file  = new BVRFile(std::move(mapping)); break;
+					case BoardFormat::Unknown: break;
+				}
+			}
+		}
+	}
+
+	if (file && file->valid && !status.cancelled) {
+		status.Enter(LoadStage::Build);
+		Board *board;
+		if (file->streamed) { // Only lays out what the parser already gave it
+			streamed->finish();
+			board    = streamed;
+			streamed = nullptr;
+		} else {
+			board = new BRDBoard(file);
+		}
+
+		status.Enter(LoadStage::Analyse);
+		BoardView::EPCCheck(board, job->debug); // check to see we don't have a flipped board outline
+
+		// A snapshot has the analysis of the board built from it, unless it was done with another pin size
+		if (!cached || !cached->RestoreAnalysis(*board, job->pin_diameter)) {
+			/*
+			 * Set pins to a known lower size, the ones of recognised
+			 * footprints get resized when the parts are analysed
+			 */
+			for (auto &pin : board->PinSpan()) board->SetPinDiameter(&pin, 7);
+			AnalyseParts(board, job->pin_diameter);
+
+			// Written once the board is analysed, the snapshot holds the result along with the file
+			if (cacheable && !status.cancelled)
+				BoardCacheFile::write(*file, *board, job->pin_diameter, source_hash, source_size, cache_path);
+		}
+		board->IndexElements();
+
+		// The board no longer refers to the file, its buffers and mapping can go
+		job->resident_with_file = get_resident_memory();
+		delete file;
+		file          = nullptr;
+		job->resident = get_resident_memory();
+		job->board    = board;
+	}
+	delete file;
+	delete streamed;
+
+	thread_load_status() = nullptr;
+	status.Enter(LoadStage::Done); // Publishes file and board to the UI thread
+}
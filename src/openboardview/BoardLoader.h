@@ -0,0 +1,76 @@
+#pragma once
+
+#include "FileFormats/LoadStatus.h"
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Board;
+
+// A board file being read on a background thread, and what came out of it
+struct BoardLoadJob {
+	std::string filename;
+	uint32_t fz_key[44];
+	float pin_diameter = 20; // Default pin size when analysing parts
+	bool use_cache     = true;
+	bool debug         = false;
+
+	LoadStatus status;
+
+	// Set once status reaches Done, owned by the job until taken
+	Board *board = nullptr;
+
+	// Resident memory once the board is built, with and without the parsed file
+	size_t resident_with_file = 0;
+	size_t resident           = 0;
+
+	~BoardLoadJob();
+};
+
+/*
+ * Loads boards off the UI thread: reading, decoding, parsing, building the
+ * Board and analysing it all happen on a worker, the UI only picks up the
+ * result once it is complete. The Board has everything the UI needs, the
+ * parsed file is freed on the worker as soon as the board is built.
+ *
+ * Starting a new load cancels the current one. Parsers cannot be interrupted
+ * anywhere, so a cancelled job may run on for a while; it is set aside and
+ * its thread joined once it has finished.
+ */
+class BoardLoader {
+  public:
+	BoardLoader() = default;
+	~BoardLoader();
+	BoardLoader(const BoardLoader &) = delete;
+	BoardLoader &operator=(const BoardLoader &) = delete;
+
+	void Start(const std::string &filename, const uint32_t *fz_key, float pin_diameter, bool use_cache, bool debug);
+	void Cancel();
+
+	bool Busy() const {
+		return m_current != nullptr;
+	}
+
+	// Job in progress, nullptr if none
+	const BoardLoadJob *Current() const {
+		return m_current.get();
+	}
+
+	// Hands over the current job once it is done, nullptr while it still runs
+	std::unique_ptr<BoardLoadJob> TakeFinished();
+
+  private:
+	struct Worker {
+		std::unique_ptr<BoardLoadJob> job;
+		std::thread thread;
+	};
+
+	static void Run(BoardLoadJob *job);
+	void Reap(bool wait);
+
+	std::unique_ptr<BoardLoadJob> m_current;
+	std::thread m_thread;
+	std::vector<Worker> m_cancelled; // Cancelled jobs still running
+};
@@ -0,0 +1,166 @@
+#include "BoardMesh.h"
+
+#include <cmath>
+
+BoardMesh::BoardMesh() {
+	for (uint8_t m = 0; m < BoardVertex::kMaskCount; m++) SetMask(m, 0xFFFFFFFF, 0x00000000);
+}
+
+void BoardMesh::SetMask(uint8_t m, uint32_t and_mask, uint32_t or_mask) {
+	for (int i = 0; i < 4; i++) {
+		and_masks[m][i] = (and_mask >> (i * 8)) & 0xff;
+		or_masks[m][i]  = (or_mask >> (i * 8)) & 0xff;
+	}
+}
+
+void BoardMesh::Clear() {
+	static uint32_t last_generation = 0;
+
+	vertices.clear();
+	generation = ++last_generation;
+	mask       = BoardVertex::kMaskNone;
+}
+
+void BoardMesh::Quad(const BoardVertex corners[4]) {
+	vertices.push_back(corners[0]);
+	vertices.push_back(corners[1]);
+	vertices.push_back(corners[2]);
+	vertices.push_back(corners[0]);
+	vertices.push_back(corners[2]);
+	vertices.push_back(corners[3]);
+}
+
+void BoardMesh::AddLine(ImVec2 a, ImVec2 b, uint32_t col) {
+	float dx = b.x - a.x, dy = b.y - a.y;
+	float length = sqrtf(dx * dx + dy * dy);
+	if (!(length > 0)) return;
+
+	// Across the line, a pixel either side once on screen
+	int8_t nx = roundf(-dy / length * 127), ny = roundf(dx / length * 127);
+	BoardVertex corners[4] = {
+	    {a.x, a.y, 0, nx, ny, BoardVertex::kShapeSolid, mask, col},
+	    {b.x, b.y, 0, nx, ny, BoardVertex::kShapeSolid, mask, col},
+	    {b.x, b.y, 0, int8_t(-nx), int8_t(-ny), BoardVertex::kShapeSolid, mask, col},
+	    {a.x, a.y, 0, int8_t(-nx), int8_t(-ny), BoardVertex::kShapeSolid, mask, col},
+	};
+	Quad(corners);
+}
+
+void BoardMesh::AddPolyline(const ImVec2 *points, int count, uint32_t col, bool closed) {
+	for (int i = 0; i + 1 < count; i++) AddLine(points[i], points[i + 1], col);
+	if (closed && count > 2) AddLine(points[count - 1], points[0], col);
+}
+
+void BoardMesh::AddQuadFilled(const ImVec2 quad[4], uint32_t col) {
+	BoardVertex corners[4];
+	for (int i = 0; i < 4; i++) corners[i] = BoardVertex{quad[i].x, quad[i].y, 0, 0, 0, BoardVertex::kShapeSolid, mask, col};
+	Quad(corners);
+}
+
+void BoardMesh::AddCircle(ImVec2 centre, float radius, uint32_t col, int segments) {
+	std::vector<ImVec2> points(segments);
+	for (int i = 0; i < segments; i++) {
+		float a   = 2 * 3.14159265358979f * i / segments;
+		points[i] = ImVec2(centre.x + radius * cosf(a), centre.y + radius * sinf(a));
+	}
+	AddPolyline(points.data(), segments, col, true);
+}
+
+void BoardMesh::AddPin(ImVec2 centre, float diameter, uint32_t col, uint8_t shape) {
+	BoardVertex corners[4] = {
+	    {centre.x, centre.y, diameter, -127, -127, shape, mask, col},
+	    {centre.x, centre.y, diameter, 127, -127, shape, mask, col},
+	    {centre.x, centre.y, diameter, 127, 127, shape, mask, col},
+	    {centre.x, centre.y, diameter, -127, 127, shape, mask, col},
+	};
+	Quad(corners);
+}
+
+const char *BoardMesh::vertex_shader =
+    "attribute vec2 Position;\n"
+    "attribute float Size;\n"
+    "attribute vec2 Direction;\n"
+    "attribute float Shape;\n"
+    "attribute vec4 Color;\n"
+    "attribute float Mask;\n"
+    "uniform vec2 Origin;\n"
+    "uniform vec2 AxisX;\n"
+    "uniform vec2 AxisY;\n"
+    "uniform vec2 Display;\n"
+    "uniform float Scale;\n"
+    "uniform float MinSize;\n"
+    "uniform vec4 AndMask[4];\n"
+    "uniform vec4 OrMask[4];\n"
+    "uniform float LineWidth;\n"
+    "uniform float Pad;\n"
+    "uniform float Stripes;\n"
+    "varying vec2 Frag_Local;\n"
+    "varying float Frag_Radius;\n"
+    "varying float Frag_Shape;\n"
+    "varying vec4 Frag_Color;\n"
+    "varying float Frag_Width;\n"
+    "varying float Frag_Stripe;\n"
+    "varying float Frag_Stripes;\n"
+    // GLSL ES 1.00 has no bitwise operators, so the bytes are masked a bit at a time
+    "vec4 Masked(vec4 color, vec4 and_mask, vec4 or_mask)\n"
+    "{\n"
+    "	vec4 bytes = floor(color * 255.0 + 0.5);\n"
+    "	vec4 result = vec4(0.0);\n"
+    "	float bit = 1.0;\n"
+    "	for (int i = 0; i < 8; i++) {\n"
+    "		vec4 c = mod(floor(bytes / bit), 2.0);\n"
+    "		vec4 a = mod(floor(and_mask / bit), 2.0);\n"
+    "		vec4 o = mod(floor(or_mask / bit), 2.0);\n"
+    "		result += bit * max(c * a, o);\n"
+    "		bit *= 2.0;\n"
+    "	}\n"
+    "	return result / 255.0;\n"
+    "}\n"
+    "void main()\n"
+    "{\n"
+    // Pins are drawn with their diameter as radius like DrawPins(), reaching further for the outline
+    "	float radius = Size * Scale + Pad;\n"
+    "	float reach = Size > 0.0 ? radius + LineWidth * 0.5 + 1.5 : LineWidth * 0.5 + 0.5;\n"
+    "	vec2 offset = (AxisX * Direction.x + AxisY * Direction.y) * (reach / Scale);\n"
+    "	vec2 screen = Origin + AxisX * Position.x + AxisY * Position.y + offset;\n"
+    "	Frag_Local = Direction * reach;\n"
+    "	Frag_Radius = radius;\n"
+    "	Frag_Shape = Shape;\n"
+    "	Frag_Width = LineWidth * 0.5 - 0.5;\n" // Beyond the pixel any line has
+    "	Frag_Stripe = Position.y * Scale / max(Stripes, 1.0);\n"
+    "	Frag_Stripes = Stripes;\n"
+    "	int m = int(Mask + 0.5);\n"
+    "	Frag_Color = Masked(Color, AndMask[m], OrMask[m]);\n"
+    "	gl_Position = vec4(screen.x * 2.0 / Display.x - 1.0, 1.0 - screen.y * 2.0 / Display.y, 0.0, 1.0);\n"
+    "	if (Size > 0.0 && Size * Scale < MinSize) gl_Position = vec4(2.0, 2.0, 2.0, 1.0);\n" // Out of the clip volume
+    "}\n";
+
+// Coverage falls off over a pixel from each shape's edge or line centre, fills cut into lines when striped
+const char *BoardMesh::fragment_shader =
+    "varying vec2 Frag_Local;\n"
+    "varying float Frag_Radius;\n"
+    "varying float Frag_Shape;\n"
+    "varying vec4 Frag_Color;\n"
+    "varying float Frag_Width;\n"
+    "varying float Frag_Stripe;\n"
+    "varying float Frag_Stripes;\n"
+    "void main()\n"
+    "{\n"
+    "	float d;\n"
+    "	if (Frag_Shape < 0.5)\n"
+    "		d = length(Frag_Local);\n"
+    "	else if (Frag_Shape < 1.5)\n"
+    "		d = abs(length(Frag_Local) - Frag_Radius);\n"
+    "	else if (Frag_Shape < 2.5)\n"
+    "		d = abs(max(abs(Frag_Local.x), abs(Frag_Local.y)) - Frag_Radius * 0.5 - 0.5);\n"
+    "	else\n"
+    "		d = max(length(Frag_Local) - Frag_Radius, 0.0);\n"
+    "	if (Frag_Shape < 2.5) d = max(d - Frag_Width, 0.0);\n"
+    "	if (Frag_Stripes > 0.0) {\n"
+    "		float t = fract(Frag_Stripe) * Frag_Stripes;\n"
+    "		d = max(d, min(t, Frag_Stripes - t));\n"
+    "	}\n"
+    "	float alpha = clamp(1.0 - d, 0.0, 1.0);\n"
+    "	if (alpha <= 0.0) discard;\n"
+    "	FRAG_COLOR = vec4(Frag_Color.rgb, Frag_Color.a * alpha);\n"
+    "}\n";
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "imgui/imgui.h"
+#include <stdint.h>
+#include <vector>
+
+/*
+ * One corner of the quads board geometry is made of, in board coordinates so
+ * the same vertices serve any view. Lines are stretched a pixel either side of
+ * their centre along dx, dy; pins are squares stretched from their centre to
+ * the corners dx, dy, the shader cutting the shape out and scaling them with
+ * the zoom like DrawPins() does.
+ */
+struct BoardVertex {
+	enum Shape { kShapeSolid = 0, kShapeCircle, kShapeSquare, kShapeDisc };
+	enum Mask { kMaskNone = 0, kMaskOutline, kMaskParts, kMaskPins, kMaskCount };
+
+	float x, y;
+	float size;    // Pin diameter, 0 for lines and fills
+	int8_t dx, dy; // Direction on the board, over 127, off x, y
+	uint8_t shape; // Shape
+	uint8_t mask;  // Mask, which of the selection masks its colour goes through
+	uint32_t col;
+};
+
+/*
+ * Board geometry tessellated once, kept by the GL3 and GLES2 renderers in a
+ * vertex buffer and drawn with the view as a transform, so moving about costs
+ * one draw call and no tessellation whatever the size of the board.
+ *
+ * Vertices are plain triangle lists, GLES2 may not have 32 bit indices.
+ * Renderers upload them again when generation changes.
+ */
+class BoardMesh {
+  public:
+	BoardMesh();
+
+	// Starts a new mesh with its own generation
+	void Clear();
+
+	void AddLine(ImVec2 a, ImVec2 b, uint32_t col);
+	void AddPolyline(const ImVec2 *points, int count, uint32_t col, bool closed);
+	void AddQuadFilled(const ImVec2 quad[4], uint32_t col);
+	void AddCircle(ImVec2 centre, float radius, uint32_t col, int segments);
+
+	// A pin of the given diameter on the board, shape is BoardVertex::Shape
+	void AddPin(ImVec2 centre, float diameter, uint32_t col, uint8_t shape);
+
+	uint32_t size() const {
+		return vertices.size();
+	}
+
+	std::vector<BoardVertex> vertices;
+	uint32_t generation = 0;
+
+	// Mask of the vertices added from now on, BoardVertex::Mask
+	uint8_t mask = BoardVertex::kMaskNone;
+
+	/*
+	 * The view, set before each redraw: a board point x, y is at
+	 * origin + axis_x * x + axis_y * y on screen, axes scale pixels long.
+	 * Pins whose diameter comes to less than min_size pixels are left out,
+	 * like those under the size threshold in DrawPins().
+	 */
+	ImVec2 origin, axis_x, axis_y;
+	float scale    = 1;
+	float min_size = 0;
+
+	/*
+	 * Colours of the vertices with mask m come out as (col & and_mask) | or_mask
+	 * like those of a selection in DrawPins(), the shader doing it on each
+	 * channel's bits so masking does not change the vertices. Kept as the
+	 * bytes of each colour for the uniforms.
+	 */
+	void SetMask(uint8_t m, uint32_t and_mask, uint32_t or_mask);
+	float and_masks[BoardVertex::kMaskCount][4];
+	float or_masks[BoardVertex::kMaskCount][4];
+
+	// GLSL ES 1.00 shaders drawing the mesh; renderers put their version, precision and
+	// a FRAG_COLOR define for the output in front
+	static const char *vertex_shader;
+	static const char *fragment_shader;
+
+  private:
+	void Quad(const BoardVertex corners[4]);
+};
+
+/*
+ * Part of a mesh to draw, the UserCallbackData of the renderer's ImDrawCallback.
+ * Its lines and the outlines of its pins are line_width pixels wide, its pins
+ * reach pad pixels further than their diameter, and its fills come out as
+ * lines stripes pixels apart along the board's y unless that is 0.
+ */
+struct BoardMeshRange {
+	const BoardMesh *mesh = nullptr;
+	uint32_t first        = 0;
+	uint32_t count        = 0;
+	float line_width      = 1;
+	float pad             = 0;
+	float stripes         = 0;
+};
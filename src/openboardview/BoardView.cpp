@@ -4,6 +4,7 @@
 #include "utf8/utf8.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <limits.h>
@@ -19,12 +20,7 @@
 
 #include "BRDBoard.h"
 #include "Board.h"
-#include "FileFormats/ASCFile.h"
-#include "FileFormats/BDVFile.h"
-#include "FileFormats/BRD2File.h"
 #include "FileFormats/BRDFile.h"
-#include "FileFormats/BVRFile.h"
-#include "FileFormats/FZFile.h"
 #include "annotations.h"
 #include "imgui/imgui.h"
 
@@ -45,14 +41,6 @@ using namespace std::placeholders;
 
 BoardView::~BoardView() {
 	if (m_validBoard) {
-		for (auto &p : m_board->Components()) {
-			if (p->hull) free(p->hull);
-		}
-		m_board->Nets().clear();
-		m_board->Pins().clear();
-		m_board->Components().clear();
-		m_board->OutlinePoints().clear();
-		delete m_file;
 		delete m_board;
 		m_annotations.Close();
 		m_validBoard = false;
@@ -265,6 +253,7 @@ int BoardView::ConfigParse(void) {
 	fillParts                 = obvconfig.ParseBool("fillParts", true);
 	m_centerZoomSearchResults = obvconfig.ParseBool("centerZoomSearchResults", true);
 	flipMode                  = obvconfig.ParseInt("flipMode", 0);
+	boardCache                = obvconfig.ParseBool("boardCache", true);
 
 	boardFill        = obvconfig.ParseBool("boardFill", true);
 	boardFillSpacing = obvconfig.ParseInt("boardFillSpacing", 3);
@@ -406,78 +395,94 @@ int BoardView::ConfigParse(void) {
 }
 
 int BoardView::LoadFile(const std::string &filename) {
-	m_lastFileOpenWasInvalid = true;
-	m_validBoard             = false;
-	if (!filename.empty()) {
-		// clean up the previous file.
-		if (m_file && m_board) {
-			for (auto &p : m_board->Components()) {
-				if (p->hull) free(p->hull);
-			}
-			m_pinHighlighted.clear();
-			m_partHighlighted.clear();
-			m_annotations.Close();
-			m_board->Nets().clear();
-			m_board->Pins().clear();
-			m_board->Components().clear();
-			m_board->OutlinePoints().clear();
-			//	delete m_file;
-			// delete m_board;
-		}
+	if (filename.empty()) return 1;
 
-		SetLastFileOpenName(filename);
-		std::vector<char> buffer = file_as_buffer(filename);
-		if (!buffer.empty()) {
-			BRDFile *file = nullptr;
-
-			if (check_fileext(filename, ".fz")) { // Since it is encrypted we cannot use the below logic. Trust the ext.
-				file = new FZFile(buffer, FZKey);
-			} else if (check_fileext(filename, ".bom") || check_fileext(filename, ".asc"))
-				file = new ASCFile(buffer, filename);
-			else if (BRDFile::verifyFormat(buffer))
-				file = new BRDFile(buffer);
-			else if (BRD2File::verifyFormat(buffer))
-				file = new BRD2File(buffer);
-			else if (BDVFile::verifyFormat(buffer))
-				file = new BDVFile(buffer);
-			else if (BVRFile::verifyFormat(buffer))
-				file = new BVRFile(buffer);
-
-			if (file && file->valid) {
-				SetFile(file);
-				fhistory.Prepend_save(filename);
-				history_file_has_changed = 1; // used by main to know when to update the window title
-				boardMinMaxDone          = false;
-				m_rotation               = 0;
-				m_current_side           = 0;
-				EPCCheck(); // check to see we don't have a flipped board outline
-
-				m_annotations.SetFilename(filename);
-				m_annotations.Load();
+	// Read on a worker, the current board stays up until FinishLoad() replaces it
+	m_loader.Start(filename, FZKey, m_pinDiameter, boardCache, debug);
+	return 0;
+}
 
-				/*
-				 * Set pins to a known lower size, they get resized
-				 * in DrawParts() when the component is analysed
-				 */
-				for (auto &pin : m_board->Pins()) {
-					auto p      = pin.get();
-					p->diameter = 7;
-				}
+bool BoardView::IsLoading() {
+	return m_loader.Busy();
+}
 
-				CenterView();
-				m_lastFileOpenWasInvalid = false;
-				m_validBoard             = true;
+// Swaps in the board of a load that went through, called from Update()
+void BoardView::FinishLoad(BoardLoadJob &job) {
+	const std::string &filename = job.filename;
+	m_lastFileOpenWasInvalid    = true;
+	m_validBoard                = false;
 
-			} else {
-				m_validBoard = false;
-				delete file;
-			}
+	// clean up the previous file, everything it owns goes with its arena.
+	if (m_board) {
+		m_pinHighlighted.Reset(Span<Pin>());
+		m_partHighlighted.Reset(Span<Component>());
+		m_annotations.Close();
+		m_nets.clear();
+		m_pinSelected           = nullptr;
+		m_pinHighlightedHovered = nullptr;
+		currentlyHoveredPin     = nullptr;
+		currentlyHoveredPart    = nullptr;
+		m_testPadHovered        = nullptr;
+		m_partsHovered.clear();
+		m_boardMesh.Clear();
+		m_boardMeshParts.count = m_boardMeshPins.count = 0;
+		m_pinlessParts.clear();
+		delete m_board;
+		m_board = nullptr;
+	}
+
+	SetLastFileOpenName(filename);
+	if (job.board) {
+		SetFile(job.board);
+		job.board          = nullptr;
+		m_residentWithFile = job.resident_with_file;
+		m_resident         = job.resident;
+		fhistory.Prepend_save(filename);
+		history_file_has_changed = 1; // used by main to know when to update the window title
+		boardMinMaxDone          = false;
+		m_rotation               = 0;
+		m_current_side           = 0;
+
+		m_annotations.SetFilename(filename);
+		m_annotations.Load();
+		m_annotationGridDirty = true;
+
+		CenterView();
+		m_lastFileOpenWasInvalid = false;
+		m_validBoard             = true;
+	}
+}
+
+void BoardView::DrawLoadProgress() {
+	static const char *const stage_names[load_stage_count] = {"Read", "Decode", "Parse", "Build", "Analyse", "Done"};
+
+	const BoardLoadJob *job = m_loader.Current();
+	if (!job) return;
+	const LoadStatus &status = job->status;
+	int stage                = static_cast<int>(status.Stage());
+	auto now                 = std::chrono::steady_clock::now();
+
+	ImGui::SetNextWindowPosCenter();
+	ImGui::Begin("Loading",
+	             nullptr,
+	             ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse |
+	                 ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings);
+	ImGui::Text("Loading %s", job->filename.c_str());
+	ImGui::ProgressBar(float(stage) / (load_stage_count - 1), ImVec2(DPIF(400.0f), 0), stage_names[stage]);
+
+	// Time spent in each stage so far
+	for (int s = 0; s < load_stage_count - 1; s++) {
+		if (s > 0) ImGui::SameLine();
+		if (s > stage) {
+			ImGui::TextDisabled("%s", stage_names[s]);
+			continue;
 		}
-	} else {
-		return 1;
+		auto end = s < stage ? status.entered[s + 1] : now;
+		ImGui::Text("%s %.0fms", stage_names[s], std::chrono::duration<double, std::milli>(end - status.entered[s]).count());
 	}
 
-	return 0;
+	if (ImGui::Button("Cancel")) m_loader.Cancel();
+	ImGui::End();
 }
 
 void BoardView::SetFZKey(const char *keytext) {
@@ -1091,6 +1096,17 @@ void BoardView::ShowInfoPane(void) {
 		ImGui::Text("Size: %0.2f x %0.2f\"", m_boardWidth / 1000.0f, m_boardHeight / 1000.0f);
 		ImGui::Separator();
 		ImGui::Checkbox("Zoom on selected net", &m_centerZoomNets);
+
+		if (m_pinSelected && m_pinSelected->net) {
+			const NetTable &nets = m_board->NetData();
+			uint32_t n           = m_board->NetIndex(m_pinSelected->net);
+			GridBox box          = nets.bounds[n];
+
+			ImGui::Separator();
+			ImGui::Text("Net: %s", m_pinSelected->net->name.c_str());
+			ImGui::Text("Pins: %u (%u top, %u bottom)", nets.pin_count[n], nets.top_pins[n], nets.bottom_pins[n]);
+			ImGui::Text("Spread: %0.2f x %0.2f\"", (box.max_x - box.min_x) / 1000.0f, (box.max_y - box.min_y) / 1000.0f);
+		}
 	} else {
 		ImGui::Text("No board currently loaded.");
 	}
@@ -1123,7 +1139,7 @@ void BoardView::ShowInfoPane(void) {
 			 * Generate the pin# and net table
 			 */
 			ImGui::PushItemWidth(-1);
-			std::string str = std::string("##") + part->name;
+			std::string str = std::string("##") + part->name.c_str();
 			ImVec2 listSize;
 			int pc          = part->pins.size();
 			if (pc > 20) pc = 20;
@@ -1134,7 +1150,7 @@ void BoardView::ShowInfoPane(void) {
 				snprintf(ss, sizeof(ss), "%4s  %s", pin->number.c_str(), pin->net->name.c_str());
 				if (ImGui::Selectable(ss, false)) {
 					m_pinSelected = pin;
-					CenterZoomNet(pin->net->name);
+					CenterZoomNet(pin->net);
 					m_needsRedraw = true;
 					//					m_listPartsOnPinNet = true;
 				}
@@ -1202,17 +1218,19 @@ void BoardView::ContextMenu(void) {
 			 */
 			min_dist *= min_dist; // all distance squared
 			Pin *selection = nullptr;
-			for (auto &pin : m_board->Pins()) {
+			Span<Pin> pins = m_board->PinSpan();
+			m_board->PinGrid().QueryRadius(pos.x, pos.y, m_pinDiameter * 1.0f, [&](uint32_t i) {
+				Pin *pin = &pins[i];
 				if (ComponentIsVisible(pin->component)) {
 					float dx   = pin->position.x - pos.x;
 					float dy   = pin->position.y - pos.y;
 					float dist = dx * dx + dy * dy;
-					if (dist < min_dist) {
-						selection = pin.get();
+					if (dist < min_dist || (dist == min_dist && selection && pin < selection)) {
+						selection = pin;
 						min_dist  = dist;
 					}
 				}
-			}
+			});
 
 			/*
 			 * If there was a pin selected, we can extract net/part off it
@@ -1232,32 +1250,10 @@ void BoardView::ContextMenu(void) {
 				 * but haven't decided what to do in such a situation
 				 */
 
-				for (auto &part : m_board->Components()) {
-					int hit     = 0;
-					auto p_part = part.get();
-
-					if (!ComponentIsVisible(p_part)) continue;
-
-					// Work out if the point is inside the hull
-					{
-						int i, j, n;
-						outline_pt *poly;
-
-						n    = 4;
-						poly = p_part->outline;
-
-						for (i = 0, j = n - 1; i < n; j = i++) {
-							if (((poly[i].y > pos.y) != (poly[j].y > pos.y)) &&
-							    (pos.x < (poly[j].x - poly[i].x) * (pos.y - poly[i].y) / (poly[j].y - poly[i].y) + poly[i].x))
-								hit = !hit;
-						}
-					} // hull test
-					if (hit) {
-						partn = p_part->name;
-
-						ImGui::SameLine();
-					}
+				for (auto p_part : PartsAt(pos)) {
+					partn = p_part->name;
 
+					ImGui::SameLine();
 				} // for each part
 			}
 
@@ -1296,8 +1292,9 @@ void BoardView::ContextMenu(void) {
 							m_annotationedit_retain = false;
 							m_annotations.Update(m_annotations.annotations[m_annotation_clicked_id].id, contextbuf);
 							m_annotations.GenerateList();
-							m_needsRedraw      = true;
-							m_tooltips_enabled = true;
+							m_annotationGridDirty = true;
+							m_needsRedraw         = true;
+							m_tooltips_enabled    = true;
 							ImGui::CloseCurrentPopup();
 						}
 						ImGui::SameLine();
@@ -1357,7 +1354,8 @@ void BoardView::ContextMenu(void) {
 
 						m_annotations.Add(m_current_side, tx, ty, net.c_str(), partn.c_str(), pin.c_str(), contextbufnew);
 						m_annotations.GenerateList();
-						m_needsRedraw = true;
+						m_annotationGridDirty = true;
+						m_needsRedraw         = true;
 
 						ImGui::CloseCurrentPopup();
 					}
@@ -1376,7 +1374,8 @@ void BoardView::ContextMenu(void) {
 				if ((m_annotation_clicked_id >= 0) && (ImGui::Button("Remove"))) {
 					m_annotations.Remove(m_annotations.annotations[m_annotation_clicked_id].id);
 					m_annotations.GenerateList();
-					m_needsRedraw = true;
+					m_annotationGridDirty = true;
+					m_needsRedraw         = true;
 					ImGui::CloseCurrentPopup();
 				}
 			}
@@ -1410,13 +1409,13 @@ void BoardView::SearchColumnGenerate(char *title, char *search, int buttons_max)
 	if (search[0]) {
 		ImGui::ListBoxHeader(title);
 		if (m_searchComponents) {
-			for (auto &part : m_file->parts) {
+			for (auto &part : m_board->ComponentSpan()) {
 				if (buttons_left > 0) {
-					// if (utf8casestr(part.name, search)) {
-					if (strstrModeSearch(part.name, search)) {
-						if (ImGui::Selectable(part.name, false)) {
-							FindComponent(part.name);
-							snprintf(search, 128, "%s", part.name);
+					// if (utf8casestr(part.name.c_str(), search)) {
+					if (strstrModeSearch(part.name.c_str(), search)) {
+						if (ImGui::Selectable(part.name.c_str(), false)) {
+							FindComponent(part.name.c_str());
+							snprintf(search, 128, "%s", part.name.c_str());
 							buttons_left = 0;
 							//					first_button = part.name;
 						}
@@ -1612,6 +1611,8 @@ void BoardView::Update() {
 	char *preset_filename = NULL;
 	ImGuiIO &io           = ImGui::GetIO();
 
+	if (auto job = m_loader.TakeFinished()) FinishLoad(*job);
+
 	/**
 	 * ** FIXME
 	 * This should be handled in the keyboard section, not here
@@ -1849,7 +1850,7 @@ void BoardView::Update() {
 		ImGui::PopItemWidth();
 		*/
 
-		if (m_showContextMenu && m_file && showAnnotations) {
+		if (m_showContextMenu && m_board && showAnnotations) {
 			ImGui::OpenPopup("Annotations");
 		}
 
@@ -1868,7 +1869,7 @@ void BoardView::Update() {
 			ImGui::OpenPopup("Preferences");
 		}
 
-		if (m_showSearch && m_file) {
+		if (m_showSearch && m_board) {
 			ImGui::OpenPopup("Search for Component / Network");
 		}
 		if (m_lastFileOpenWasInvalid) {
@@ -1918,6 +1919,8 @@ void BoardView::Update() {
 		}
 	}
 
+	DrawLoadProgress();
+
 	ImGuiWindowFlags flags = ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
 	                         ImGuiWindowFlags_ShowBorders | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoCollapse |
 	                         ImGuiWindowFlags_NoSavedSettings;
@@ -1933,7 +1936,7 @@ void BoardView::Update() {
 	ImGui::SetNextWindowPos(ImVec2{0, io.DisplaySize.y - m_status_height});
 	ImGui::SetNextWindowSize(ImVec2(io.DisplaySize.x, m_status_height));
 	ImGui::Begin("status", nullptr, flags | ImGuiWindowFlags_NoFocusOnAppearing);
-	if (m_file && m_board && m_pinSelected) {
+	if (m_board && m_pinSelected) {
 		auto pin = m_pinSelected;
 		ImGui::Text("Part: %s   Pin: %s   Net: %s   Probe: %d   (%s.)",
 		            pin->component->name.c_str(),
@@ -1952,6 +1955,20 @@ void BoardView::Update() {
 		if (debug) {
 			ImGui::Text("AnnID:%d ", m_annotation_clicked_id);
 			ImGui::SameLine();
+			if (m_validBoard) {
+				ImGui::Text("Mem: %0.1fMB (%0.1fMB with file) ", m_resident / 1048576.0f, m_residentWithFile / 1048576.0f);
+				ImGui::SameLine();
+				ImGui::Text("Drawn: %u/%u pins, %u/%u parts visited ", m_pinsDrawn, m_pinsVisited, m_partsDrawn, m_partsVisited);
+				ImGui::SameLine();
+			}
+			if (m_streamStats) {
+				ImGui::Text("Streamed: %0.1fKB of %0.1fKB, %u reallocated, %u orphaned ",
+				            m_streamStats->bytes_uploaded / 1024.0f,
+				            m_streamStats->capacity / 1024.0f,
+				            m_streamStats->reallocations,
+				            m_streamStats->orphans);
+				ImGui::SameLine();
+			}
 		}
 
 		if (showPosition == true) {
@@ -2027,7 +2044,7 @@ void BoardView::Zoom(float osd_x, float osd_y, float zoom) {
 	ImVec2 td = ScreenToCoord(target.x - dtarget.x, target.y - dtarget.y, 0);
 	m_dx += td.x;
 	m_dy += td.y;
-	m_needsRedraw = true;
+	ViewMoved();
 }
 
 void BoardView::Pan(int direction, int amount) {
@@ -2065,7 +2082,7 @@ void BoardView::Pan(int direction, int amount) {
 	}
 
 	m_draggingLastFrame = true;
-	m_needsRedraw       = true;
+	ViewMoved();
 }
 
 /*
@@ -2073,6 +2090,36 @@ void BoardView::Pan(int direction, int amount) {
  * it's meant specifically for the board draw surface only.  The inputs
  * for menus is handled within the menu generation itself.
  */
+// Visible parts whose outline contains pos, in board order
+std::vector<Component *> BoardView::PartsAt(ImVec2 pos) {
+	std::vector<Component *> parts;
+	Span<Component> components = m_board->ComponentSpan();
+
+	m_board->PartGrid().QueryPoint(pos.x, pos.y, [&](uint32_t c) {
+		int hit     = 0;
+		auto p_part = &components[c];
+
+		if (!ComponentIsVisible(p_part) || !p_part->outline_done) return;
+
+		// Work out if the point is inside the hull
+		int i, j, n;
+		outline_pt *poly;
+
+		n    = 4;
+		poly = p_part->outline;
+
+		for (i = 0, j = n - 1; i < n; j = i++) {
+			if (((poly[i].y > pos.y) != (poly[j].y > pos.y)) &&
+			    (pos.x < (poly[j].x - poly[i].x) * (pos.y - poly[i].y) / (poly[j].y - poly[i].y) + poly[i].x))
+				hit ^= 1;
+		}
+
+		if (hit) parts.push_back(p_part);
+	});
+
+	return parts; // A point is in a single cell, so parts come up once and in order
+}
+
 void BoardView::HandleInput() {
 
 #ifdef _WIN32
@@ -2081,7 +2128,7 @@ void BoardView::HandleInput() {
 #define KM(x) (((x)&0xFF) | 0x100)
 #endif
 
-	if (!m_board || (!m_file)) return;
+	if (!m_board) return;
 
 	const ImGuiIO &io = ImGui::GetIO();
 
@@ -2102,14 +2149,14 @@ void BoardView::HandleInput() {
 				m_dx += td.x;
 				m_dy += td.y;
 				m_draggingLastFrame = true;
-				m_needsRedraw       = true;
+				ViewMoved();
 			}
 		} else {
 			m_dragging_token = 0;
 
 			if (m_lastFileOpenWasInvalid == false) {
 				// Conext menu
-				if (!m_lastFileOpenWasInvalid && m_file && m_board && ImGui::IsMouseClicked(1)) {
+				if (!m_lastFileOpenWasInvalid && m_board && ImGui::IsMouseClicked(1)) {
 					if (showAnnotations) {
 						// Build context menu here, for annotations and inspection
 						//
@@ -2125,11 +2172,11 @@ void BoardView::HandleInput() {
 					}
 
 					// Flip the board with the middle click
-				} else if (!m_lastFileOpenWasInvalid && m_file && m_board && ImGui::IsMouseReleased(2)) {
+				} else if (!m_lastFileOpenWasInvalid && m_board && ImGui::IsMouseReleased(2)) {
 					FlipBoard();
 
 					// Else, click to select pin
-				} else if (!m_lastFileOpenWasInvalid && m_file && m_board && ImGui::IsMouseReleased(0) && !m_draggingLastFrame) {
+				} else if (!m_lastFileOpenWasInvalid && m_board && ImGui::IsMouseReleased(0) && !m_draggingLastFrame) {
 					ImVec2 spos = ImGui::GetMousePos();
 					ImVec2 pos  = ScreenToCoord(spos.x, spos.y);
 
@@ -2139,18 +2186,21 @@ void BoardView::HandleInput() {
 					// float min_dist = m_pinDiameter * 1.0f;
 					float min_dist = m_pinDiameter / 2.0f;
 					min_dist *= min_dist; // all distance squared
-					Pin *selection = nullptr;
-					for (auto &pin : m_board->Pins()) {
-						if (ComponentIsVisible(pin->component)) {
-							float dx   = pin->position.x - pos.x;
-							float dy   = pin->position.y - pos.y;
+					uint32_t selected     = UINT32_MAX;
+					const PinTable &table = m_board->PinData();
+					m_board->PinGrid().QueryRadius(pos.x, pos.y, m_pinDiameter / 2.0f, [&](uint32_t i) {
+						if (SideIsVisible(table.side[i])) {
+							float dx   = table.position[i].x - pos.x;
+							float dy   = table.position[i].y - pos.y;
 							float dist = dx * dx + dy * dy;
-							if ((dist < (pin->diameter * pin->diameter)) && (dist < min_dist)) {
-								selection = pin.get();
-								min_dist  = dist;
+							if ((dist < (table.diameter[i] * table.diameter[i])) &&
+							    (dist < min_dist || (dist == min_dist && selected != UINT32_MAX && i < selected))) {
+								selected = i;
+								min_dist = dist;
 							}
 						}
-					}
+					});
+					Pin *selection = selected == UINT32_MAX ? nullptr : &m_board->PinSpan()[selected];
 
 					m_pinSelected = selection;
 					if (m_pinSelected) {
@@ -2160,87 +2210,63 @@ void BoardView::HandleInput() {
 					if (m_pinSelected == nullptr) {
 						bool any_hits = false;
 
-						for (auto part : m_board->Components()) {
-							int hit     = 0;
-							auto p_part = part.get();
+						for (auto p_part : PartsAt(pos)) {
+							auto &part = *p_part;
 
-							if (!ComponentIsVisible(p_part)) continue;
+							any_hits = true;
 
-							// Work out if the point is inside the hull
-							{
-								int i, j, n;
-								outline_pt *poly;
-
-								n    = 4;
-								poly = p_part->outline;
-
-								for (i = 0, j = n - 1; i < n; j = i++) {
-									if (((poly[i].y > pos.y) != (poly[j].y > pos.y)) &&
-									    (pos.x <
-									     (poly[j].x - poly[i].x) * (pos.y - poly[i].y) / (poly[j].y - poly[i].y) + poly[i].x))
-										hit ^= 1;
-								}
-							}
-
-							if (hit) {
-								any_hits = true;
-
-								bool partInList = contains(*part, m_partHighlighted);
-
-								/*
-								 * If the CTRL key isn't held down, then we have to
-								 * flush any existing highlighted parts
-								 */
-								if (io.KeyCtrl) {
-									if (!partInList) {
-										m_partHighlighted.push_back(p_part);
-										p_part->visualmode = part->CVMSelected;
-									} else {
-										remove(*part, m_partHighlighted);
-										p_part->visualmode = part->CVMNormal;
-									}
+							bool partInList = m_partHighlighted.contains(p_part);
 
+							/*
+							 * If the CTRL key isn't held down, then we have to
+							 * flush any existing highlighted parts
+							 */
+							if (io.KeyCtrl) {
+								if (!partInList) {
+									m_partHighlighted.insert(p_part);
+									p_part->visualmode = part.CVMSelected;
 								} else {
-									for (auto p : m_partHighlighted) {
-										p->visualmode = p->CVMNormal;
-									}
-									m_partHighlighted.clear(); // only append to list if ctrl is pressed to collect multiples
-									if (!partInList) {
-										m_partHighlighted.push_back(p_part);
-										p_part->visualmode = part->CVMSelected;
-									}
+									m_partHighlighted.erase(p_part);
+									p_part->visualmode = part.CVMNormal;
 								}
 
-								/*
-								 * If this part has a non-selected visual mode (normal)
-								 * AND it's not in the existing part list, then add it
-								 */
-								/*
-								if (part->visualmode == part->CVMNormal) {
-								    if (!partInList) {
-								        m_partHighlighted.push_back(p_part);
-								    }
+							} else {
+								for (auto p : m_partHighlighted) {
+									p->visualmode = p->CVMNormal;
 								}
+								m_partHighlighted.clear(); // only append to list if ctrl is pressed to collect multiples
+								if (!partInList) {
+									m_partHighlighted.insert(p_part);
+									p_part->visualmode = part.CVMSelected;
+								}
+							}
 
-								part->visualmode++;
-								part->visualmode %= part->CVMModeCount;
+							/*
+							 * If this part has a non-selected visual mode (normal)
+							 * AND it's not in the existing part list, then add it
+							 */
+							/*
+							if (part.visualmode == part.CVMNormal) {
+							    if (!partInList) {
+							        m_partHighlighted.insert(p_part);
+							    }
+							}
 
-								if (part->visualmode == part->CVMNormal) {
-								    remove(*part, m_partHighlighted);
-								}
-								*/
-							} // if hit
-						}     // for each part on the board
+							part.visualmode++;
+							part.visualmode %= part.CVMModeCount;
+
+							if (part.visualmode == part.CVMNormal) {
+							    m_partHighlighted.erase(p_part);
+							}
+							*/
+						} // for each part hit
 
 						/*
 						 * If we aren't holding down CTRL and we click to a
 						 * non pin, non part area, then we clear everything
 						 */
 						if ((!any_hits) && (!io.KeyCtrl)) {
-							for (auto part : m_board->Components()) {
-								auto p        = part.get();
-								p->visualmode = p->CVMNormal;
-							}
+							for (auto &part : m_board->ComponentSpan()) part.visualmode = part.CVMNormal;
 							m_partHighlighted.clear();
 						}
 
@@ -2248,13 +2274,8 @@ void BoardView::HandleInput() {
 
 				} else {
 					if (!m_showContextMenu) {
-						if (AnnotationIsHovered()) {
-							m_needsRedraw        = true;
-							AnnotationWasHovered = true;
-						} else {
-							AnnotationWasHovered = false;
-							m_needsRedraw        = true;
-						}
+						// Only its tooltip changes, DrawBoard() redraws for the parts and pins under the mouse
+						AnnotationWasHovered = AnnotationIsHovered();
 					}
 				}
 
@@ -2399,31 +2420,24 @@ void BoardView::RenderOverlay() {
  *
  */
 
-void BoardView::CenterZoomNet(string netname) {
+void BoardView::CenterZoomNet(const Net *net) {
 	ImVec2 view = m_board_surface;
-	ImVec2 min, max;
-	int i = 0;
 
 	if (!m_centerZoomNets) return;
 
-	min.x = min.y = FLT_MAX;
-	max.x = max.y = FLT_MIN;
-
-	for (auto pin : m_board->Pins()) {
-		auto pp = pin.get();
-		if (pp->net->name == netname) {
-			auto p                 = pp->position;
-			if (p.x < min.x) min.x = p.x;
-			if (p.y < min.y) min.y = p.y;
-			if (p.x > max.x) max.x = p.x;
-			if (p.y > max.y) max.y = p.y;
-		}
-	}
-
 	// Bounds check!
-	if ((min.x == FLT_MAX) || (min.y == FLT_MAX) || (max.x == FLT_MIN) || (max.y == FLT_MIN)) return;
-
-	if (debug) fprintf(stderr, "CenterzoomNet: bbox[%d]: %0.1f %0.1f - %0.1f %0.1f\n", i, min.x, min.y, max.x, max.y);
+	GridBox box = m_board->NetData().bounds[m_board->NetIndex(net)];
+	if (box.empty()) return;
+	ImVec2 min(box.min_x, box.min_y), max(box.max_x, box.max_y);
+
+	if (debug)
+		fprintf(stderr,
+		        "CenterzoomNet: bbox[%d]: %0.1f %0.1f - %0.1f %0.1f\n",
+		        int(net->pins.size()),
+		        min.x,
+		        min.y,
+		        max.x,
+		        max.y);
 
 	float dx = 2.0f * (max.x - min.x);
 	float dy = 2.0f * (max.y - min.y);
@@ -2437,7 +2451,7 @@ void BoardView::CenterZoomNet(string netname) {
 	m_dx = (max.x - min.x) / 2 + min.x;
 	m_dy = (max.y - min.y) / 2 + min.y;
 	SetTarget(m_dx, m_dy);
-	m_needsRedraw = true;
+	ViewMoved();
 }
 
 void BoardView::CenterZoomSearchResults(void) {
@@ -2487,7 +2501,7 @@ void BoardView::CenterZoomSearchResults(void) {
 	m_dx = (max.x - min.x) / 2 + min.x;
 	m_dy = (max.y - min.y) / 2 + min.y;
 	SetTarget(m_dx, m_dy);
-	m_needsRedraw = true;
+	ViewMoved();
 }
 
 /*
@@ -2495,10 +2509,10 @@ void BoardView::CenterZoomSearchResults(void) {
  * the outline and flips the board outline if required, as it seems some
  * brd2 files are coming with a y-flipped outline
  */
-int BoardView::EPCCheck(void) {
+int BoardView::EPCCheck(Board *board, bool debug) {
 	int epc[2] = {0, 0};
 	int side;
-	auto &outline = m_board->OutlinePoints();
+	auto &outline = board->OutlinePoints();
 	ImVec2 min, max;
 
 	// find the orthagonal bounding box
@@ -2513,7 +2527,7 @@ int BoardView::EPCCheck(void) {
 	}
 
 	for (side = 0; side < 2; side++) {
-		for (auto pin : m_board->Pins()) {
+		for (auto pin : board->Pins()) {
 			auto p = pin.get();
 			int l, r;
 			int jump = 1;
@@ -2598,7 +2612,7 @@ void BoardView::OutlineGenFillDraw(ImDrawList *draw, int ydelta, double thicknes
 	double y, ystart, yend;
 
 	if (!boardFill) return;
-	if (!m_file) return;
+	if (!m_board) return;
 
 	scanhits.reserve(20);
 
@@ -2737,18 +2751,42 @@ void BoardView::DrawHex(ImDrawList *draw, ImVec2 c, double r, uint32_t color) {
 	draw->AddPolyline(hex, 6, color, true, 1.0f, true);
 }
 
-inline void BoardView::DrawOutline(ImDrawList *draw) {
+void BoardView::DrawPinShape(
+    ImDrawList *draw, ImVec2 c, float r, PinGlyph glyph, bool filled, uint32_t color, int segments, float thickness) {
+	if (m_pinGlyphs.baked) {
+		m_pinGlyphs.Add(draw, c, r, glyph, filled, color);
+		return;
+	}
+
+	switch (glyph) {
+		case kPinGlyphCircle:
+			if (filled)
+				draw->AddCircleFilled(c, r, color, segments);
+			else
+				draw->AddCircle(c, r, color, segments, thickness);
+			break;
+		case kPinGlyphSquare:
+			if (filled)
+				draw->AddRectFilled(ImVec2(c.x - r, c.y - r), ImVec2(c.x + r, c.y + r), color);
+			else
+				draw->AddRect(ImVec2(c.x - r, c.y - r), ImVec2(c.x + r, c.y + r), color);
+			break;
+		case kPinGlyphDiamond: DrawDiamond(draw, c, r, color); break;
+		default: DrawHex(draw, c, r, color); break;
+	}
+}
+
+// Calls fn(a, b) for each segment of the board outline, leaving out doubled points and the jumps between its loops
+template <typename F>
+static void OutlineSegments(SharedVector<Point> &outline, F fn) {
 	int jump = 1;
 	Point fp;
 
-	auto &outline = m_board->OutlinePoints();
-
-	draw->ChannelsSetCurrent(kChannelPolylines);
+	if (outline.empty()) return;
 
 	// set our initial draw point, so we can detect when we encounter it again
 	fp = *outline[0];
 
-	draw->PathClear();
 	for (size_t i = 0; i < outline.size() - 1; i++) {
 		Point &pa = *outline[i];
 		Point &pb = *outline[i + 1];
@@ -2769,19 +2807,90 @@ inline void BoardView::DrawOutline(ImDrawList *draw) {
 			jump = 0;
 		}
 
-		ImVec2 spa = CoordToScreen(pa.x, pa.y);
-		ImVec2 spb = CoordToScreen(pb.x, pb.y);
+		fn(pa, pb);
+	} // for
+}
 
-		/*
-		 * If we have a pin selected, we mask off the colour to shade out
-		 * things and make it easier to see associated pins/points
-		 */
-		if ((pinSelectMasks) && (m_pinSelected || m_pinHighlighted.size())) {
-			draw->AddLine(spa, spb, (m_colors.boardOutlineColor & m_colors.selectedMaskOutline) | m_colors.orMaskOutline);
-		} else {
-			draw->AddLine(spa, spb, m_colors.boardOutlineColor);
+/*
+ * Calls fn(quad) for trapezoids filling the inside of the board outline by the
+ * even-odd rule, as the scan lines of OutlineGenFillDraw() do, each between two
+ * of the heights the outline has points at.
+ */
+template <typename F>
+static void OutlineTrapezoids(SharedVector<Point> &outline, F fn) {
+	struct Edge {
+		float x0, y0, x1, y1; // y0 < y1
+	};
+	vector<Edge> edges, active;
+	vector<float> ys;
+	vector<ImVec2> hits; // x of each active edge at the top and the bottom of a trapezoid
+
+	OutlineSegments(outline, [&](const Point &pa, const Point &pb) {
+		if (pa.y == pb.y) return;
+		if (pa.y < pb.y)
+			edges.push_back({pa.x, pa.y, pb.x, pb.y});
+		else
+			edges.push_back({pb.x, pb.y, pa.x, pa.y});
+		ys.push_back(pa.y);
+		ys.push_back(pb.y);
+	});
+	sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) { return a.y0 < b.y0; });
+	sort(ys.begin(), ys.end());
+	ys.erase(unique(ys.begin(), ys.end()), ys.end());
+
+	auto x_at = [](const Edge &e, float y) { return e.x0 + (e.x1 - e.x0) * (y - e.y0) / (e.y1 - e.y0); };
+
+	size_t next = 0;
+	for (size_t i = 0; i + 1 < ys.size(); i++) {
+		float top = ys[i], bottom = ys[i + 1];
+
+		// Edges cross the whole height between one point and the next
+		active.erase(remove_if(active.begin(), active.end(), [&](const Edge &e) { return e.y1 <= top; }), active.end());
+		while (next < edges.size() && edges[next].y0 <= top) active.push_back(edges[next++]);
+
+		// Down to where any of them cross each other, as outline loops may
+		while (top < bottom) {
+			float end = bottom;
+			for (size_t a = 0; a < active.size(); a++) {
+				for (size_t b = a + 1; b < active.size(); b++) {
+					float d0 = x_at(active[a], top) - x_at(active[b], top);
+					float d1 = x_at(active[a], bottom) - x_at(active[b], bottom);
+					float y  = top + (bottom - top) * d0 / (d0 - d1);
+
+					if (d0 * d1 < 0 && y > top && y < end) end = y;
+				}
+			}
+
+			hits.clear();
+			for (auto &e : active) hits.push_back(ImVec2(x_at(e, top), x_at(e, end)));
+			sort(hits.begin(), hits.end(), [](const ImVec2 &a, const ImVec2 &b) { return a.x + a.y < b.x + b.y; });
+
+			for (size_t h = 0; h + 1 < hits.size(); h += 2) {
+				ImVec2 quad[4] = {
+				    ImVec2(hits[h].x, top), ImVec2(hits[h + 1].x, top), ImVec2(hits[h + 1].y, end), ImVec2(hits[h].y, end)};
+				fn(quad);
+			}
+			top = end;
 		}
-	} // for
+	}
+}
+
+inline void BoardView::DrawOutline(ImDrawList *draw) {
+	uint32_t color = m_colors.boardOutlineColor;
+
+	draw->ChannelsSetCurrent(kChannelPolylines);
+
+	/*
+	 * If we have a pin selected, we mask off the colour to shade out
+	 * things and make it easier to see associated pins/points
+	 */
+	if ((pinSelectMasks) && (m_pinSelected || m_pinHighlighted.size())) {
+		color = (m_colors.boardOutlineColor & m_colors.selectedMaskOutline) | m_colors.orMaskOutline;
+	}
+
+	OutlineSegments(m_board->OutlinePoints(), [&](const Point &pa, const Point &pb) {
+		draw->AddLine(CoordToScreen(pa.x, pa.y), CoordToScreen(pb.x, pb.y), color);
+	});
 }
 
 void BoardView::DrawNetWeb(ImDrawList *draw) {
@@ -2795,21 +2904,25 @@ void BoardView::DrawNetWeb(ImDrawList *draw) {
 	if (m_pinSelected->type == Pin::kPinTypeUnkown) return;
 	if (m_pinSelected->net->is_ground) return;
 
-	for (auto &p : m_board->Pins()) {
-
-		if (p->net == m_pinSelected->net) {
-			uint32_t col = m_colors.pinNetWebColor;
-			if (!ComponentIsVisible(p->component)) {
-				col = m_colors.pinNetWebOSColor;
-				draw->AddCircle(CoordToScreen(p->position.x, p->position.y), p->diameter * m_scale, col, 16);
-			}
-
-			draw->AddLine(CoordToScreen(m_pinSelected->position.x, m_pinSelected->position.y),
-			              CoordToScreen(p->position.x, p->position.y),
-			              ImColor(col),
-			              1);
+	bool retained = RetainedBoard();
+	ImVec2 from   = ImVec2(m_pinSelected->position.x, m_pinSelected->position.y);
+	for (auto p : m_pinSelected->net->pins) {
+		ImVec2 to    = ImVec2(p->position.x, p->position.y);
+		uint32_t col = m_colors.pinNetWebColor;
+		if (!ComponentIsVisible(p->component)) {
+			col = m_colors.pinNetWebOSColor;
+			if (retained)
+				m_overlayMesh.AddPin(to, p->diameter, col, BoardVertex::kShapeCircle);
+			else
+				DrawPinShape(draw, CoordToScreen(to.x, to.y), p->diameter * m_scale, kPinGlyphCircle, false, col, 16);
 		}
+
+		if (retained)
+			m_overlayMesh.AddLine(from, to, col);
+		else
+			draw->AddLine(CoordToScreen(from.x, from.y), CoordToScreen(to.x, to.y), ImColor(col), 1);
 	}
+	if (retained) AddOverlay(draw);
 	return;
 }
 
@@ -2844,20 +2957,62 @@ inline void BoardView::DrawPins(ImDrawList *draw) {
 
 	draw->ChannelsSetCurrent(kChannelPins);
 
-	for (auto &pin : m_board->Pins()) {
-		auto p_pin = pin.get();
-		float psz  = pin->diameter * m_scale;
-		uint32_t fill_color;
-
-		// continue if pin is not visible anyway
-		ImVec2 pos = CoordToScreen(pin->position.x, pin->position.y);
-		{
-			if (!ComponentIsVisible(pin->component)) continue;
+	const PinTable &table = m_board->PinData();
+	auto pins             = m_board->PinSpan();
 
-			if (!IsVisibleScreen(pos.x, pos.y, psz, io)) continue;
+	m_inView.clear();
+	bool retained = RetainedBoard();
+	if (retained) {
+		/*
+		 * Every pin is in the mesh in its plain colour, only those a selection,
+		 * highlight or selected part changes go in the overlay on top of it,
+		 * wherever they are as the view may move to them
+		 */
+		m_boardMesh.min_size   = (m_pinSelected || m_pinHighlighted.size()) ? 0 : threshold;
+		m_overlayMesh.min_size = m_boardMesh.min_size;
+		draw->AddCallback(m_boardMeshCallback, &m_boardMeshPins);
+
+		for (Pin *pin : m_pinHighlighted) m_inView.push_back(pin - pins.begin());
+		if (m_pinSelected) {
+			m_inView.push_back(m_pinSelected - pins.begin());
+			if (m_pinSelected->net)
+				for (Pin *pin : m_pinSelected->net->pins) m_inView.push_back(pin - pins.begin());
 		}
 
-		if ((!m_pinSelected) && (psz < threshold)) continue;
+		// Parts are selected by highlighting them or a pin of theirs, see HandleInput()
+		for (Component *part : m_partHighlighted)
+			for (Pin *pin : part->pins) m_inView.push_back(pin - pins.begin());
+		if (m_pinSelected && m_pinSelected->component)
+			for (Pin *pin : m_pinSelected->component->pins) m_inView.push_back(pin - pins.begin());
+		std::sort(m_inView.begin(), m_inView.end());
+		m_inView.erase(std::unique(m_inView.begin(), m_inView.end()), m_inView.end());
+	} else {
+		// Only pins around the view are looked at, in board order as highlighting a pin lowers the threshold for those after it
+		GridBox view = ViewArea(m_board->MaxPinDiameter());
+		m_board->PinGrid().Query(view.min_x, view.min_y, view.max_x, view.max_y, [&](uint32_t i) { m_inView.push_back(i); });
+		std::sort(m_inView.begin(), m_inView.end());
+	}
+	m_pinsVisited = m_inView.size();
+	m_pinsDrawn   = 0;
+
+	uint8_t shape = (pinShapeSquare || slowCPU) ? BoardVertex::kShapeSquare : BoardVertex::kShapeCircle;
+	Pin *ring     = nullptr; // Selected pin the overlay rings
+	vector<Pin *> halos;     // Pins the overlay puts halos around
+
+	for (uint32_t i : m_inView) {
+		// continue if pin is not visible anyway, only the pin table is touched until then
+		if (!SideIsVisible(table.side[i])) continue;
+
+		float psz  = table.diameter[i] * m_scale;
+		ImVec2 pos = CoordToScreen(table.position[i].x, table.position[i].y);
+		if (!retained && !IsVisibleScreen(pos.x, pos.y, psz, io)) continue;
+
+		Pin *pin = &pins[i];
+		uint32_t fill_color;
+
+		// The mesh leaves out pins under the threshold by itself
+		if (!retained && (!m_pinSelected) && (psz < threshold)) continue;
+		m_pinsDrawn++;
 
 		// color & text depending on app state & pin type
 		uint32_t color      = (m_colors.pinDefaultColor & cmask) | omask;
@@ -2865,7 +3020,7 @@ inline void BoardView::DrawPins(ImDrawList *draw) {
 		bool show_text      = false;
 
 		{
-			if (contains(*pin, m_pinHighlighted)) {
+			if (m_pinHighlighted.contains(pin)) {
 				text_color = color = m_colors.pinSelectedTextColor;
 
 				show_text = true;
@@ -2902,7 +3057,7 @@ inline void BoardView::DrawPins(ImDrawList *draw) {
 			}
 
 			// pin selected overwrites everything
-			if (p_pin == m_pinSelected) {
+			if (pin == m_pinSelected) {
 				color      = m_colors.pinSelectedColor;
 				text_color = m_colors.pinSelectedTextColor;
 				show_text  = true;
@@ -2910,7 +3065,7 @@ inline void BoardView::DrawPins(ImDrawList *draw) {
 			}
 
 			// If the part itself is highlighted ( CVMShowPins )
-			if (p_pin->component->visualmode == p_pin->component->CVMSelected) {
+			if (pin->component->visualmode == pin->component->CVMSelected) {
 				show_text = true;
 			}
 
@@ -2919,7 +3074,18 @@ inline void BoardView::DrawPins(ImDrawList *draw) {
 		}
 
 		// Drawing
-		{
+		if (retained) {
+			ImVec2 at = ImVec2(table.position[i].x, table.position[i].y);
+
+			if (pin->type == Pin::kPinTypeTestPad) {
+				m_overlayMesh.AddPin(at, table.diameter[i], fill_color, BoardVertex::kShapeDisc);
+				m_overlayMesh.AddPin(at, table.diameter[i], color, BoardVertex::kShapeCircle);
+			} else {
+				m_overlayMesh.AddPin(at, table.diameter[i], color, shape);
+			}
+			if (pin == m_pinSelected) ring = pin;
+			if ((color == m_colors.pinHighlightSameNetColor) && (pinHalo == true)) halos.push_back(pin);
+		} else {
 			int segments;
 			//			draw->ChannelsSetCurrent(kChannelImages);
 
@@ -2933,58 +3099,72 @@ inline void BoardView::DrawPins(ImDrawList *draw) {
 			switch (pin->type) {
 				case Pin::kPinTypeTestPad:
 					if ((psz > 3) && (!slowCPU)) {
-						draw->AddCircleFilled(ImVec2(pos.x, pos.y), psz, fill_color, segments);
-						draw->AddCircle(ImVec2(pos.x, pos.y), psz, color, segments);
+						DrawPinShape(draw, pos, psz, kPinGlyphCircle, true, fill_color, segments);
+						DrawPinShape(draw, pos, psz, kPinGlyphCircle, false, color, segments);
 					} else if (psz > threshold) {
-						draw->AddRectFilled(ImVec2(pos.x - h, pos.y - h), ImVec2(pos.x + h, pos.y + h), fill_color);
+						DrawPinShape(draw, pos, h, kPinGlyphSquare, true, fill_color);
 					}
 					break;
 				default:
 					if ((psz > 3) && (psz > threshold)) {
 						if (pinShapeSquare) {
-							draw->AddRect(ImVec2(pos.x - h, pos.y - h), ImVec2(pos.x + h, pos.y + h), color);
+							DrawPinShape(draw, pos, h, kPinGlyphSquare, false, color);
 						} else {
-							draw->AddCircle(ImVec2(pos.x, pos.y), psz, color, segments);
+							DrawPinShape(draw, pos, psz, kPinGlyphCircle, false, color, segments);
 						}
 					} else if (psz > threshold) {
-						draw->AddRect(ImVec2(pos.x - h, pos.y - h), ImVec2(pos.x + h, pos.y + h), color);
+						DrawPinShape(draw, pos, h, kPinGlyphSquare, false, color);
 					}
 			}
 
-			if (p_pin == m_pinSelected) {
-				draw->AddCircle(ImVec2(pos.x, pos.y), psz + 1.25, m_colors.pinSelectedTextColor, segments);
+			if (pin == m_pinSelected) {
+				DrawPinShape(draw, pos, psz + 1.25, kPinGlyphCircle, false, m_colors.pinSelectedTextColor, segments);
 			}
 
 			if ((color == m_colors.pinHighlightSameNetColor) && (pinHalo == true)) {
-				draw->AddCircle(ImVec2(pos.x, pos.y), psz * pinHaloDiameter, m_colors.pinHaloColor, segments, pinHaloThickness);
+				DrawPinShape(
+				    draw, pos, psz * pinHaloDiameter, kPinGlyphCircle, false, m_colors.pinHaloColor, segments, pinHaloThickness);
 			}
+		}
 
-			if (show_text) {
-				const char *pin_number = pin->number.c_str();
+		if (show_text) {
+			const char *pin_number = pin->number.c_str();
 
-				ImVec2 text_size = ImGui::CalcTextSize(pin_number);
-				ImVec2 pos_adj   = ImVec2(pos.x - text_size.x * 0.5f, pos.y - text_size.y * 0.5f);
+			ImVec2 text_size = ImGui::CalcTextSize(pin_number);
+			ImVec2 pos_adj   = ImVec2(pos.x - text_size.x * 0.5f, pos.y - text_size.y * 0.5f);
 
-				draw->ChannelsSetCurrent(kChannelText);
-				draw->AddText(pos_adj, text_color, pin_number);
+			draw->ChannelsSetCurrent(kChannelText);
+			BeginAnchor(draw, pos);
+			draw->AddText(pos_adj, text_color, pin_number);
+			EndAnchor(draw);
 
-				draw->ChannelsSetCurrent(kChannelPins);
-			}
+			draw->ChannelsSetCurrent(kChannelPins);
+		}
+	}
+
+	if (retained) {
+		AddOverlay(draw);
+		if (ring) {
+			m_overlayMesh.AddPin(ImVec2(ring->position.x, ring->position.y),
+			                     ring->diameter,
+			                     m_colors.pinSelectedTextColor,
+			                     BoardVertex::kShapeCircle);
+			AddOverlay(draw, 1, 1.25f);
+		}
+		for (Pin *pin : halos) {
+			m_overlayMesh.AddPin(ImVec2(pin->position.x, pin->position.y),
+			                     pin->diameter * pinHaloDiameter,
+			                     m_colors.pinHaloColor,
+			                     BoardVertex::kShapeCircle);
 		}
+		AddOverlay(draw, pinHaloThickness);
 	}
 
 	if (m_pinSelected) DrawNetWeb(draw);
 }
 
 inline void BoardView::DrawParts(ImDrawList *draw) {
-	// float psz = (float)m_pinDiameter * 0.5f * m_scale;
-	double angle;
-	double distance = 0;
-	struct ImVec2 pva[2000], *ppp;
 	uint32_t color = m_colors.partOutlineColor;
-	//	int rendered   = 0;
-	char p0, p1; // first two characters of the part name, code-writing
-	             // convenience more than anything else
 
 	draw->ChannelsSetCurrent(kChannelPolylines);
 	/*
@@ -2995,340 +3175,48 @@ inline void BoardView::DrawParts(ImDrawList *draw) {
 		color = (m_colors.partOutlineColor & m_colors.selectedMaskParts) | m_colors.orMaskParts;
 	}
 
-	for (auto &part : m_board->Components()) {
-		int pincount = 0;
-		double min_x, min_y, max_x, max_y, aspect;
-		outline_pt dbox[4]; // default box, if there's nothing else claiming to render the part different.
-		auto p_part = part.get();
+	Span<Component> components = m_board->ComponentSpan();
+	bool retained              = RetainedBoard();
+	if (retained) {
+		// Parts look as they do in the mesh unless highlighted, pinless ones only need their names
+		m_inView = m_pinlessParts;
+		for (Component *part : m_partHighlighted) m_inView.push_back(part - components.begin());
+		if (m_pinSelected && m_pinSelected->component) m_inView.push_back(m_pinSelected->component - components.begin());
+		std::sort(m_inView.begin(), m_inView.end());
+	} else {
+		// Parts around the view, with room for the name drawn above a highlighted one
+		GridBox view = ViewArea(ImGui::GetFontSize() * 4 / m_scale);
+		m_inView.clear();
+		m_board->PartGrid().Query(view.min_x, view.min_y, view.max_x, view.max_y, [&](uint32_t c) { m_inView.push_back(c); });
+		std::sort(m_inView.begin(), m_inView.end()); // Parts over several cells come up more than once
+	}
+	m_inView.erase(std::unique(m_inView.begin(), m_inView.end()), m_inView.end());
+	m_partsVisited = m_inView.size();
+	m_partsDrawn   = 0;
+
+	for (uint32_t c : m_inView) {
+		auto part = &components[c];
 
-		if (!ComponentIsVisible(p_part)) continue;
+		if (!ComponentIsVisible(part)) continue;
 
 		if (part->is_dummy()) continue;
+		m_partsDrawn++;
 
-		/*
-		 *
-		 * When we first load the board, the outline of each part isn't (yet) rendered
-		 * or determined/calculated.  So, the first time we display the board we
-		 * compute the outline and store it for later.
-		 *
-		 * This also sets the pin diameters too.
-		 *
-		 */
-		if (!part->outline_done) { // should only need to do this once for most parts
+		// Outlines and hulls are worked out when the board is loaded, see AnalyseParts()
+		if (part->pins.size() == 0) {
+			ImVec2 pos = CoordToScreen(part->p1.x + DPIF(10), part->p1.y - DPIF(50));
 
-			ppp = &pva[0];
-			if (part->pins.size() == 0) {
-				if (debug) fprintf(stderr, "WARNING: Drawing empty part %s\n", part->name.c_str());
+			if (debug) fprintf(stderr, "WARNING: Drawing empty part %s\n", part->name.c_str());
+			if (!retained) {
 				draw->AddRect(CoordToScreen(part->p1.x + DPIF(10), part->p1.y + DPIF(10)),
 				              CoordToScreen(part->p2.x - DPIF(10), part->p2.y - DPIF(10)),
 				              0xff0000ff);
-				draw->AddText(
-				    CoordToScreen(part->p1.x + DPIF(10), part->p1.y - DPIF(50)), m_colors.partTextColor, part->name.c_str());
-				continue;
-			}
-
-			for (auto pin : part->pins) {
-				pincount++;
-
-				// scale box around pins as a fallback, else either use polygon or convex
-				// hull for better shape fidelity
-				if (pincount == 1) {
-					min_x = pin->position.x;
-					min_y = pin->position.y;
-					max_x = min_x;
-					max_y = min_y;
-				}
-
-				if (pincount < 2000) {
-					ppp->x = pin->position.x;
-					ppp->y = pin->position.y;
-					ppp++;
-				}
-
-				if (pin->position.x > max_x) {
-					max_x = pin->position.x;
-
-				} else if (pin->position.x < min_x) {
-					min_x = pin->position.x;
-				}
-				if (pin->position.y > max_y) {
-					max_y = pin->position.y;
-
-				} else if (pin->position.y < min_y) {
-					min_y = pin->position.y;
-				}
 			}
-
-			distance = sqrt((max_x - min_x) * (max_x - min_x) + (max_y - min_y) * (max_y - min_y));
-
-			float pin_radius = m_pinDiameter / 2.0f;
-
-			/*
-			 *
-			 * Determine the size of our part's pin radius based on the distance
-			 * between the extremes of the pin coordinates.
-			 *
-			 * All the figures below are determined empirically rather than any
-			 * specific formula.
-			 *
-			 */
-			if ((pincount < 4) && (part->name[0] != 'U') && (part->name[0] != 'Q')) {
-
-				if ((distance > 52) && (distance < 57)) {
-					// 0603
-					pin_radius = 15;
-					for (auto pin : part->pins) {
-						pin->diameter = pin_radius; // * 0.05;
-					}
-
-				} else if ((distance > 247) && (distance < 253)) {
-					// SMC diode?
-					pin_radius = 50;
-					for (auto pin : part->pins) {
-						pin->diameter = pin_radius; // * 0.05;
-					}
-
-				} else if ((distance > 195) && (distance < 199)) {
-					// Inductor?
-					pin_radius = 50;
-					for (auto pin : part->pins) {
-						pin->diameter = pin_radius; // * 0.05;
-					}
-
-				} else if ((distance > 165) && (distance < 169)) {
-					// SMB diode?
-					pin_radius = 35;
-					for (auto pin : part->pins) {
-						pin->diameter = pin_radius; // * 0.05;
-					}
-
-				} else if ((distance > 101) && (distance < 109)) {
-					// SMA diode / tant cap
-					pin_radius = 30;
-					for (auto pin : part->pins) {
-						pin->diameter = pin_radius; // * 0.05;
-					}
-
-				} else if ((distance > 108) && (distance < 112)) {
-					// 1206
-					pin_radius = 30;
-					for (auto pin : part->pins) {
-						pin->diameter = pin_radius; // * 0.05;
-					}
-
-				} else if ((distance > 64) && (distance < 68)) {
-					// 0805
-					pin_radius = 25;
-					for (auto pin : part->pins) {
-						pin->diameter = pin_radius; // * 0.05;
-					}
-
-				} else if ((distance > 18) && (distance < 22)) {
-					// 0201 cap/resistor?
-					pin_radius = 5;
-					for (auto pin : part->pins) {
-						pin->diameter = pin_radius; // * 0.05;
-					}
-				} else if ((distance > 28) && (distance < 32)) {
-					// 0402 cap/resistor
-					pin_radius = 10;
-					for (auto pin : part->pins) {
-						pin->diameter = pin_radius; // * 0.05;
-					}
-				}
-			}
-
-			// TODO: pin radius is stored in Pin object
-			//
-			//
-			//
-			min_x -= pin_radius;
-			max_x += pin_radius;
-			min_y -= pin_radius;
-			max_y += pin_radius;
-
-			if ((max_y - min_y) < 0.01)
-				aspect = 0;
-			else
-				aspect = (max_x - min_x) / (max_y - min_y);
-
-			dbox[0].x = dbox[3].x = min_x;
-			dbox[1].x = dbox[2].x = max_x;
-			dbox[0].y = dbox[1].y = min_y;
-			dbox[3].y = dbox[2].y = max_y;
-
-			p0 = p_part->name[0];
-			p1 = p_part->name[1];
-
-			/*
-			 * Draw all 2~3 pin devices as if they're not orthagonal.  It's a bit more
-			 * CPU
-			 * overhead but it keeps the code simpler and saves us replicating things.
-			 */
-
-			if ((pincount == 3) && (abs(aspect > 0.5)) &&
-			    ((strchr("DQZ", p0) || (strchr("DQZ", p1)) || strcmp(p_part->name.c_str(), "LED")))) {
-				outline_pt *hpt;
-
-				memcpy(part->outline, dbox, sizeof(dbox));
-				part->outline_done = true;
-
-				hpt = part->hull = (outline_pt *)malloc(sizeof(outline_pt) * 3);
-				for (auto pin : part->pins) {
-					hpt->x = pin->position.x;
-					hpt->y = pin->position.y;
-					hpt++;
-				}
-				part->hull_count = 3;
-
-				/*
-				 * handle all other devices not specifically handled above
-				 */
-			} else if ((pincount > 1) && (pincount < 4) && ((strchr("CRLD", p0) || (strchr("CRLD", p1))))) {
-				double dx, dy;
-				double tx, ty;
-				double armx, army;
-
-				dx    = part->pins[1]->position.x - part->pins[0]->position.x;
-				dy    = part->pins[1]->position.y - part->pins[0]->position.y;
-				angle = atan2(dy, dx);
-
-				if (((p0 == 'L') || (p1 == 'L')) && (distance > 50)) {
-					pin_radius = 15;
-					for (auto pin : part->pins) {
-						pin->diameter = pin_radius; // * 0.05;
-					}
-					army = distance / 2;
-					armx = pin_radius;
-				} else if (((p0 == 'C') || (p1 == 'C')) && (distance > 90)) {
-					double mpx, mpy;
-
-					pin_radius = 15;
-					for (auto pin : part->pins) {
-						pin->diameter = pin_radius; // * 0.05;
-					}
-					army = distance / 2 - distance / 4;
-					armx = pin_radius;
-
-					mpx = dx / 2 + part->pins[0]->position.x;
-					mpy = dy / 2 + part->pins[0]->position.y;
-					VHRotateV(&mpx, &mpy, dx / 2 + part->pins[0]->position.x, dy / 2 + part->pins[0]->position.y, angle);
-
-					p_part->expanse        = distance;
-					p_part->centerpoint.x  = mpx;
-					p_part->centerpoint.y  = mpy;
-					p_part->component_type = p_part->kComponentTypeCapacitor;
-
-				} else {
-					armx = army = pin_radius;
-				}
-
-				// TODO: Compact this bit of code, maybe. It works at least.
-				tx = part->pins[0]->position.x - armx;
-				ty = part->pins[0]->position.y - army;
-				VHRotateV(&tx, &ty, part->pins[0]->position.x, part->pins[0]->position.y, angle);
-				// a = CoordToScreen(tx, ty);
-				part->outline[0].x = tx;
-				part->outline[0].y = ty;
-
-				tx = part->pins[0]->position.x - armx;
-				ty = part->pins[0]->position.y + army;
-				VHRotateV(&tx, &ty, part->pins[0]->position.x, part->pins[0]->position.y, angle);
-				// b = CoordToScreen(tx, ty);
-				part->outline[1].x = tx;
-				part->outline[1].y = ty;
-
-				tx = part->pins[1]->position.x + armx;
-				ty = part->pins[1]->position.y + army;
-				VHRotateV(&tx, &ty, part->pins[1]->position.x, part->pins[1]->position.y, angle);
-				// c = CoordToScreen(tx, ty);
-				part->outline[2].x = tx;
-				part->outline[2].y = ty;
-
-				tx = part->pins[1]->position.x + armx;
-				ty = part->pins[1]->position.y - army;
-				VHRotateV(&tx, &ty, part->pins[1]->position.x, part->pins[1]->position.y, angle);
-				// d = CoordToScreen(tx, ty);
-				part->outline[3].x = tx;
-				part->outline[3].y = ty;
-
-				part->outline_done = true;
-
-				// rendered = 1;
-
-			} else {
-
-				/*
-				 * If we have (typically) a connector with a non uniform pin distribution
-				 * then we can try use the minimal bounding box algorithm
-				 * to give it a more sane outline
-				 */
-				if ((pincount >= 4) && ((strchr("UJL", p0) || strchr("UJL", p1) || (strncmp(part->name.c_str(), "CN", 2) == 0)))) {
-					ImVec2 *hull;
-					int hpc;
-
-					hull = (ImVec2 *)malloc(sizeof(ImVec2) * pincount); // massive overkill since our hull will
-					                                                    // only require the perimeter points
-					if (hull) {
-						// Find our hull
-						hpc = VHConvexHull(hull, pva, pincount); // (hpc = hull pin count)
-
-						// If we had a valid hull, then find the MBB for it
-						if (hpc > 0) {
-							int i;
-							ImVec2 bbox[4];
-							outline_pt *hpt;
-							part->hull_count = hpc;
-
-							/*
-							 * compute the convex hull and then transfer
-							 * points to the part
-							 */
-							hpt = part->hull = (outline_pt *)malloc(sizeof(outline_pt) * (hpc + 1));
-							for (i = 0; i < hpc; i++) {
-								hpt->x = hull[i].x;
-								hpt->y = hull[i].y;
-								hpt++;
-							}
-
-							VHMBBCalculate(bbox, hull, hpc, pin_radius);
-							for (i = 0; i < 4; i++) {
-								part->outline[i].x = bbox[i].x;
-								part->outline[i].y = bbox[i].y;
-							}
-
-							part->outline_done = true;
-
-							/*
-							 * Tighten the hull, removes any small angle segments
-							 * such as a sequence of pins in a line, might be an overkill
-							 */
-							// hpc = TightenHull(hull, hpc, 0.1f);
-						}
-
-						free(hull);
-					} else {
-						fprintf(stderr, "ERROR: Cannot allocate memory for convex hull generation (%s)", strerror(errno));
-						memcpy(part->outline, dbox, sizeof(dbox));
-						part->outline_done = true;
-						//						draw->AddRect(min, max, color);
-						//						rendered = 1;
-					}
-
-				} else {
-					// if it wasn't at an odd angle, or wasn't large, or wasn't a connector,
-					// just an ordinary
-					// type part, then this is where we'll likely end up
-					memcpy(part->outline, dbox, sizeof(dbox));
-					part->outline_done = true;
-				}
-			}
-
-			//			if (rendered == 0) {
-			//				fprintf(stderr, "Part wasn't rendered (%s)\n", part->name.c_str());
-			//			}
-
-		} // if outline_done
+			BeginAnchor(draw, pos);
+			draw->AddText(pos, m_colors.partTextColor, part->name.c_str());
+			EndAnchor(draw);
+			continue;
+		}
 
 		if (part->outline_done) {
 
@@ -3343,17 +3231,33 @@ inline void BoardView::DrawParts(ImDrawList *draw) {
 			d = ImVec2(CoordToScreen(part->outline[3].x, part->outline[3].y));
 
 			// if (fillParts) draw->AddQuadFilled(a, b, c, d, color & 0xffeeeeee);
-			if (fillParts) draw->AddQuadFilled(a, b, c, d, m_colors.partFillColor);
-			draw->AddQuad(a, b, c, d, color);
-			if (PartIsHighlighted(*part)) {
+			bool highlighted = PartIsHighlighted(*part);
+			if (!retained) {
+				if (fillParts) draw->AddQuadFilled(a, b, c, d, m_colors.partFillColor);
+				draw->AddQuad(a, b, c, d, color);
+			}
+			if (highlighted && retained) {
+				ImVec2 quad[4];
+				for (int i = 0; i < 4; i++) quad[i] = ImVec2(part->outline[i].x, part->outline[i].y);
+
+				if (fillParts) m_overlayMesh.AddQuadFilled(quad, m_colors.partHighlightedFillColor);
+				m_overlayMesh.AddPolyline(quad, 4, m_colors.partHighlightedColor, true);
+			} else if (highlighted) {
 				if (fillParts) draw->AddQuadFilled(a, b, c, d, m_colors.partHighlightedFillColor);
 				draw->AddQuad(a, b, c, d, m_colors.partHighlightedColor);
 			}
 
+			// The mesh has the marks below too, unless the highlight was just filled over them
+			bool marks = !retained || (highlighted && fillParts);
+
 			/*
 			 * Draw the convex hull of the part if it has one
 			 */
-			if (part->hull) {
+			if (part->hull && marks && retained) {
+				vector<ImVec2> hull(part->hull_count);
+				for (int i = 0; i < part->hull_count; i++) hull[i] = ImVec2(part->hull[i].x, part->hull[i].y);
+				m_overlayMesh.AddPolyline(hull.data(), hull.size(), m_colors.partHullColor, true);
+			} else if (part->hull && marks) {
 				int i;
 				draw->PathClear();
 				for (i = 0; i < part->hull_count; i++) {
@@ -3366,22 +3270,29 @@ inline void BoardView::DrawParts(ImDrawList *draw) {
 			/*
 			 * Draw any icon/mark featuers to illustrate the part better
 			 */
-			if (part->component_type == part->kComponentTypeCapacitor) {
+			if (part->component_type == part->kComponentTypeCapacitor && marks) {
 				if (part->expanse > 90) {
 					int segments                = trunc(part->expanse);
 					if (segments < 8) segments  = 8;
 					if (segments > 36) segments = 36;
-					draw->AddCircle(CoordToScreen(part->centerpoint.x, part->centerpoint.y),
-					                (part->expanse / 3) * m_scale,
-					                m_colors.partOutlineColor & 0x8fffffff,
-					                segments);
+					if (retained) {
+						m_overlayMesh.AddCircle(ImVec2(part->centerpoint.x, part->centerpoint.y),
+						                        part->expanse / 3,
+						                        m_colors.partOutlineColor & 0x8fffffff,
+						                        segments);
+					} else {
+						draw->AddCircle(CoordToScreen(part->centerpoint.x, part->centerpoint.y),
+						                (part->expanse / 3) * m_scale,
+						                m_colors.partOutlineColor & 0x8fffffff,
+						                segments);
+					}
 				}
 			}
 
 			/*
 			 * Draw the text associated with the box or pins if required
 			 */
-			if (PartIsHighlighted(*part) && !part->is_dummy() && !part->name.empty()) {
+			if (highlighted && !part->is_dummy() && !part->name.empty()) {
 				std::string text  = part->name;
 				std::string mcode = part->mfgcode;
 
@@ -3400,6 +3311,7 @@ inline void BoardView::DrawParts(ImDrawList *draw) {
 
 				pos.x -= text_size.x * 0.5f;
 				draw->ChannelsSetCurrent(kChannelText);
+				BeginAnchor(draw, ImVec2((a.x + c.x) * 0.5f, top_y));
 
 				// This is the background of the part text.
 				draw->AddRectFilled(ImVec2(pos.x - DPIF(2.0f), pos.y - DPIF(2.0f)),
@@ -3416,124 +3328,199 @@ inline void BoardView::DrawParts(ImDrawList *draw) {
 					                    0.0f);
 					draw->AddText(ImVec2(pos.x, pos.y), m_colors.annotationPopupTextColor, mcode.c_str());
 				}
+				EndAnchor(draw);
 				draw->ChannelsSetCurrent(kChannelPolylines);
 			}
 		}
 	} // for each part
+
+	if (retained) AddOverlay(draw);
 }
 
-void BoardView::DrawPartTooltips(ImDrawList *draw) {
+/*
+ * Finds the test pad and parts under the mouse, and the pin of each part it is
+ * over, for DrawPartTooltips() and ShowTooltips(). True if they changed.
+ */
+bool BoardView::UpdateHover(void) {
 	ImVec2 spos = ImGui::GetMousePos();
 	ImVec2 pos  = ScreenToCoord(spos.x, spos.y);
 
+	Pin *testpad_was = m_testPadHovered;
+	auto parts_was   = std::move(m_partsHovered);
+	m_partsHovered.clear();
+
 	/*
  * I am loathing that I have to add this, but basically check every pin on the board so we can
  * determine if we're hovering over a testpad
  */
-	for (auto p : m_board->Pins()) {
-		auto pin = p.get();
-		if (pin->type == Pin::kPinTypeTestPad) {
+	const PinTable &table = m_board->PinData();
+	uint32_t testpad      = UINT32_MAX; // First one in board order
+	m_board->PinGrid().QueryRadius(pos.x, pos.y, m_board->MaxPinDiameter(), [&](uint32_t i) {
+		if (table.type[i] == Pin::kPinTypeTestPad && i < testpad) {
+			float dx   = table.position[i].x - pos.x;
+			float dy   = table.position[i].y - pos.y;
+			float dist = dx * dx + dy * dy;
+
+			if ((dist < (table.diameter[i] * table.diameter[i]))) testpad = i;
+		}
+	});
+	m_testPadHovered = testpad == UINT32_MAX ? nullptr : &m_board->PinSpan()[testpad];
+
+	currentlyHoveredPart = nullptr;
+	for (auto p_part : PartsAt(pos)) {
+		currentlyHoveredPart = p_part;
+		//			fprintf(stderr,"InPart: %s\n", currentlyHoveredPart->name.c_str());
+
+		float min_dist = m_pinDiameter / 2.0f;
+		min_dist *= min_dist; // all distance squared
+		currentlyHoveredPin = nullptr;
+
+		for (auto &pin : currentlyHoveredPart->pins) {
+			// auto p     = pin;
 			float dx   = pin->position.x - pos.x;
 			float dy   = pin->position.y - pos.y;
 			float dist = dx * dx + dy * dy;
-			if ((dist < (pin->diameter * pin->diameter))) {
-
-				draw->AddCircle(CoordToScreen(pin->position.x, pin->position.y),
-				                pin->diameter * m_scale,
-				                m_colors.pinHaloColor,
-				                32,
-				                pinHaloThickness);
-				ImGui::PushStyleColor(ImGuiCol_Text, ImColor(m_colors.annotationPopupTextColor));
-				ImGui::PushStyleColor(ImGuiCol_PopupBg, ImColor(m_colors.annotationPopupBackgroundColor));
-				ImGui::BeginTooltip();
-				ImGui::Text("TP[%s]%s", pin->number.c_str(), pin->net->name.c_str());
-				ImGui::EndTooltip();
-				ImGui::PopStyleColor(2);
-				break;
+			if ((dist < (pin->diameter * pin->diameter)) && (dist < min_dist)) {
+				currentlyHoveredPin = pin;
+				//					fprintf(stderr,"Pinhit: %s\n",pin->number.c_str());
+				min_dist = dist;
 			} // if in the required diameter
+		}     // for each pin in the part
+
+		m_partsHovered.push_back({currentlyHoveredPart, currentlyHoveredPin});
+	} // for each part hovered
+
+	return m_testPadHovered != testpad_was || m_partsHovered != parts_was;
+}
+
+// Halos and outlines of what UpdateHover() found under the mouse
+void BoardView::DrawPartTooltips(ImDrawList *draw) {
+	bool retained = RetainedBoard();
+
+	if (m_testPadHovered) {
+		Pin *pin = m_testPadHovered;
+
+		if (retained) {
+			m_overlayMesh.AddPin(
+			    ImVec2(pin->position.x, pin->position.y), pin->diameter, m_colors.pinHaloColor, BoardVertex::kShapeCircle);
+			AddOverlay(draw, pinHaloThickness);
+		} else {
+			draw->AddCircle(CoordToScreen(pin->position.x, pin->position.y),
+			                pin->diameter * m_scale,
+			                m_colors.pinHaloColor,
+			                32,
+			                pinHaloThickness);
 		}
 	}
 
-	currentlyHoveredPart = nullptr;
-	for (auto part : m_board->Components()) {
-		int hit     = 0;
-		auto p_part = part.get();
+	if (retained) {
+		// Outlines of the parts, then the halos of their pins over everything
+		for (auto &hovered : m_partsHovered) {
+			auto &part = *hovered.first;
+			if (!part.outline_done) continue;
 
-		if (!ComponentIsVisible(p_part)) continue;
+			ImVec2 quad[4];
+			for (int i = 0; i < 4; i++) quad[i] = ImVec2(part.outline[i].x, part.outline[i].y);
+			m_overlayMesh.AddPolyline(quad, 4, m_colors.partHighlightedColor, true);
+		}
+		AddOverlay(draw, 2);
+
+		draw->ChannelsSetCurrent(kChannelAnnotations);
+		for (auto &hovered : m_partsHovered) {
+			Pin *pin = hovered.second;
+			if (pin) {
+				m_overlayMesh.AddPin(
+				    ImVec2(pin->position.x, pin->position.y), pin->diameter, m_colors.pinHaloColor, BoardVertex::kShapeCircle);
+			}
+		}
+		AddOverlay(draw, pinHaloThickness);
+		return;
+	}
 
-		// Work out if the point is inside the hull
-		{
-			int i, j, n;
-			outline_pt *poly;
+	for (auto &hovered : m_partsHovered) {
+		auto &part = *hovered.first;
+		Pin *pin   = hovered.second;
 
-			n    = 4;
-			poly = p_part->outline;
+		if (part.outline_done) {
 
-			for (i = 0, j = n - 1; i < n; j = i++) {
-				if (((poly[i].y > pos.y) != (poly[j].y > pos.y)) &&
-				    (pos.x < (poly[j].x - poly[i].x) * (pos.y - poly[i].y) / (poly[j].y - poly[i].y) + poly[i].x))
-					hit ^= 1;
-			}
+			/*
+			 * Draw the bounding box for the part
+			 */
+			ImVec2 a, b, c, d;
+
+			a = ImVec2(CoordToScreen(part.outline[0].x, part.outline[0].y));
+			b = ImVec2(CoordToScreen(part.outline[1].x, part.outline[1].y));
+			c = ImVec2(CoordToScreen(part.outline[2].x, part.outline[2].y));
+			d = ImVec2(CoordToScreen(part.outline[3].x, part.outline[3].y));
+			draw->AddQuad(a, b, c, d, m_colors.partHighlightedColor, 2);
 		}
 
-		// If we're inside a part
-		if (hit) {
-			currentlyHoveredPart = p_part;
-			//			fprintf(stderr,"InPart: %s\n", currentlyHoveredPart->name.c_str());
-			if (part->outline_done) {
+		draw->ChannelsSetCurrent(kChannelAnnotations);
 
-				/*
-				 * Draw the bounding box for the part
-				 */
-				ImVec2 a, b, c, d;
+		if (pin)
+			draw->AddCircle(CoordToScreen(pin->position.x, pin->position.y),
+			                pin->diameter * m_scale,
+			                m_colors.pinHaloColor,
+			                32,
+			                pinHaloThickness);
+	}
+}
 
-				a = ImVec2(CoordToScreen(part->outline[0].x, part->outline[0].y));
-				b = ImVec2(CoordToScreen(part->outline[1].x, part->outline[1].y));
-				c = ImVec2(CoordToScreen(part->outline[2].x, part->outline[2].y));
-				d = ImVec2(CoordToScreen(part->outline[3].x, part->outline[3].y));
-				draw->AddQuad(a, b, c, d, m_colors.partHighlightedColor, 2);
-			}
+/*
+ * Tooltips for the test pad, parts and annotations under the mouse. They are
+ * windows of their own, so they go in on every frame, whether or not the board
+ * is drawn again.
+ */
+void BoardView::ShowTooltips(void) {
+	ImGui::PushStyleColor(ImGuiCol_Text, ImColor(m_colors.annotationPopupTextColor));
+	ImGui::PushStyleColor(ImGuiCol_PopupBg, ImColor(m_colors.annotationPopupBackgroundColor));
+
+	if (m_testPadHovered) {
+		Pin *pin = m_testPadHovered;
+		ImGui::BeginTooltip();
+		ImGui::Text("TP[%s]%s", pin->number.c_str(), pin->net->name.c_str());
+		ImGui::EndTooltip();
+	}
+
+	for (auto &hovered : m_partsHovered) {
+		ImGui::BeginTooltip();
+		if (hovered.second) {
+			ImGui::Text("%s\n[%s]%s",
+			            hovered.first->name.c_str(),
+			            hovered.second->number.c_str(),
+			            hovered.second->net->name.c_str());
+		} else {
+			ImGui::Text("%s", hovered.first->name.c_str());
+		}
+		ImGui::EndTooltip();
+	}
+
+	if (showAnnotations && m_tooltips_enabled) {
+		for (auto &ann : m_annotations.annotations) {
+			if (ann.side != m_current_side || !ann.hovered) continue;
+
+			char buf[60];
+
+			snprintf(buf, sizeof(buf), "%s", ann.note.c_str());
+			buf[50] = '\0';
 
-			float min_dist = m_pinDiameter / 2.0f;
-			min_dist *= min_dist; // all distance squared
-			currentlyHoveredPin = nullptr;
-
-			for (auto &pin : currentlyHoveredPart->pins) {
-				// auto p     = pin;
-				float dx   = pin->position.x - pos.x;
-				float dy   = pin->position.y - pos.y;
-				float dist = dx * dx + dy * dy;
-				if ((dist < (pin->diameter * pin->diameter)) && (dist < min_dist)) {
-					currentlyHoveredPin = pin;
-					//					fprintf(stderr,"Pinhit: %s\n",pin->number.c_str());
-					min_dist = dist;
-				} // if in the required diameter
-			}     // for each pin in the part
-
-			draw->ChannelsSetCurrent(kChannelAnnotations);
-
-			if (currentlyHoveredPin)
-				draw->AddCircle(CoordToScreen(currentlyHoveredPin->position.x, currentlyHoveredPin->position.y),
-				                currentlyHoveredPin->diameter * m_scale,
-				                m_colors.pinHaloColor,
-				                32,
-				                pinHaloThickness);
-			ImGui::PushStyleColor(ImGuiCol_Text, ImColor(m_colors.annotationPopupTextColor));
-			ImGui::PushStyleColor(ImGuiCol_PopupBg, ImColor(m_colors.annotationPopupBackgroundColor));
 			ImGui::BeginTooltip();
-			if (currentlyHoveredPin) {
-				ImGui::Text("%s\n[%s]%s",
-				            currentlyHoveredPart->name.c_str(),
-				            (currentlyHoveredPin ? currentlyHoveredPin->number.c_str() : " "),
-				            (currentlyHoveredPin ? currentlyHoveredPin->net->name.c_str() : " "));
-			} else {
-				ImGui::Text("%s", currentlyHoveredPart->name.c_str());
-			}
+			ImGui::Text("%c(%0.0f,%0.0f) %s %s%c%s%c\n%s%s",
+			            m_current_side ? 'B' : 'T',
+			            ann.x,
+			            ann.y,
+			            ann.net.c_str(),
+			            ann.part.c_str(),
+			            ann.part.size() && ann.pin.size() ? '[' : ' ',
+			            ann.pin.c_str(),
+			            ann.part.size() && ann.pin.size() ? ']' : ' ',
+			            buf,
+			            ann.note.size() > 50 ? "..." : "");
 			ImGui::EndTooltip();
-			ImGui::PopStyleColor(2);
 		}
+	}
 
-	} // for each part on the board
+	ImGui::PopStyleColor(2);
 }
 
 inline void BoardView::DrawPinTooltips(ImDrawList *draw) {
@@ -3567,35 +3554,12 @@ inline void BoardView::DrawAnnotations(ImDrawList *draw) {
 			a.y -= annotationBoxOffset;
 			b = ImVec2(a.x + annotationBoxSize, a.y - annotationBoxSize);
 
-			if ((ann.hovered == true) && (m_tooltips_enabled)) {
-				char buf[60];
-
-				snprintf(buf, sizeof(buf), "%s", ann.note.c_str());
-				buf[50] = '\0';
-
-				ImGui::PushStyleColor(ImGuiCol_Text, ImColor(m_colors.annotationPopupTextColor));
-				ImGui::PushStyleColor(ImGuiCol_PopupBg, ImColor(m_colors.annotationPopupBackgroundColor));
-				ImGui::BeginTooltip();
-				ImGui::Text("%c(%0.0f,%0.0f) %s %s%c%s%c\n%s%s",
-				            m_current_side ? 'B' : 'T',
-				            ann.x,
-				            ann.y,
-				            ann.net.c_str(),
-				            ann.part.c_str(),
-				            ann.part.size() && ann.pin.size() ? '[' : ' ',
-				            ann.pin.c_str(),
-				            ann.part.size() && ann.pin.size() ? ']' : ' ',
-				            buf,
-				            ann.note.size() > 50 ? "..." : "");
-
-				ImGui::EndTooltip();
-				ImGui::PopStyleColor(2);
-			} else {
-			}
+			BeginAnchor(draw, s);
 			draw->AddCircleFilled(s, DPIF(2), m_colors.annotationStalkColor, 8);
 			draw->AddRectFilled(a, b, m_colors.annotationBoxColor);
 			draw->AddRect(a, b, m_colors.annotationStalkColor);
 			draw->AddLine(s, a, m_colors.annotationStalkColor);
+			EndAnchor(draw);
 		}
 	}
 }
@@ -3621,15 +3585,21 @@ bool BoardView::HighlightedPinIsHovered(void) {
 	/*
 	 * See if any of the pins in the same network as the SELECTED pin (single) are hovered
 	 */
-	for (auto pin : m_board->Pins()) {
-		auto p   = pin.get();
-		double r = p->diameter / 2.0f * m_scale;
-		if (m_pinSelected && p->net == m_pinSelected->net) {
-			ImVec2 a = ImVec2(p->position.x, p->position.y);
-			if ((mpc.x > a.x - r) && (mpc.x < a.x + r) && (mpc.y > a.y - r) && (mpc.y < a.y + r)) {
-				m_pinHighlightedHovered = p;
-				return true;
+	if (m_pinSelected) {
+		uint32_t hovered = UINT32_MAX; // First one in board order
+		Span<Pin> pins   = m_board->PinSpan();
+		m_board->PinGrid().QueryRadius(mpc.x, mpc.y, m_board->MaxPinDiameter() / 2.0f * m_scale, [&](uint32_t i) {
+			Pin *p   = &pins[i];
+			double r = p->diameter / 2.0f * m_scale;
+			if (i < hovered && p->net == m_pinSelected->net) {
+				ImVec2 a = ImVec2(p->position.x, p->position.y);
+
+				if ((mpc.x > a.x - r) && (mpc.x < a.x + r) && (mpc.y > a.y - r) && (mpc.y < a.y + r)) hovered = i;
 			}
+		});
+		if (hovered != UINT32_MAX) {
+			m_pinHighlightedHovered = &pins[hovered];
+			return true;
 		}
 	}
 
@@ -3653,23 +3623,39 @@ bool BoardView::HighlightedPinIsHovered(void) {
 int BoardView::AnnotationIsHovered(void) {
 	ImVec2 mp       = ImGui::GetMousePos();
 	bool is_hovered = false;
-	int i           = 0;
+	auto &list      = m_annotations.annotations;
 
 	m_annotation_last_hovered = 0;
 
-	for (auto &ann : m_annotations.annotations) {
-		ImVec2 a = CoordToScreen(ann.x, ann.y);
-		if ((mp.x > a.x + annotationBoxOffset) && (mp.x < a.x + (annotationBoxOffset + annotationBoxSize)) &&
-		    (mp.y < a.y - annotationBoxOffset) && (mp.y > a.y - (annotationBoxOffset + annotationBoxSize))) {
-			ann.hovered               = true;
-			is_hovered                = true;
-			m_annotation_last_hovered = i;
-		} else {
+	if (m_annotationGridDirty) {
+		std::vector<GridBox> boxes;
+		for (auto &ann : list) {
 			ann.hovered = false;
+			boxes.push_back(GridBox{float(ann.x), float(ann.y), float(ann.x), float(ann.y)});
 		}
-		i++;
+		m_annotationGrid.Build(boxes);
+		m_annotationsHovered.clear();
+		m_annotationGridDirty = false;
 	}
 
+	for (auto i : m_annotationsHovered) list[i].hovered = false;
+	m_annotationsHovered.clear();
+
+	// The box of an annotation is off its anchor by a fixed amount on screen, look for anchors that far from the mouse
+	ImVec2 a0 = ScreenToCoord(mp.x - (annotationBoxOffset + annotationBoxSize), mp.y + annotationBoxOffset);
+	ImVec2 a1 = ScreenToCoord(mp.x - annotationBoxOffset, mp.y + (annotationBoxOffset + annotationBoxSize));
+	m_annotationGrid.Query(
+	    std::min(a0.x, a1.x), std::min(a0.y, a1.y), std::max(a0.x, a1.x), std::max(a0.y, a1.y), [&](uint32_t i) {
+		    ImVec2 a = CoordToScreen(list[i].x, list[i].y);
+		    if ((mp.x > a.x + annotationBoxOffset) && (mp.x < a.x + (annotationBoxOffset + annotationBoxSize)) &&
+		        (mp.y < a.y - annotationBoxOffset) && (mp.y > a.y - (annotationBoxOffset + annotationBoxSize))) {
+			    list[i].hovered = true;
+			    is_hovered      = true;
+			    m_annotationsHovered.push_back(i);
+			    m_annotation_last_hovered = std::max<int>(m_annotation_last_hovered, i);
+		    }
+	    });
+
 	if (is_hovered == false) m_annotation_clicked_id = -1;
 
 	return is_hovered;
@@ -3694,40 +3680,266 @@ void BoardView::DrawSelectedPins(ImDrawList *draw) {
 	}
 }
 
+/*
+ * Tessellates the outline, parts and pins as DrawOutline(), DrawParts() and
+ * DrawPins() draw them when nothing about them is highlighted, in board
+ * coordinates. Only done again when the board moves or what they look like
+ * does, not as the view changes or a selection masks their colours.
+ */
+void BoardView::UpdateBoardMesh() {
+	BoardMeshState state;
+	state.side        = m_current_side;
+	state.board_fill  = boardFill;
+	state.fill_parts  = fillParts;
+	state.show_pins   = showPins;
+	state.square_pins = pinShapeSquare || slowCPU;
+	state.colors      = m_colors;
+	if (!m_boardMeshDirty && state == m_boardMeshState) return;
+
+	m_boardMeshState = state;
+	m_boardMeshDirty = false;
+	m_boardMesh.Clear();
+	m_pinlessParts.clear();
+
+	// The fill is striped by the renderer, see DrawBoard()
+	if (boardFill) {
+		OutlineTrapezoids(m_board->OutlinePoints(),
+		                  [&](const ImVec2 quad[4]) { m_boardMesh.AddQuadFilled(quad, m_colors.boardFillColor); });
+	}
+
+	m_boardMeshFill.mesh  = &m_boardMesh;
+	m_boardMeshFill.first = 0;
+	m_boardMeshFill.count = m_boardMesh.size();
+
+	// Colours are masked as the selection calls for when the mesh is drawn, see DrawBoard()
+	m_boardMesh.mask = BoardVertex::kMaskOutline;
+	OutlineSegments(m_board->OutlinePoints(), [&](const Point &pa, const Point &pb) {
+		m_boardMesh.AddLine(ImVec2(pa.x, pa.y), ImVec2(pb.x, pb.y), m_colors.boardOutlineColor);
+	});
+
+	Span<Component> components = m_board->ComponentSpan();
+	for (uint32_t c = 0; c < components.size(); c++) {
+		Component *part = &components[c];
+
+		if (!ComponentIsVisible(part) || part->is_dummy()) continue;
+		if (part->pins.size() == 0) {
+			ImVec2 a       = ImVec2(part->p1.x + DPIF(10), part->p1.y + DPIF(10));
+			ImVec2 b       = ImVec2(part->p2.x - DPIF(10), part->p2.y - DPIF(10));
+			ImVec2 rect[4] = {a, ImVec2(b.x, a.y), b, ImVec2(a.x, b.y)};
+
+			m_boardMesh.mask = BoardVertex::kMaskNone;
+			m_boardMesh.AddPolyline(rect, 4, 0xff0000ff, true);
+			m_pinlessParts.push_back(c);
+			continue;
+		}
+		if (!part->outline_done) continue;
+
+		ImVec2 quad[4];
+		for (int i = 0; i < 4; i++) quad[i] = ImVec2(part->outline[i].x, part->outline[i].y);
+
+		m_boardMesh.mask = BoardVertex::kMaskNone;
+		if (fillParts) m_boardMesh.AddQuadFilled(quad, m_colors.partFillColor);
+		m_boardMesh.mask = BoardVertex::kMaskParts;
+		m_boardMesh.AddPolyline(quad, 4, m_colors.partOutlineColor, true);
+		m_boardMesh.mask = BoardVertex::kMaskNone;
+
+		if (part->hull) {
+			vector<ImVec2> hull(part->hull_count);
+			for (int i = 0; i < part->hull_count; i++) hull[i] = ImVec2(part->hull[i].x, part->hull[i].y);
+			m_boardMesh.AddPolyline(hull.data(), hull.size(), m_colors.partHullColor, true);
+		}
+
+		if (part->component_type == part->kComponentTypeCapacitor && part->expanse > 90) {
+			int segments                = trunc(part->expanse);
+			if (segments < 8) segments  = 8;
+			if (segments > 36) segments = 36;
+			m_boardMesh.AddCircle(ImVec2(part->centerpoint.x, part->centerpoint.y),
+			                      part->expanse / 3,
+			                      m_colors.partOutlineColor & 0x8fffffff,
+			                      segments);
+		}
+	}
+
+	m_boardMeshParts.mesh  = &m_boardMesh;
+	m_boardMeshParts.first = m_boardMeshFill.count;
+	m_boardMeshParts.count = m_boardMesh.size() - m_boardMeshParts.first;
+
+	// Pins keep their size on the board, the shader leaving out those under the threshold
+	if (showPins) {
+		const PinTable &table = m_board->PinData();
+		auto pins             = m_board->PinSpan();
+		uint8_t shape         = state.square_pins ? BoardVertex::kShapeSquare : BoardVertex::kShapeCircle;
+		m_boardMesh.mask      = BoardVertex::kMaskPins;
+
+		for (uint32_t i = 0; i < pins.size(); i++) {
+			if (!SideIsVisible(table.side[i])) continue;
+
+			Pin *pin       = &pins[i];
+			ImVec2 pos     = ImVec2(table.position[i].x, table.position[i].y);
+			uint32_t color = m_colors.pinDefaultColor;
+
+			if (!pin->net || pin->type == Pin::kPinTypeNotConnected) {
+				color = m_colors.pinNotConnectedColor;
+			} else {
+				if (pin->net->is_ground) color = m_colors.pinGroundColor;
+			}
+
+			if (pin->type == Pin::kPinTypeTestPad) {
+				m_boardMesh.AddPin(pos, table.diameter[i], m_colors.pinTestPadFillColor, BoardVertex::kShapeDisc);
+				m_boardMesh.AddPin(pos, table.diameter[i], m_colors.pinTestPadColor, BoardVertex::kShapeCircle);
+			} else {
+				m_boardMesh.AddPin(pos, table.diameter[i], color, shape);
+			}
+		}
+	}
+
+	m_boardMeshPins.mesh  = &m_boardMesh;
+	m_boardMeshPins.first = m_boardMeshParts.first + m_boardMeshParts.count;
+	m_boardMeshPins.count = m_boardMesh.size() - m_boardMeshPins.first;
+}
+
+// Draws the overlay added since the last range as one more, in the current channel
+void BoardView::AddOverlay(ImDrawList *draw, float line_width, float pad) {
+	if (m_overlayMesh.size() == m_overlayFirst) return;
+
+	m_overlayRanges.emplace_back();
+	BoardMeshRange &range = m_overlayRanges.back();
+	range.mesh            = &m_overlayMesh;
+	range.first           = m_overlayFirst;
+	range.count           = m_overlayMesh.size() - m_overlayFirst;
+	range.line_width      = line_width;
+	range.pad             = pad;
+	m_overlayFirst        = m_overlayMesh.size();
+	draw->AddCallback(m_boardMeshCallback, &range);
+}
+
+// What is drawn between these two is anchored to the board point under screen, see DrawBoard()
+void BoardView::BeginAnchor(ImDrawList *draw, ImVec2 screen) {
+	Anchor anchor;
+	anchor.first = draw->VtxBuffer.Size;
+	anchor.count = 0;
+	anchor.at    = ScreenToCoord(screen.x, screen.y);
+	m_anchors.push_back(anchor);
+}
+
+void BoardView::EndAnchor(ImDrawList *draw) {
+	Anchor &anchor = m_anchors.back();
+	ImVec2 s       = CoordToScreen(anchor.at.x, anchor.at.y);
+	anchor.count   = draw->VtxBuffer.Size - anchor.first;
+	for (int i = anchor.first; i < draw->VtxBuffer.Size; i++) {
+		draw->VtxBuffer[i].pos.x -= s.x;
+		draw->VtxBuffer[i].pos.y -= s.y;
+	}
+}
+
+// Adds the commands of from to the end of draw in its clip rect, with their vertices and callbacks, returning where those went
+static unsigned int AppendDrawList(ImDrawList *draw, const ImDrawList &from) {
+	unsigned int base = draw->_VtxCurrentIdx;
+	draw->PrimReserve(0, from.VtxBuffer.Size);
+	memcpy(draw->_VtxWritePtr, from.VtxBuffer.Data, from.VtxBuffer.Size * sizeof(ImDrawVert));
+	draw->_VtxWritePtr += from.VtxBuffer.Size;
+	draw->_VtxCurrentIdx += from.VtxBuffer.Size;
+
+	const ImDrawIdx *idx = from.IdxBuffer.Data;
+	for (int i = 0; i < from.CmdBuffer.Size; i++) {
+		const ImDrawCmd &cmd = from.CmdBuffer[i];
+		draw->PushTextureID(cmd.TextureId);
+		if (cmd.UserCallback) {
+			draw->AddCallback(cmd.UserCallback, cmd.UserCallbackData);
+		} else if (cmd.ElemCount) {
+			draw->PrimReserve(cmd.ElemCount, 0);
+			for (unsigned int e = 0; e < cmd.ElemCount; e++) draw->_IdxWritePtr[e] = (ImDrawIdx)(base + idx[e]);
+			draw->_IdxWritePtr += cmd.ElemCount;
+			idx += cmd.ElemCount;
+		}
+		draw->PopTextureID();
+	}
+	return base;
+}
+
 void BoardView::DrawBoard() {
-	if (!m_file || !m_board) return;
+	if (!m_board) return;
+
+	ImDrawList *draw                 = ImGui::GetWindowDrawList();
+	if (UpdateHover()) m_needsRedraw = true;
+
+	if (RetainedBoard()) {
+		// The renderer draws the meshes where the view puts them on every frame, whether or not the rest is drawn again
+		UpdateBoardMesh();
+		m_boardMesh.origin      = CoordToScreen(0, 0);
+		m_boardMesh.axis_x      = CoordToScreen(1, 0, 0);
+		m_boardMesh.axis_y      = CoordToScreen(0, 1, 0);
+		m_boardMesh.scale       = m_scale;
+		m_boardMeshFill.stripes = boardFillSpacing;
+		m_overlayMesh.origin    = m_boardMesh.origin;
+		m_overlayMesh.axis_x    = m_boardMesh.axis_x;
+		m_overlayMesh.axis_y    = m_boardMesh.axis_y;
+		m_overlayMesh.scale     = m_scale;
+
+		// Selecting a pin fades out the rest, as in DrawOutline(), DrawParts() and DrawPins()
+		bool masked = pinSelectMasks && (m_pinSelected || m_pinHighlighted.size());
+		m_boardMesh.SetMask(BoardVertex::kMaskOutline,
+		                    masked ? m_colors.selectedMaskOutline : 0xFFFFFFFF,
+		                    masked ? m_colors.orMaskOutline : 0x00000000);
+		m_boardMesh.SetMask(BoardVertex::kMaskParts,
+		                    masked ? m_colors.selectedMaskParts : 0xFFFFFFFF,
+		                    masked ? m_colors.orMaskParts : 0x00000000);
+		m_boardMesh.SetMask(BoardVertex::kMaskPins,
+		                    masked ? m_colors.selectedMaskPins : 0xFFFFFFFF,
+		                    masked ? m_colors.orMaskPins : 0x00000000);
+	}
 
-	ImDrawList *draw = ImGui::GetWindowDrawList();
-	if (!m_needsRedraw) {
-		memcpy(draw, m_cachedDrawList, sizeof(ImDrawList));
-		memcpy(draw->CmdBuffer.Data, m_cachedDrawCommands.Data, m_cachedDrawCommands.Size);
-		return;
+	if (m_needsRedraw) {
+		ImDrawList *board = &m_boardDrawList;
+		board->Clear();
+		m_overlayMesh.Clear();
+		m_overlayRanges.clear();
+		m_overlayFirst = 0;
+		m_anchors.clear();
+
+		// Nothing is clipped until the list goes into the window, as anchored text may be moved into view
+		board->PushClipRect(ImVec2(-FLT_MAX, -FLT_MAX), ImVec2(FLT_MAX, FLT_MAX));
+		board->PushTextureID(ImGui::GetIO().Fonts->TexID);
+
+		// Splitting channels, drawing onto those and merging back.
+		board->ChannelsSplit(NUM_DRAW_CHANNELS);
+
+		// We draw the Parts before the Pins so that we can ascertain the needed pin
+		// size for the parts based on the part/pad geometry and spacing. -Inflex
+		// OutlineGenerateFill();
+		//	DrawFill(board);
+		if (RetainedBoard()) {
+			// The fill, outline and parts are in the mesh, drawn here in the order of the channels
+			board->ChannelsSetCurrent(kChannelFill);
+			board->AddCallback(m_boardMeshCallback, &m_boardMeshFill);
+			board->ChannelsSetCurrent(kChannelPolylines);
+			board->AddCallback(m_boardMeshCallback, &m_boardMeshParts);
+		} else {
+			OutlineGenFillDraw(board, boardFillSpacing, 1);
+			DrawOutline(board);
+		}
+		DrawParts(board);
+		//	DrawSelectedPins(board);
+		DrawPins(board);
+		// DrawPinTooltips(board);
+		DrawPartTooltips(board);
+		DrawAnnotations(board);
+
+		board->ChannelsMerge();
+		m_needsRedraw = false;
 	}
 
-	// Splitting channels, drawing onto those and merging back.
-	draw->ChannelsSplit(NUM_DRAW_CHANNELS);
-
-	// We draw the Parts before the Pins so that we can ascertain the needed pin
-	// size for the parts based on the part/pad geometry and spacing. -Inflex
-	// OutlineGenerateFill();
-	//	DrawFill(draw);
-	OutlineGenFillDraw(draw, boardFillSpacing, 1);
-	DrawOutline(draw);
-	DrawParts(draw);
-	//	DrawSelectedPins(draw);
-	DrawPins(draw);
-	// DrawPinTooltips(draw);
-	DrawPartTooltips(draw);
-	DrawAnnotations(draw);
-
-	draw->ChannelsMerge();
-
-	// Copy the new draw list and cmd buffer:
-	memcpy(m_cachedDrawList, draw, sizeof(ImDrawList));
-	int cmds_size = draw->CmdBuffer.size() * sizeof(ImDrawCmd);
-	m_cachedDrawCommands.resize(cmds_size);
-	memcpy(m_cachedDrawCommands.Data, draw->CmdBuffer.Data, cmds_size);
-	m_needsRedraw = false;
+	// Anchored text and marks go where the view puts their board points now
+	unsigned int base = AppendDrawList(draw, m_boardDrawList);
+	for (auto &anchor : m_anchors) {
+		ImVec2 s = CoordToScreen(anchor.at.x, anchor.at.y);
+		for (int i = 0; i < anchor.count; i++) {
+			ImDrawVert &v = draw->VtxBuffer[base + anchor.first + i];
+			v.pos.x += s.x;
+			v.pos.y += s.y;
+		}
+	}
+	ShowTooltips();
 }
 /** end of drawing region **/
 
@@ -3758,20 +3970,19 @@ void BoardView::CenterView(void) {
 	//  m_rotation = 0;
 	m_scale_floor = m_scale = sx < sy ? sx : sy;
 	SetTarget(m_mx, m_my);
-	m_needsRedraw = true;
+	ViewMoved();
 }
 
-void BoardView::SetFile(BRDFile *file) {
-	delete m_file;
+void BoardView::SetFile(Board *board) {
 	delete m_board;
 
-	m_file  = file;
-	m_board = new BRDBoard(file);
+	m_board = board;
 
 	m_nets = m_board->Nets();
 
 	int min_x = INT_MAX, max_x = INT_MIN, min_y = INT_MAX, max_y = INT_MIN;
-	for (auto &pa : m_file->format) {
+	for (auto &point : m_board->OutlinePoints()) {
+		Point pa                = *point; // Whole numbers, as read from the file
 		if (pa.x < min_x) min_x = pa.x;
 		if (pa.y < min_y) min_y = pa.y;
 		if (pa.x > max_x) max_x = pa.x;
@@ -3794,12 +4005,13 @@ void BoardView::SetFile(BRDFile *file) {
 	m_boardHeight           = max_y - min_y;
 	SetTarget(m_mx, m_my);
 
-	m_pinHighlighted.reserve(m_board->Components().size());
-	m_partHighlighted.reserve(m_board->Components().size());
+	m_pinHighlighted.Reset(m_board->PinSpan());
+	m_partHighlighted.Reset(m_board->ComponentSpan());
 	m_pinSelected = nullptr;
 
-	m_firstFrame  = true;
-	m_needsRedraw = true;
+	m_boardMeshDirty = true;
+	m_firstFrame     = true;
+	m_needsRedraw    = true;
 }
 
 ImVec2 BoardView::CoordToScreen(float x, float y, float w) {
@@ -3894,10 +4106,7 @@ void BoardView::Mirror(void) {
 		p->x = max.x - p->x;
 	}
 
-	for (auto pin : m_board->Pins()) {
-		auto p        = pin.get();
-		p->position.x = max.x - p->position.x;
-	}
+	for (auto &pin : m_board->PinSpan()) m_board->SetPinPosition(&pin, Point(max.x - pin.position.x, pin.position.y));
 
 	for (auto &part : m_board->Components()) {
 
@@ -3917,6 +4126,10 @@ void BoardView::Mirror(void) {
 	for (auto &ann : m_annotations.annotations) {
 		ann.x = max.x - ann.x;
 	}
+
+	m_board->IndexElements();
+	m_annotationGridDirty = true;
+	m_boardMeshDirty      = true;
 }
 
 void BoardView::SetTarget(float x, float y) {
@@ -3937,6 +4150,19 @@ inline bool BoardView::ComponentIsVisible(const Component *part) {
 	return false;
 }
 
+inline bool BoardView::SideIsVisible(uint8_t side) {
+	return side == m_current_side || side == kBoardSideBoth;
+}
+
+GridBox BoardView::ViewArea(float margin) {
+	// Rotation is in quarter turns, so opposite corners of the surface are opposite corners in board space too
+	ImVec2 a = ScreenToCoord(0, 0);
+	ImVec2 b = ScreenToCoord(m_board_surface.x, m_board_surface.y);
+
+	return GridBox{
+	    std::min(a.x, b.x) - margin, std::min(a.y, b.y) - margin, std::max(a.x, b.x) + margin, std::max(a.y, b.y) + margin};
+}
+
 inline bool BoardView::IsVisibleScreen(float x, float y, float radius, const ImGuiIO &io) {
 	// if (x < -radius || y < -radius || x - radius > io.DisplaySize.x || y - radius > io.DisplaySize.y) return false;
 	if (x < -radius || y < -radius || x - radius > m_board_surface.x || y - radius > m_board_surface.y) return false;
@@ -3944,7 +4170,7 @@ inline bool BoardView::IsVisibleScreen(float x, float y, float radius, const ImG
 }
 
 bool BoardView::PartIsHighlighted(const Component &component) {
-	bool highlighted = contains(component, m_partHighlighted);
+	bool highlighted = m_partHighlighted.contains(&component);
 
 	// is any pin of this part selected?
 	if (m_pinSelected) highlighted |= m_pinSelected->component == &component;
@@ -4011,14 +4237,14 @@ bool BoardView::strstrModeSearch(const char *haystack, const char *needle) {
 
 void BoardView::FindNetNoClear(const char *name) {
 
-	if (!m_file || !m_board || !(*name)) return;
+	if (!m_board || !(*name)) return;
 
 	if (*name) {
 
 		for (auto net : m_board->Nets()) {
 			if (strstrModeSearch(net->name.c_str(), name)) {
 				for (auto pin : net->pins) {
-					m_pinHighlighted.push_back(pin);
+					m_pinHighlighted.insert(pin);
 				}
 			}
 		}
@@ -4031,7 +4257,7 @@ void BoardView::FindNet(const char *name) {
 }
 
 void BoardView::FindComponentNoClear(const char *name) {
-	if (!m_file || !m_board || !name) return;
+	if (!m_board || !name) return;
 
 	if (*name) {
 		Component *part_found = nullptr;
@@ -4041,7 +4267,7 @@ void BoardView::FindComponentNoClear(const char *name) {
 
 			if (strstrModeSearch(haystack, name)) {
 				auto p = component.get();
-				m_partHighlighted.push_back(p);
+				m_partHighlighted.insert(p);
 				part_found = p;
 			}
 		}
@@ -4049,7 +4275,7 @@ void BoardView::FindComponentNoClear(const char *name) {
 		if (part_found != nullptr) {
 			//		if (m_partHighlighted.size()) {
 			for (auto pin : part_found->pins) {
-				m_pinHighlighted.push_back(pin);
+				m_pinHighlighted.insert(pin);
 			}
 		}
 		m_needsRedraw = true;
@@ -4057,7 +4283,7 @@ void BoardView::FindComponentNoClear(const char *name) {
 }
 
 void BoardView::FindComponent(const char *name) {
-	if (!m_file || !m_board) return;
+	if (!m_board) return;
 
 	m_pinHighlighted.clear();
 	m_partHighlighted.clear();
@@ -1,11 +1,17 @@
 #pragma once
 
 #include "Board.h"
+#include "BoardLoader.h"
+#include "BoardMesh.h"
+#include "PinGlyphs.h"
+#include "Renderers/StreamBuffer.h"
 #include "annotations.h"
 #include "confparse.h"
 #include "history.h"
 #include "imgui/imgui.h"
+#include <deque>
 #include <stdint.h>
+#include <string.h>
 #include <vector>
 
 #define DPIF(x) (((x)*dpi) / 100.f)
@@ -15,14 +21,14 @@ struct BRDPart;
 class BRDFile;
 
 struct BitVec {
-	uint32_t *m_bits;
+	uint32_t *m_bits = nullptr;
 	// length of the BitVec in bits
-	uint32_t m_size;
+	uint32_t m_size = 0;
 
 	~BitVec();
 	void Resize(uint32_t new_size);
 
-	bool operator[](uint32_t index) {
+	bool operator[](uint32_t index) const {
 		return 0 != (m_bits[index >> 5] & (1u << (index & 0x1f)));
 	}
 
@@ -36,13 +42,87 @@ struct BitVec {
 	}
 
 	void Clear() {
-		uint32_t num_ints = m_size >> 5;
+		uint32_t num_ints = (m_size + 31) >> 5;
 		for (uint32_t i = 0; i < num_ints; i++) {
 			m_bits[i] = 0;
 		}
 	}
 };
 
+/*
+ * Pins or parts of the board picked out by a search or click. Membership is
+ * a bit per element, so testing, adding and removing one is O(1) whatever
+ * the size; the members are also listed, for going through them without
+ * touching the rest of the board, and each remembers its place in the list.
+ */
+template <class T>
+class ElementSet {
+  public:
+	// Empties the set and sizes it for elements, those of the current board
+	void Reset(Span<T> elements) {
+		clear();
+		m_first = elements.begin();
+		m_in.Resize(elements.size());
+		m_in.Clear();
+		m_slot.resize(elements.size());
+	}
+
+	bool contains(const T *element) const {
+		uint32_t i = Index(element);
+		return i != UINT32_MAX && m_in[i];
+	}
+
+	// Adds element unless it is in already
+	void insert(T *element) {
+		if (contains(element)) return;
+		uint32_t i = Index(element);
+		m_in.Set(i, true);
+		m_slot[i] = m_list.size();
+		m_list.push_back(element);
+	}
+
+	// The last member takes the place of element, so the rest do not keep their order
+	void erase(T *element) {
+		if (!contains(element)) return;
+		uint32_t i    = Index(element);
+		uint32_t slot = m_slot[i];
+		T *last       = m_list.back();
+		m_in.Set(i, false);
+		m_list[slot]        = last;
+		m_slot[Index(last)] = slot;
+		m_list.pop_back();
+	}
+
+	// Only the members' bits are cleared
+	void clear() {
+		for (auto element : m_list) m_in.Set(Index(element), false);
+		m_list.clear();
+	}
+
+	size_t size() const {
+		return m_list.size();
+	}
+	typename vector<T *>::const_iterator begin() const {
+		return m_list.begin();
+	}
+	typename vector<T *>::const_iterator end() const {
+		return m_list.end();
+	}
+
+  private:
+	// UINT32_MAX for anything outside the elements, null included
+	uint32_t Index(const T *element) const {
+		if (!m_first || element < m_first) return UINT32_MAX;
+		size_t i = element - m_first;
+		return i < m_in.m_size ? uint32_t(i) : UINT32_MAX;
+	}
+
+	T *m_first = nullptr;
+	BitVec m_in;
+	vector<uint32_t> m_slot; // Of each member in m_list, by Index()
+	vector<T *> m_list;
+};
+
 struct ColorScheme {
 	/*
 	 * Take note, because these are directly set
@@ -91,6 +171,22 @@ struct ColorScheme {
 	uint32_t orMaskOutline = 0x00000000;
 };
 
+// What the board mesh was built for, it is built again when any of it changes
+struct BoardMeshState {
+	int side         = -1;
+	bool board_fill  = false;
+	bool fill_parts  = false;
+	bool show_pins   = false;
+	bool square_pins = false;
+	ColorScheme colors;
+
+	bool operator==(const BoardMeshState &other) const {
+		return side == other.side && board_fill == other.board_fill && fill_parts == other.fill_parts &&
+		       show_pins == other.show_pins && square_pins == other.square_pins &&
+		       memcmp(&colors, &other.colors, sizeof(ColorScheme)) == 0;
+	}
+};
+
 // enum DrawChannel { kChannelImages = 0, kChannelFill, kChannelPolylines = 1, kChannelPins = 2, kChannelText = 3,
 // kChannelAnnotations = 4, NUM_DRAW_CHANNELS = 5 };
 enum DrawChannel {
@@ -107,7 +203,6 @@ enum FlipModes { flipModeVP = 0, flipModeMP = 1, NUM_FLIP_MODES };
 enum SearchModes { searchModeSub, searchModePrefix, searchModeWhole };
 
 struct BoardView {
-	BRDFile *m_file;
 	Board *m_board;
 
 	Confparse obvconfig;
@@ -131,6 +226,7 @@ struct BoardView {
 	bool pinSelectMasks       = true;
 	bool slowCPU              = false;
 	bool showFPS              = false;
+	bool boardCache           = true;
 	bool showNetWeb           = true;
 	bool showInfoPanel        = true;
 	bool showPins             = true;
@@ -157,6 +253,18 @@ struct BoardView {
 	void DrawDiamond(ImDrawList *draw, ImVec2 c, double r, uint32_t color);
 	void DrawHex(ImDrawList *draw, ImVec2 c, double r, uint32_t color);
 	void DrawBox(ImDrawList *draw, ImVec2 c, double r, uint32_t color);
+
+	// Pin shapes as quads from the font texture, when the renderer can draw them
+	PinGlyphAtlas m_pinGlyphs;
+	// Draws a pin shape of radius r, from m_pinGlyphs if baked or tessellated with segments and thickness
+	void DrawPinShape(ImDrawList *draw,
+	                  ImVec2 c,
+	                  float r,
+	                  PinGlyph glyph,
+	                  bool filled,
+	                  uint32_t color,
+	                  int segments    = 12,
+	                  float thickness = 1.0f);
 	void SetFZKey(const char *keytext);
 	void HelpAbout(void);
 	void HelpControls(void);
@@ -169,11 +277,11 @@ struct BoardView {
 	void ThemeSetStyle(const char *name);
 
 	bool m_centerZoomNets = true;
-	void CenterZoomNet(string netname);
+	void CenterZoomNet(const Net *net);
 
 	bool m_centerZoomSearchResults = true;
 	void CenterZoomSearchResults(void);
-	int EPCCheck(void);
+	static int EPCCheck(Board *board, bool debug);
 	void OutlineGenFillDraw(ImDrawList *draw, int ydelta, double thickness);
 
 	/* Context menu, sql stuff */
@@ -189,6 +297,64 @@ struct BoardView {
 	int m_hoverframes             = 0;
 	ImVec2 m_previous_mouse_pos;
 
+	// Annotations by anchor, rebuilt on the next hover test once the list or positions change
+	SpatialGrid m_annotationGrid;
+	bool m_annotationGridDirty = true;
+	vector<uint32_t> m_annotationsHovered; // Indices with hovered set
+
+	// Pins or parts around the view, reused by each redraw, and how many of them were visited and drawn on the last one
+	vector<uint32_t> m_inView;
+	uint32_t m_pinsVisited = 0, m_pinsDrawn = 0;
+	uint32_t m_partsVisited = 0, m_partsDrawn = 0;
+
+	/*
+	 * Fill, outline, parts and pins tessellated once and kept by the renderer,
+	 * which draws them with the view as a transform through m_boardMeshCallback
+	 * when it has one. Redraws then only add what selection or highlighting
+	 * changes on top of them, and moving about needs none.
+	 */
+	ImDrawCallback m_boardMeshCallback = nullptr;
+	BoardMesh m_boardMesh;
+	BoardMeshRange m_boardMeshFill, m_boardMeshParts, m_boardMeshPins; // Fill, outline and parts, then pins
+	BoardMeshState m_boardMeshState;
+	bool m_boardMeshDirty = true;    // Board geometry moved
+	vector<uint32_t> m_pinlessParts; // Their names are drawn on each redraw
+	void UpdateBoardMesh();
+	bool RetainedBoard() {
+		return m_boardMeshCallback && m_board;
+	}
+
+	// Panning and zooming, which the retained board follows without being drawn again
+	void ViewMoved() {
+		if (!RetainedBoard()) m_needsRedraw = true;
+	}
+
+	/*
+	 * Highlights, selections and what is hovered, in board coordinates and
+	 * drawn with the view of m_boardMesh. Built again on each redraw, each of
+	 * its ranges going in where AddOverlay() was called.
+	 */
+	BoardMesh m_overlayMesh;
+	std::deque<BoardMeshRange> m_overlayRanges; // Callback data, so they must stay put
+	uint32_t m_overlayFirst = 0;                // Vertex the next range starts at
+	void AddOverlay(ImDrawList *draw, float line_width = 1, float pad = 0);
+
+	/*
+	 * Text and marks of m_boardDrawList that keep their size in pixels are
+	 * recorded relative to a board point, and moved to where the view puts
+	 * it whenever the list goes into the window.
+	 */
+	struct Anchor {
+		int first, count; // Vertices
+		ImVec2 at;
+	};
+	vector<Anchor> m_anchors;
+	void BeginAnchor(ImDrawList *draw, ImVec2 screen);
+	void EndAnchor(ImDrawList *draw);
+
+	// Upload counters of the renderer's streamed draw lists, if it keeps them
+	const StreamStats *m_streamStats = nullptr;
+
 	/* Info/Side Pane */
 	void ShowInfoPane(void);
 
@@ -197,13 +363,17 @@ struct BoardView {
 	Pin *currentlyHoveredPin        = nullptr;
 	Component *currentlyHoveredPart = nullptr;
 
+	// Parts under the mouse with the pin of each it is over, and the test pad it is over
+	vector<std::pair<Component *, Pin *>> m_partsHovered;
+	Pin *m_testPadHovered = nullptr;
+	bool UpdateHover(void);
+	void ShowTooltips(void);
+
 	ImVec2 m_showContextMenuPos;
 
 	Pin *m_pinSelected = nullptr;
-	vector<Pin *> m_pinHighlighted;
-	vector<Component *> m_partHighlighted;
-	char m_cachedDrawList[sizeof(ImDrawList)];
-	ImVector<char> m_cachedDrawCommands;
+	ElementSet<Pin> m_pinHighlighted;
+	ElementSet<Component> m_partHighlighted;
 	SharedVector<Net> m_nets;
 	char m_search[128];
 	char m_search2[128];
@@ -241,10 +411,10 @@ struct BoardView {
 	// Annotation layer specific
 	bool m_annotationsVisible = true;
 
-	// Do a hacky thing (memcpy the window draw list) to save us from rerendering
-	// the board
-	// The app will crash or break if this flag is not set when it should be.
+	// The board is drawn into m_boardDrawList, which goes into the window on
+	// every frame until something it shows changes and sets this flag.
 	bool m_needsRedraw = true;
+	ImDrawList m_boardDrawList;
 	bool m_draggingLastFrame;
 	bool m_showContextMenu;
 	//	bool m_showNetfilterSearch;
@@ -260,6 +430,11 @@ struct BoardView {
 	bool m_firstFrame = true;
 	bool m_lastFileOpenWasInvalid;
 	bool m_validBoard = false;
+
+	// Resident memory once the current board was built, with and without its parsed file
+	size_t m_residentWithFile = 0;
+	size_t m_resident         = 0;
+	BoardLoader m_loader;
 	bool m_wantsQuit;
 
 	~BoardView();
@@ -278,8 +453,11 @@ struct BoardView {
 	void DrawParts(ImDrawList *draw);
 	void DrawBoard();
 	void DrawNetWeb(ImDrawList *draw);
-	void SetFile(BRDFile *file);
+	void SetFile(Board *board);
 	int LoadFile(const std::string &filename);
+	bool IsLoading();
+	void FinishLoad(BoardLoadJob &job);
+	void DrawLoadProgress();
 	ImVec2 CoordToScreen(float x, float y, float w = 1.0f);
 	ImVec2 ScreenToCoord(float x, float y, float w = 1.0f);
 	void Move(float x, float y);
@@ -293,6 +471,10 @@ struct BoardView {
 	// Returns true if the part is shown on the currently displayed side of the
 	// board.
 	bool ComponentIsVisible(const Component *part);
+	bool SideIsVisible(uint8_t side);
+	std::vector<Component *> PartsAt(ImVec2 pos);
+	// Board coordinates seen on the board surface, grown by margin on each side
+	GridBox ViewArea(float margin);
 	bool IsVisibleScreen(float x, float y, float radius, const ImGuiIO &io);
 	// Returns true if the circle described by screen coordinates x, y, and radius
 	// is visible in the
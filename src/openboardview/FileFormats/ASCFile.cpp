@@ -3,18 +3,17 @@
 #include "utils.h"
 #include <assert.h>
 #include <ctype.h>
-#include <locale.h>
 #include <stdint.h>
 
 /*bool ASCFile::verifyFormat(std::vector<char> &buf) {
 	return find_str_in_buf("dd:1.3?,r?-=bb", buf) || ( find_str_in_buf("<<format.asc>>", buf) && find_str_in_buf("<<pins.asc>>", buf) );
 }*/
 
-void ASCFile::parse_format(char *&p, char *&s, char *&arena, char *&arena_end, char **&lines) {
+void ASCFile::parse_format(char *&p, char *&s, LineReader &lines) {
 	if (m_firstformat) {
-		lines += 7; // Skip 7+1 unused lines before 1st point. Might not work with all files.
+		lines.skip(7); // Skip 7+1 unused lines before 1st point. Might not work with all files.
 		m_firstformat = false;
-		return; // lines++ in while loop
+		return; // lines.next() in while loop
 	}
 	BRDPoint point;
 
@@ -25,9 +24,9 @@ void ASCFile::parse_format(char *&p, char *&s, char *&arena, char *&arena_end, c
 	format.push_back(point);
 }
 
-void ASCFile::parse_pin(char *&p, char *&s, char *&arena, char *&arena_end, char **&lines) {
+void ASCFile::parse_pin(char *&p, char *&s, LineReader &lines) {
 	if (m_firstpin) {
-		lines += 7; // Skip 7+1 unused lines before 1st part
+		lines.skip(7); // Skip 7+1 unused lines before 1st part
 		m_firstpin = false;
 		return;
 	}
@@ -61,9 +60,9 @@ void ASCFile::parse_pin(char *&p, char *&s, char *&arena, char *&arena_end, char
 	}
 }
 
-void ASCFile::parse_nail(char *&p, char *&s, char *&arena, char *&arena_end, char **&lines) {
+void ASCFile::parse_nail(char *&p, char *&s, LineReader &lines) {
 	if (m_firstnail) {
-		lines += 6; // Skip 6+1 unused lines before 1st nail
+		lines.skip(6); // Skip 6+1 unused lines before 1st nail
 		m_firstnail = false;
 		return;
 	}
@@ -92,37 +91,28 @@ void ASCFile::parse_nail(char *&p, char *&s, char *&arena, char *&arena_end, cha
  * pins.asc, parts.asc (not supported), nets.asc (not supported), nails.asc, format.asc
  * *.bom files not supported either
  */
-bool ASCFile::read_asc(const std::string &filename, void (ASCFile::*parser)(char *&, char *&, char *&, char *&, char **&)) {
+bool ASCFile::read_asc(const std::string &filename, void (ASCFile::*parser)(char *&, char *&, LineReader &)) {
 	if (filename.empty()) return false;
-	std::vector<char> buf = file_as_buffer(filename);
-	if (buf.empty()) return false;
+	MappedFile file(filename, MappedFile::Mode::CopyOnWrite);
+	if (file.empty()) return false;
 
-	ENSURE(buf.size() > 4);
-	size_t file_buf_size = 3 * (1 + buf.size());
-	file_buf             = (char *)calloc(1, file_buf_size);
+	ENSURE(file.size() > 4);
+	file_buf = file.data(); // Already NUL-terminated
 	ENSURE(file_buf != nullptr);
 
-	std::copy(buf.begin(), buf.end(), file_buf);
-	file_buf[buf.size()] = 0;
-	// This is for fixing degenerate utf8
-	char *arena     = &file_buf[buf.size() + 1];
-	char *arena_end = file_buf + file_buf_size - 1;
-	*arena_end      = 0;
+	// Parsed strings point in to it, keep it around
+	asc_maps.push_back(std::move(file));
 
-	char **lines = stringfile(file_buf);
-	ENSURE(lines);
-
-	while (*lines) {
-		char *line = *lines;
-		++lines;
+	LineReader lines(file_buf, asc_maps.back().size());
 
+	while (char *line = lines.next()) {
 		while (isspace((uint8_t)*line)) line++;
 		if (!line[0]) continue;
 
 		char *p = line;
 		char *s = nullptr;
 
-		(this->*parser)(p, s, arena, arena_end, lines);
+		(this->*parser)(p, s, lines);
 	}
 	return true;
 }
@@ -138,12 +128,9 @@ void ASCFile::update_counts() {
 }
 
 /*
- * buf unused for now, read all files even if one of the supported *.asc was passed
+ * Read all files even if one of the supported *.asc was passed
  */
-ASCFile::ASCFile(std::vector<char> &buf, const std::string &filename) {
-	char *saved_locale;
-	saved_locale = setlocale(LC_NUMERIC, "C"); // Use '.' as delimiter for strtod
-
+ASCFile::ASCFile(const std::string &filename) {
 #ifdef _WIN32
 	auto dpos = filename.rfind('\\');
 #else
@@ -151,11 +138,13 @@ ASCFile::ASCFile(std::vector<char> &buf, const std::string &filename) {
 #endif
 	std::string filepath = (dpos == std::string::npos) ? "" : filename.substr(0, dpos+1); // extract file directory
 
+	report_load_stage(LoadStage::Parse);
+	if (load_cancelled()) return;
+
 	valid = true;
 	if (!read_asc(lookup_file_insensitive(filepath, "format.asc"), &ASCFile::parse_format)) valid = false;
 	if (!read_asc(lookup_file_insensitive(filepath, "pins.asc"), &ASCFile::parse_pin)) valid = false;
 	if (!read_asc(lookup_file_insensitive(filepath, "nails.asc"), &ASCFile::parse_nail)) valid = false;
 
 	update_counts();
-	setlocale(LC_NUMERIC, saved_locale); // Restore locale
 }
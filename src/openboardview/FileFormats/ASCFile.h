@@ -3,20 +3,19 @@
 #include "BRDFile.h"
 class ASCFile : public BRDFile {
 public:
-	ASCFile(std::vector<char> &buf, const std::string &filename);
-	~ASCFile() {
-		free(file_buf);
-	}
+	ASCFile(const std::string &filename);
 
 //	static bool verifyFormat(std::vector<char> &buf);
-	void parse_format(char *&p, char *&s, char *&arena, char *&arena_end, char **&lines);
-	void parse_pin(char *&p, char *&s, char *&arena, char *&arena_end, char **&lines);
-	void parse_nail(char *&p, char *&s, char *&arena, char *&arena_end, char **&lines);
-	bool read_asc(const std::string &filename, void (ASCFile::*parser)(char *&, char *&, char *&, char *&, char **&));
+	void parse_format(char *&p, char *&s, LineReader &lines);
+	void parse_pin(char *&p, char *&s, LineReader &lines);
+	void parse_nail(char *&p, char *&s, LineReader &lines);
+	bool read_asc(const std::string &filename, void (ASCFile::*parser)(char *&, char *&, LineReader &));
 	void update_counts();
 
 protected:
 	bool m_firstformat = true;
 	bool m_firstpin = true;
 	bool m_firstnail = true;
+
+	std::vector<MappedFile> asc_maps; // One for each *.asc file read
 };
@@ -1,72 +1,192 @@
 #include "BDVFile.h"
 
+#include "BoardBuilder.h"
+#include "parallel.h"
+#include "simd.h"
 #include "utils.h"
 #include <assert.h>
 #include <ctype.h>
-#include <locale.h>
 #include <stdint.h>
 #include <string.h>
+#include <vector>
 
-void decode_bdv(char *buf, size_t buffer_size) {
-	int count = 0xa0; // First key
-	for (size_t i = 0; i < buffer_size; i++) {
-		if (buf[i] == '\r' && buf[i + 1] == '\n') count++; // Increment key on each new line
-		char x                                 = buf[i];
-		if (!(x == '\r' || x == '\n' || !x)) x = count - x;
-		if (count > 285) count                 = 159;
-		buf[i]                                 = x;
+/*
+ * Bytes are decoded as key - byte, except for '\r', '\n' and NUL.
+ * The key starts at 0xa0 and goes up by one after each CRLF, going back to 159
+ * after 285. It only depends on the number of CRLFs so far, which lets the
+ * file be decoded in independent blocks once the CRLFs in each are counted.
+ */
+static const size_t bdv_block_size = 1 << 16;
+
+// Key following the given number of CRLFs
+static inline int bdv_key(size_t crlfs) {
+	if (crlfs < 126) return 0xa0 + crlfs;
+	return 159 + (crlfs - 126) % 127;
+}
+
+static inline int bdv_next_key(int key) {
+	return key == 285 ? 159 : key + 1;
+}
+
+/*
+ * Returns the number of CRLFs starting in [begin, end), the '\n' may be at end.
+ * Only reads the buffer.
+ */
+static size_t bdv_count_crlf(const char *buf, size_t begin, size_t end) {
+	size_t count = 0;
+	size_t i     = begin;
+#ifdef OBV_SSE2
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i lf = _mm_set1_epi8('\n');
+	if (cpu_has_sse2())
+		for (; end - i >= 16; i += 16) {
+			__m128i v    = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i));
+			__m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i + 1)); // Up to buf[end]
+			count += popcount32(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(next, lf))));
+		}
+#endif
+	for (; i < end; i++)
+		if (buf[i] == '\r' && buf[i + 1] == '\n') count++;
+	return count;
+}
+
+/*
+ * Decodes [i, end) starting with key, up to the last vector that ends before end
+ * so the byte following it can be looked at. Returns where it stopped.
+ */
+#ifdef OBV_SSE2
+static size_t decode_bdv_sse2(char *buf, size_t i, size_t end, int &key) {
+	const __m128i cr    = _mm_set1_epi8('\r');
+	const __m128i lf    = _mm_set1_epi8('\n');
+	const __m128i nul   = _mm_setzero_si128();
+	const __m128i index = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	for (; end - i > 16; i += 16) {
+		__m128i v     = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i));
+		__m128i next  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i + 1));
+		__m128i is_cr = _mm_cmpeq_epi8(v, cr);
+		uint32_t crlf = _mm_movemask_epi8(_mm_and_si128(is_cr, _mm_cmpeq_epi8(next, lf)));
+		__m128i keep  = _mm_or_si128(_mm_or_si128(is_cr, _mm_cmpeq_epi8(v, lf)), _mm_cmpeq_epi8(v, nul));
+
+		__m128i keys = _mm_set1_epi8(static_cast<char>(key));
+		while (crlf) { // The new key applies after the '\r'
+			int at = ctz32(crlf);
+			crlf &= crlf - 1;
+			key           = bdv_next_key(key);
+			__m128i after = _mm_cmpgt_epi8(index, _mm_set1_epi8(at));
+			__m128i fresh = _mm_set1_epi8(static_cast<char>(key));
+			keys          = _mm_or_si128(_mm_and_si128(after, fresh), _mm_andnot_si128(after, keys));
+		}
+		__m128i decoded = _mm_sub_epi8(keys, v);
+		decoded         = _mm_or_si128(_mm_and_si128(keep, v), _mm_andnot_si128(keep, decoded));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(buf + i), decoded);
+	}
+	return i;
+}
+#endif
+
+#ifdef OBV_AVX2
+OBV_TARGET_AVX2 static size_t decode_bdv_avx2(char *buf, size_t i, size_t end, int &key) {
+	const __m256i cr    = _mm256_set1_epi8('\r');
+	const __m256i lf    = _mm256_set1_epi8('\n');
+	const __m256i nul   = _mm256_setzero_si256();
+	const __m256i index = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+	                                       25, 26, 27, 28, 29, 30, 31);
+	for (; end - i > 32; i += 32) {
+		__m256i v     = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buf + i));
+		__m256i next  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buf + i + 1));
+		__m256i is_cr = _mm256_cmpeq_epi8(v, cr);
+		uint32_t crlf = _mm256_movemask_epi8(_mm256_and_si256(is_cr, _mm256_cmpeq_epi8(next, lf)));
+		__m256i keep  = _mm256_or_si256(_mm256_or_si256(is_cr, _mm256_cmpeq_epi8(v, lf)), _mm256_cmpeq_epi8(v, nul));
+
+		__m256i keys = _mm256_set1_epi8(static_cast<char>(key));
+		while (crlf) { // The new key applies after the '\r'
+			int at = ctz32(crlf);
+			crlf &= crlf - 1;
+			key  = bdv_next_key(key);
+			keys = _mm256_blendv_epi8(
+			    keys, _mm256_set1_epi8(static_cast<char>(key)), _mm256_cmpgt_epi8(index, _mm256_set1_epi8(at)));
+		}
+		__m256i decoded = _mm256_blendv_epi8(_mm256_sub_epi8(keys, v), v, keep);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(buf + i), decoded);
 	}
+	return i;
 }
+#endif
 
-bool BDVFile::verifyFormat(std::vector<char> &buf) {
-	return find_str_in_buf("dd:1.3?,r?-=bb", buf) || ( find_str_in_buf("<<format.asc>>", buf) && find_str_in_buf("<<pins.asc>>", buf) );
+/*
+ * Decodes [begin, end) of buf, key being the one in use at begin.
+ * A CRLF split across the end is left to the next block.
+ */
+static void decode_bdv_block(char *buf, size_t begin, size_t end, int key) {
+	size_t i = begin;
+#ifdef OBV_AVX2
+	if (cpu_has_avx2()) i = decode_bdv_avx2(buf, i, end, key);
+#endif
+#ifdef OBV_SSE2
+	if (cpu_has_sse2()) i = decode_bdv_sse2(buf, i, end, key);
+#endif
+	for (; i < end; i++) {
+		char x = buf[i];
+		// Increment key on each new line
+		if (x == '\r' && i + 1 < end && buf[i + 1] == '\n') key = bdv_next_key(key);
+		// Leave line ends and nulls as they are
+		if (!(x == '\r' || x == '\n' || !x)) x = key - x;
+
+		buf[i] = x;
+	}
 }
 
-BDVFile::BDVFile(std::vector<char> &buf) {
-	auto buffer_size = buf.size();
+void decode_bdv(char *buf, size_t buffer_size) {
+	size_t blocks  = (buffer_size + bdv_block_size - 1) / bdv_block_size;
+	auto block_end = [&](size_t block) { return std::min(buffer_size, (block + 1) * bdv_block_size); };
+
+	std::vector<size_t> crlfs(blocks + 1, 0); // CRLFs before each block
+	parallel_for(blocks, 16, [&](size_t begin, size_t end) {
+		for (size_t b = begin; b < end; b++) crlfs[b + 1] = bdv_count_crlf(buf, b * bdv_block_size, block_end(b));
+	});
+	for (size_t b = 0; b < blocks; b++) crlfs[b + 1] += crlfs[b];
+
+	parallel_for(blocks, 16, [&](size_t begin, size_t end) {
+		for (size_t b = begin; b < end; b++) decode_bdv_block(buf, b * bdv_block_size, block_end(b), bdv_key(crlfs[b]));
+	});
+}
 
-	char *saved_locale;
-	saved_locale = setlocale(LC_NUMERIC, "C"); // Use '.' as delimiter for strtod
+BDVFile::BDVFile(MappedFile &&file, BoardBuilder *builder) {
+	file_map         = std::move(file);
+	streamed         = builder != nullptr;
+	auto buffer_size = file_map.size();
 
 	ENSURE(buffer_size > 4);
-	size_t file_buf_size = 3 * (1 + buffer_size);
-	file_buf             = (char *)calloc(1, file_buf_size);
+	file_buf = file_map.data(); // Already NUL-terminated
 	ENSURE(file_buf != nullptr);
 
-	std::copy(buf.begin(), buf.end(), file_buf);
-	file_buf[buffer_size] = 0;
-	// This is for fixing degenerate utf8
-	char *arena     = &file_buf[buffer_size + 1];
-	char *arena_end = file_buf + file_buf_size - 1;
-	*arena_end      = 0;
-
 	decode_bdv(file_buf, buffer_size);
 
-	int current_block = 0;
+	report_load_stage(LoadStage::Parse);
+	if (load_cancelled()) return;
 
-	char **lines = stringfile(file_buf);
-	ENSURE(lines);
+	int current_block = 0;
 
-	while (*lines) {
-		char *line = *lines;
-		++lines;
+	LineReader lines(file_buf, buffer_size);
+	unsigned int pin_count = 0; // Pins so far, whether kept or streamed
 
+	while (char *line = lines.next()) {
 		while (isspace((uint8_t)*line)) line++;
 		if (!line[0]) continue;
 		if (!strcmp(line, "<<format.asc>>")) {
 			current_block = 1;
-			lines += 8; // Skip 8 unused lines before 1st point. Might not work with
-			            // all files.
+			lines.skip(8); // Skip 8 unused lines before 1st point. Might not work with
+			               // all files.
 			continue;
 		}
 		if (!strcmp(line, "<<pins.asc>>")) {
 			current_block = 2;
-			lines += 8; // Skip 8 unused lines before 1st part
+			lines.skip(8); // Skip 8 unused lines before 1st part
 			continue;
 		}
 		if (!strcmp(line, "<<nails.asc>>")) {
 			current_block = 3;
-			lines += 7; // Skip 7 unused lines before 1st nail
+			lines.skip(7); // Skip 7 unused lines before 1st nail
 			continue;
 		}
 
@@ -82,6 +202,7 @@ BDVFile::BDVFile(std::vector<char> &buf) {
 				double y = READ_DOUBLE();
 				point.y = y * 1000.0f;
 				format.push_back(point);
+				if (builder) builder->addOutlinePoint(point);
 			} break;
 			case 2: { // Parts & Pins
 				if (!strncmp(line, "Part", 4)) {
@@ -96,6 +217,7 @@ BDVFile::BDVFile(std::vector<char> &buf) {
 						part.type    = 5; // SMD part on bottom
 					part.end_of_pins = 0;
 					parts.push_back(part);
+					if (builder) builder->beginPart(part);
 				} else {
 					BRDPin pin;
 
@@ -109,8 +231,11 @@ BDVFile::BDVFile(std::vector<char> &buf) {
 					/*int layer =*/ READ_INT(); // uint
 					pin.net = READ_STR();
 					pin.probe = READ_UINT();
-					pins.push_back(pin);
-					parts.back().end_of_pins = pins.size();
+					if (builder)
+						builder->addPin(pin);
+					else
+						pins.push_back(pin);
+					parts.back().end_of_pins = ++pin_count;
 				}
 			} break;
 			case 3: { // Nails
@@ -131,17 +256,18 @@ BDVFile::BDVFile(std::vector<char> &buf) {
 					nail.side = 2;
 				/*char *netid =*/ READ_STR(); // uint
 				nail.net = READ_STR();
-				nails.push_back(nail);
+				if (builder)
+					builder->addNail(nail);
+				else
+					nails.push_back(nail);
+				num_nails++;
 			} break;
 		}
 	}
 
 	num_parts  = parts.size();
-	num_pins   = pins.size();
+	num_pins   = pin_count;
 	num_format = format.size();
-	num_nails  = nails.size();
-
-	setlocale(LC_NUMERIC, saved_locale); // Restore locale
 
 	valid = current_block != 0;
 }
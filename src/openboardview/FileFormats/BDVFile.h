@@ -3,10 +3,8 @@
 #include "BRDFile.h"
 
 struct BDVFile : public BRDFile {
-	BDVFile(std::vector<char> &buf);
-	~BDVFile() {
-		free(file_buf);
-	}
-
-	static bool verifyFormat(std::vector<char> &buf);
+	BDVFile(MappedFile &&file, BoardBuilder *builder = nullptr);
 };
+
+// Decodes buffer_size bytes of a BDV file in place, buf[buffer_size] must be readable
+void decode_bdv(char *buf, size_t buffer_size);
@@ -8,37 +8,65 @@
 #include <string.h>
 #include <unordered_map>
 
-bool BRD2File::verifyFormat(std::vector<char> &buf) {
-	return find_str_in_buf("BRDOUT:", buf) && find_str_in_buf("NETS:", buf);
-}
-
-BRD2File::BRD2File(std::vector<char> &buf) {
-	auto buffer_size = buf.size();
+BRD2File::BRD2File(MappedFile &&file) {
+	file_map         = std::move(file);
+	auto buffer_size = file_map.size();
 	std::unordered_map<int, char *> nets; // Map between net id and net name
 	unsigned int num_nets = 0;
 	BRDPoint max{0, 0}; // Top-right board boundary
 
 	ENSURE(buffer_size > 4);
-	size_t file_buf_size = 3 * (1 + buffer_size);
-	file_buf             = (char *)calloc(1, file_buf_size);
+	file_buf = file_map.data(); // Already NUL-terminated
 	ENSURE(file_buf != nullptr);
 
-	std::copy(buf.begin(), buf.end(), file_buf);
-	file_buf[buffer_size] = 0;
-	// This is for fixing degenerate utf8
-	char *arena     = &file_buf[buffer_size + 1];
-	char *arena_end = file_buf + file_buf_size - 1;
-	*arena_end      = 0;
-
 	int current_block = 0;
+	bool parallel     = buffer_size >= parallel_parse_threshold;
+
+	// Pins and nails are parsed in batches, before the nets they refer to can change
+	std::vector<char *> pin_lines, nail_lines;
+	auto parse_pins_and_nails = [&]() {
+		size_t first_pin = pins.size();
+		pins.resize(first_pin + pin_lines.size());
+		parse_lines(pin_lines.data(), pin_lines.size(), parallel, [&](char *p, size_t i, Arena &) {
+			BRDPin &pin = pins[first_pin + i];
+
+			pin.pos.x = READ_INT();
+			pin.pos.y = READ_INT();
+			int netid = READ_UINT();
+			pin.side  = READ_UINT();
+
+			try {
+				pin.net = nets.at(netid);
+			} catch (const std::out_of_range &e) {
+				pin.net = "";
+			}
+
+			pin.probe = 1;
+			pin.part  = 0;
+		});
+		pin_lines.clear();
 
-	char **lines = stringfile(file_buf);
-	ENSURE(lines)
+		size_t first_nail = nails.size();
+		nails.resize(first_nail + nail_lines.size());
+		parse_lines(nail_lines.data(), nail_lines.size(), parallel, [&](char *p, size_t i, Arena &) {
+			BRDNail &nail = nails[first_nail + i];
 
-	while (*lines) {
-		char *line = *lines;
-		++lines;
+			nail.probe = READ_UINT();
+			nail.pos.x = READ_INT();
+			nail.pos.y = READ_INT();
+			int netid  = READ_UINT();
+			nail.net   = nets.at(netid);
+			nail.side  = READ_UINT();
+		});
+		nail_lines.clear();
+	};
 
+	report_load_stage(LoadStage::Parse);
+	if (load_cancelled()) return;
+
+	LineReader lines(file_buf, buffer_size);
+
+	while (char *line = lines.next()) {
 		while (isspace((uint8_t)*line)) line++;
 		if (!line[0]) continue;
 
@@ -54,6 +82,7 @@ BRD2File::BRD2File(std::vector<char> &buf) {
 			continue;
 		}
 		if (strstr(line, "NETS:") == line) {
+			parse_pins_and_nails();
 			current_block = 2;
 			p += 5; // Skip "NETS:"
 			num_nets = READ_UINT();
@@ -115,41 +144,18 @@ BRD2File::BRD2File(std::vector<char> &buf) {
 			} break;
 
 			case 4: { // PINS
-				ENSURE(pins.size() < num_pins);
-				BRDPin pin;
-
-				pin.pos.x = READ_INT();
-				pin.pos.y = READ_INT();
-				int netid = READ_UINT();
-				pin.side = READ_UINT();
-
-				try {
-					pin.net = nets.at(netid);
-				} catch (const std::out_of_range &e) {
-					pin.net = "";
-				}
-
-				pin.probe = 1;
-				pin.part  = 0;
-				pins.push_back(pin);
+				ENSURE(pins.size() + pin_lines.size() < num_pins);
+				pin_lines.push_back(line);
 			} break;
 
 			case 5: { // NAILS
-				ENSURE(nails.size() < num_nails);
-				BRDNail nail;
-
-				nail.probe = READ_UINT();
-				nail.pos.x = READ_INT();
-				nail.pos.y = READ_INT();
-				int netid = READ_UINT();
-				nail.net = nets.at(netid);
-				nail.side = READ_UINT();
-				nails.push_back(nail);
-
+				ENSURE(nails.size() + nail_lines.size() < num_nails);
+				nail_lines.push_back(line);
 			} break;
 			default: continue;
 		}
 	}
+	parse_pins_and_nails();
 
 	ENSURE(num_format == format.size());
 	ENSURE(num_nets == nets.size());
@@ -1,5 +1,7 @@
 #include "BRDFile.h"
 
+#include "BoardBuilder.h"
+#include "simd.h"
 #include "utf8/utf8.h"
 #include "utils.h"
 #include <assert.h>
@@ -7,123 +9,133 @@
 #include <stdint.h>
 #include <string.h>
 
-// Header for recognizing a BRD file
-decltype(BRDFile::signature) constexpr BRDFile::signature;
-
-// from stb.h -- return value must be freed
-char **stringfile(char *buffer) {
-	char **list = nullptr, *s;
-	size_t count, i;
-
-	// two passes through: first time count lines, second time set them
-	for (i = 0; i < 2; ++i) {
-		s                   = buffer;
-		if (i == 1) list[0] = s;
-		count               = 1; // was '1',  but C arrays are 0-indexed
-		while (*s) {
-			if (*s == '\n' || *s == '\r') {
-
-				// If this is the 2nd pass, then terminate the line at the first line break char
-				if (i == 1) *s = 0;
-
-				s++; // next char
-
-				// if the termination is a CRLF combo, then jump to the next char
-				if ((*s == '\r') || (*s == '\n')) s++;
-
-				// if the char is valid (first after line break), set up the next item in the line array
-				if (*s) { // it's not over yet
-					if (i == 1) {
-						list[count] = s;
-						//					  list[count+1] = NULL;
-						// fprintf(stdout,"%s\n",list[count]);
-					}
-					++count;
-				}
-			}
-			s++;
-		} // while s
-
-		// Generate the required array to hold all the line starting points
-		if (i == 0) {
-			list = (char **)malloc(sizeof(*list) * (count + 2));
-			if (!list) return NULL;
-			list[count] = 0;
-		}
-	}
-	return list;
+// True if none of the len bytes at s has the high bit set
+static bool is_ascii(const char *s, size_t len) {
+	size_t i = 0;
+#ifdef OBV_SSE2
+	__m128i any = _mm_setzero_si128();
+
+	for (; len - i >= 16; i += 16) any = _mm_or_si128(any, _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i)));
+	if (_mm_movemask_epi8(any)) return false;
+#endif
+	uint8_t high = 0;
+	for (; i < len; i++) high |= s[i];
+	return !(high & 0x80);
 }
 
-char *fix_to_utf8(char *s, char **arena, char *arena_end) {
-	if (!utf8valid(s)) {
+/*
+ * Returns s, or a copy of it converted from latin1 if s (len bytes, NUL-terminated) is not valid UTF-8.
+ * Plain ASCII, by far the most common, is recognised without decoding anything.
+ */
+char *fix_to_utf8(char *s, size_t len, Arena &arena) {
+	if (is_ascii(s, len) || !utf8valid(s)) {
 		return s;
 	}
-	char *p     = *arena;
+	size_t high = 0; // Chars taking 2 bytes
+	for (size_t i = 0; i < len; i++) high += (uint8_t)s[i] >> 7;
+
+	char *p     = arena.alloc<char>(len + high + 1);
 	char *begin = p;
 	while (*s) {
 		uint32_t c = (uint8_t)*s;
 		if (c < 0x80) {
-			if (p + 1 >= arena_end) goto done;
 			*p++ = c;
 		} else {
-			if (p + 2 >= arena_end) goto done;
 			*p++ = 0xc0 | (c >> 6);
 			*p++ = 0x80 | (c & 0x3f);
 		}
 		++s;
 	}
-	if (p + 1 >= arena_end) goto done;
-	*p++ = 0;
-done:
-	*arena = p;
+	*p = 0;
 	return begin;
 }
 
 /*
- * Returns true if the file format seems to be BRD.
- * Uses std::string::find() on a std::string rather than strstr() on the buffer because the latter expects a null-terminated string.
+ * Encoded BRD files have every byte but '\r', '\n' and NUL rotated left by 2
+ * bits and inverted. Bytes are independent, so blocks are decoded on several
+ * threads, 16 or 32 bytes at a time.
  */
-bool BRDFile::verifyFormat(std::vector<char> &buf) {
-	if (buf.size() < signature.size()) return false; // C++14 implements a safer std::equal where this is not needed
-	if (std::equal(signature.begin(), signature.end(), buf.begin(), [](const uint8_t &i, const char &j) { return i == reinterpret_cast<const uint8_t &>(j); } )) return true;
-	return find_str_in_buf("str_length:", buf) && find_str_in_buf("var_data:", buf);
+static inline char decode_brd_byte(char x) {
+	if (x == '\r' || x == '\n' || !x) return x;
+	uint8_t c = x;
+	return ~((c >> 6) | (c << 2));
 }
 
-BRDFile::BRDFile(std::vector<char> &buf) {
-	auto buffer_size = buf.size();
+#ifdef OBV_SSE2
+static size_t decode_brd_sse2(char *buf, size_t i, size_t end) {
+	const __m128i cr   = _mm_set1_epi8('\r');
+	const __m128i lf   = _mm_set1_epi8('\n');
+	const __m128i nul  = _mm_setzero_si128();
+	const __m128i high = _mm_set1_epi8(static_cast<char>(0xfc));
+	const __m128i low  = _mm_set1_epi8(0x03);
+	const __m128i ones = _mm_set1_epi8(static_cast<char>(0xff));
+	for (; end - i >= 16; i += 16) {
+		__m128i v       = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i));
+		__m128i keep    = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)), _mm_cmpeq_epi8(v, nul));
+		__m128i rotated = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(v, 2), high), _mm_and_si128(_mm_srli_epi16(v, 6), low));
+		__m128i decoded = _mm_xor_si128(rotated, ones);
+		decoded         = _mm_or_si128(_mm_and_si128(keep, v), _mm_andnot_si128(keep, decoded));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(buf + i), decoded);
+	}
+	return i;
+}
+#endif
+
+#ifdef OBV_AVX2
+OBV_TARGET_AVX2 static size_t decode_brd_avx2(char *buf, size_t i, size_t end) {
+	const __m256i cr   = _mm256_set1_epi8('\r');
+	const __m256i lf   = _mm256_set1_epi8('\n');
+	const __m256i nul  = _mm256_setzero_si256();
+	const __m256i high = _mm256_set1_epi8(static_cast<char>(0xfc));
+	const __m256i low  = _mm256_set1_epi8(0x03);
+	const __m256i ones = _mm256_set1_epi8(static_cast<char>(0xff));
+	for (; end - i >= 32; i += 32) {
+		__m256i v         = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buf + i));
+		__m256i line_ends = _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, lf));
+		__m256i keep      = _mm256_or_si256(line_ends, _mm256_cmpeq_epi8(v, nul));
+		__m256i up        = _mm256_and_si256(_mm256_slli_epi16(v, 2), high);
+		__m256i down      = _mm256_and_si256(_mm256_srli_epi16(v, 6), low);
+		__m256i rotated   = _mm256_or_si256(up, down);
+		__m256i decoded   = _mm256_blendv_epi8(_mm256_xor_si256(rotated, ones), v, keep);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(buf + i), decoded);
+	}
+	return i;
+}
+#endif
+
+void decode_brd(char *buf, size_t size) {
+	parallel_for(size, 1 << 20, [&](size_t begin, size_t end) {
+		size_t i = begin;
+#ifdef OBV_AVX2
+		if (cpu_has_avx2()) i = decode_brd_avx2(buf, i, end);
+#endif
+#ifdef OBV_SSE2
+		if (cpu_has_sse2()) i = decode_brd_sse2(buf, i, end);
+#endif
+		for (; i < end; i++) buf[i] = decode_brd_byte(buf[i]);
+	});
+}
+
+BRDFile::BRDFile(MappedFile &&file, BoardBuilder *builder) {
+	file_map         = std::move(file);
+	streamed         = builder != nullptr;
+	auto buffer_size = file_map.size();
 	ENSURE(buffer_size > 4);
-	size_t file_buf_size = 3 * (1 + buffer_size);
-	file_buf             = (char *)calloc(1, file_buf_size);
+	file_buf = file_map.data(); // Already NUL-terminated
 	ENSURE(file_buf != nullptr);
 
-	std::copy(buf.begin(), buf.end(), file_buf);
-	file_buf[buffer_size] = 0;
-	// This is for fixing degenerate utf8
-	char *arena     = &file_buf[buffer_size + 1];
-	char *arena_end = file_buf + file_buf_size - 1;
-	*arena_end      = 0;
-
 	// decode the file if it appears to be encoded:
 	static const uint8_t encoded_header[] = {0x23, 0xe2, 0x63, 0x28};
-	if (!memcmp(file_buf, encoded_header, 4)) {
-		for (size_t i = 0; i < buffer_size; i++) {
-			char x = file_buf[i];
-			if (!(x == '\r' || x == '\n' || !x)) {
-				int c = x;
-				x     = ~(((c >> 6) & 3) | (c << 2));
-			}
-			file_buf[i] = x;
-		}
-	}
+	if (!memcmp(file_buf, encoded_header, 4)) decode_brd(file_buf, buffer_size);
 
-	int current_block = 0;
-	char **lines      = stringfile(file_buf);
-	ENSURE(lines);
+	report_load_stage(LoadStage::Parse);
+	if (load_cancelled()) return;
 
-	while (*lines) {
-		char *line = *lines;
-		++lines;
+	int current_block = 0;
+	std::vector<char *> pin_lines, nail_lines; // Parsed after the other blocks, see parse_lines()
+	LineReader lines(file_buf, buffer_size);
 
+	while (char *line = lines.next()) {
 		while (isspace((uint8_t)*line)) line++;
 		if (!line[0]) continue;
 		if (!strcmp(line, "str_length:")) {
@@ -164,8 +176,8 @@ BRDFile::BRDFile(std::vector<char> &buf) {
 			case 3: { // Format
 				ENSURE(format.size() < num_format);
 				BRDPoint fmt;
-				fmt.x = strtol(p, &p, 10);
-				fmt.y = strtol(p, &p, 10);
+				fmt.x = scan_long(p, &p);
+				fmt.y = scan_long(p, &p);
 				format.push_back(fmt);
 			} break;
 			case 4: { // Parts
@@ -178,27 +190,51 @@ BRDFile::BRDFile(std::vector<char> &buf) {
 				parts.push_back(part);
 			} break;
 			case 5: { // Pins
-				ENSURE(pins.size() < num_pins);
-				BRDPin pin;
-				pin.pos.x = READ_INT();
-				pin.pos.y = READ_INT();
-				pin.probe = READ_INT(); // Can be negative (-99)
-				pin.part = READ_UINT();
-				ENSURE(pin.part <= num_parts);
-				pin.net = READ_STR();
-				pins.push_back(pin);
+				ENSURE(pin_lines.size() < num_pins);
+				pin_lines.push_back(line);
 			} break;
 			case 6: { // Nails
-				ENSURE(nails.size() < num_nails);
-				BRDNail nail;
-				nail.probe = READ_UINT();
-				nail.pos.x = READ_INT();
-				nail.pos.y = READ_INT();
-				nail.side = READ_UINT();
-				nail.net = READ_STR();
-				nails.push_back(nail);
+				ENSURE(nail_lines.size() < num_nails);
+				nail_lines.push_back(line);
 			} break;
 		}
 	}
+
+	bool parallel = buffer_size >= parallel_parse_threshold;
+
+	// A pin's part must be begun before it
+	if (builder) {
+		for (auto &point : format) builder->addOutlinePoint(point);
+		for (auto &part : parts) builder->beginPart(part);
+	}
+
+	auto add_pin = [&](const BRDPin &pin) { builder->addPin(pin); };
+	parse_records(pin_lines, parallel, pins, streamed, add_pin, [&](char *p, BRDPin &pin, Arena &arena) {
+		char *s;
+		pin.pos.x = READ_INT();
+		pin.pos.y = READ_INT();
+		pin.probe = READ_INT(); // Can be negative (-99)
+		pin.part  = READ_UINT();
+		ENSURE(pin.part <= num_parts);
+		pin.net = READ_STR();
+	});
+
+	auto add_nail = [&](const BRDNail &nail) { builder->addNail(nail); };
+	parse_records(nail_lines, parallel, nails, streamed, add_nail, [&](char *p, BRDNail &nail, Arena &arena) {
+		char *s;
+		nail.probe = READ_UINT();
+		nail.pos.x = READ_INT();
+		nail.pos.y = READ_INT();
+		nail.side  = READ_UINT();
+		nail.net   = READ_STR();
+	});
+
 	valid = current_block != 0;
 }
+
+void BRDFile::build(BoardBuilder &builder) const {
+	for (auto &point : format) builder.addOutlinePoint(point);
+	for (auto &nail : nails) builder.addNail(nail);
+	for (auto &part : parts) builder.beginPart(part);
+	for (auto &pin : pins) builder.addPin(pin);
+}
@@ -1,29 +1,40 @@
 #pragma once
 
+#include "Arena.h"
 #include "Board.h"
+#include "LineReader.h"
+#include "LoadStatus.h"
+#include "NumberScan.h"
+#include "mappedfile.h"
+#include "parallel.h"
+#include <algorithm>
 #include <array>
+#include <mutex>
 #include <stdlib.h>
+#include <string.h>
 #include <string>
 #include <vector>
 
 #define ENSURE(X) assert(X);
-#define READ_INT() strtol(p, &p, 10);
+#define READ_INT() scan_long(p, &p);
 // Warning: read as int then cast to uint if positive
 #define READ_UINT [&]() {                                    \
-		int value = strtol(p, &p, 10);               \
+		int value = scan_long(p, &p);                \
 		ENSURE(value >= 0);                          \
 		return static_cast<unsigned int>(value);     \
 	}
-#define READ_DOUBLE() strtod(p, &p);
+#define READ_DOUBLE() scan_double(p, &p);
 #define READ_STR [&]() {                                     \
 		while ((*p) && (isspace((uint8_t)*p))) ++p;  \
 		s = p;                                       \
 		while ((*p) && (!isspace((uint8_t)*p))) ++p; \
 		*p = 0;                                      \
 		p++;                                         \
-		return fix_to_utf8(s, &arena, arena_end);    \
+		return fix_to_utf8(s, p - 1 - s, arena);     \
 	}
 
+class BoardBuilder;
+
 static constexpr std::array<uint8_t, 4> signature = {0x23, 0xe2, 0x63, 0x28};
 
 struct BRDPoint {
@@ -74,21 +85,78 @@ class BRDFile {
 	std::vector<BRDPin> pins;
 	std::vector<BRDNail> nails;
 
-	char *file_buf = nullptr;
+	char *file_buf = nullptr; // Points in to file_map
 
-	bool valid = false;
+	bool valid    = false;
+	bool streamed = false; // Pins and nails went to the builder given to the constructor, not in to the vectors
 
-	BRDFile(std::vector<char> &buf);
+	// With a builder, the board is streamed to it as it is parsed and only the format and parts are kept
+	BRDFile(MappedFile &&file, BoardBuilder *builder = nullptr);
 	BRDFile(){};
-	~BRDFile() {
-		free(file_buf);
-	}
+	virtual ~BRDFile() {}
+
+	// Streams the parsed board to builder, if it was not streamed to one while parsing
+	void build(BoardBuilder &builder) const;
+
+	// Files at least this big get their pins and nails parsed on several threads
+	static constexpr size_t parallel_parse_threshold = 1 << 20;
 
-	static bool verifyFormat(std::vector<char> &buf);
+	// Pins and nails streamed to a builder are parsed this many at a time
+	static constexpr size_t stream_block = 1 << 16;
 
-  private:
-	static constexpr std::array<uint8_t, 4> signature = {0x23, 0xe2, 0x63, 0x28};
+  protected:
+	MappedFile file_map; // Copy-on-write mapping of the board file, parsed strings point in to it
+	Arena arena;         // For fixing degenerate utf8
+
+	template <typename F>
+	void parse_lines(char *const *lines, size_t count, bool parallel, F parse_line);
+	template <typename T, typename F, typename E>
+	void parse_records(const std::vector<char *> &lines, bool parallel, std::vector<T> &records, bool stream, E emit, F parse_line);
 };
 
-char **stringfile(char *buffer);
-char *fix_to_utf8(char *s, char **arena, char *arena_end);
+char *fix_to_utf8(char *s, size_t len, Arena &arena);
+
+// Decodes size bytes of an encoded BRD file in place
+void decode_brd(char *buf, size_t size);
+
+/*
+ * Calls parse_line(line, index, arena) for each of the count lines, on several
+ * threads if parallel is set. Every thread fixes strings in an arena of its own,
+ * which the file's arena takes over once the thread is done.
+ * parse_line must only write to the item at index.
+ */
+template <typename F>
+void BRDFile::parse_lines(char *const *lines, size_t count, bool parallel, F parse_line) {
+	std::mutex arena_lock;
+	parallel_for(count, parallel ? 4096 : count, [&](size_t begin, size_t end) {
+		Arena chunk_arena;
+		for (size_t i = begin; i < end; i++) parse_line(lines[i], i, chunk_arena);
+		std::lock_guard<std::mutex> lock(arena_lock);
+		arena.adopt(chunk_arena);
+	});
+}
+
+/*
+ * Parses the lines into records with parse_line(line, record, arena), as
+ * parse_lines() does. When streaming, only stream_block of them are parsed at a
+ * time, each handed to emit(record) before the next block, and records is left
+ * empty.
+ */
+template <typename T, typename F, typename E>
+void BRDFile::parse_records(
+    const std::vector<char *> &lines, bool parallel, std::vector<T> &records, bool stream, E emit, F parse_line) {
+	size_t block = stream ? stream_block : lines.size();
+	for (size_t first = 0; first < lines.size(); first += block) {
+		size_t count = std::min(block, lines.size() - first);
+		records.resize(count);
+		parse_lines(lines.data() + first, count, parallel, [&](char *p, size_t i, Arena &arena) {
+			parse_line(p, records[i], arena);
+		});
+		if (stream)
+			for (auto &record : records) emit(record);
+	}
+	if (stream) {
+		records.clear();
+		records.shrink_to_fit();
+	}
+}
@@ -4,7 +4,6 @@
 #include <assert.h>
 #include <cmath>
 #include <ctype.h>
-#include <locale.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -18,57 +17,43 @@ char *nextfield(char *p) {
 	return p;
 }
 
-bool BVRFile::verifyFormat(std::vector<char> &buf) {
-	return find_str_in_buf("BVRAW_FORMAT_1", buf);
-}
-
-BVRFile::BVRFile(std::vector<char> &buf) {
-	auto buffer_size = buf.size();
+BVRFile::BVRFile(MappedFile &&file) {
+	file_map         = std::move(file);
+	auto buffer_size = file_map.size();
 
-	char *saved_locale;
-	char ppn[100] = {0};                        // previous part name
-	saved_locale  = setlocale(LC_NUMERIC, "C"); // Use '.' as delimiter for strtod
+	char ppn[100] = {0}; // previous part name
 
 	ENSURE(buffer_size > 4);
-	size_t file_buf_size = 3 * (1 + buffer_size);
-	file_buf             = (char *)calloc(1, file_buf_size);
+	file_buf = file_map.data(); // Already NUL-terminated
 	ENSURE(file_buf != nullptr);
 
-	std::copy(buf.begin(), buf.end(), file_buf);
-	file_buf[buffer_size] = 0;
-	// This is for fixing degenerate utf8
-	char *arena     = &file_buf[buffer_size + 1];
-	char *arena_end = file_buf + file_buf_size - 1;
-	*arena_end      = 0;
+	report_load_stage(LoadStage::Parse);
+	if (load_cancelled()) return;
 
 	int current_block = 0;
 
-	char **lines = stringfile(file_buf);
-	ENSURE(lines);
-
-	while (*lines) {
-		char *line = *lines;
-		++lines;
+	LineReader lines(file_buf, buffer_size);
 
+	while (char *line = lines.next()) {
 		while (isspace((uint8_t)*line)) line++;
 		if (!line[0]) continue;
 
 		if (!strcmp(line, "<<Layout>>")) {
 			//			fprintf(stderr,"HIT LAYOUT\n");
 			current_block = 1;
-			lines += 1; // Skip 1 unused lines before 1st layout
+			lines.skip(1); // Skip 1 unused lines before 1st layout
 			continue;
 		}
 		if (!strcmp(line, "<<Pin>>")) {
 			current_block = 2;
 			//			fprintf(stderr,"HIT PIN, block = %d\n", current_block);
-			lines += 1; // Skip 1 unused lines before 1st pin
+			lines.skip(1); // Skip 1 unused lines before 1st pin
 			continue;
 		}
 		if (!strcmp(line, "<<Nail>>")) {
 			//			fprintf(stderr,"HIT NAIL\n");
 			current_block = 3;
-			lines += 1; // Skip 1 unused lines before 1st nail
+			lines.skip(1); // Skip 1 unused lines before 1st nail
 			continue;
 		}
 
@@ -155,7 +140,5 @@ BVRFile::BVRFile(std::vector<char> &buf) {
 	num_format = format.size();
 	num_nails  = nails.size();
 
-	setlocale(LC_NUMERIC, saved_locale); // Restore locale
-
 	valid = current_block != 0;
 }
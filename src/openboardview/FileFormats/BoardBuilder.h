@@ -0,0 +1,21 @@
+#pragma once
+
+#include "BRDFile.h"
+
+/*
+ * Receives a parsed board one element at a time, in a single pass.
+ *
+ * Parts are numbered from 1 in the order they are begun; a pin refers to its
+ * part by that number, which must have been begun already. Nails, pins and
+ * outline points may otherwise come in any order. Strings only need to stay
+ * valid for the duration of the call.
+ */
+class BoardBuilder {
+  public:
+	virtual ~BoardBuilder() {}
+
+	virtual void beginPart(const BRDPart &part)         = 0;
+	virtual void addPin(const BRDPin &pin)              = 0;
+	virtual void addNail(const BRDNail &nail)           = 0;
+	virtual void addOutlinePoint(const BRDPoint &point) = 0;
+};
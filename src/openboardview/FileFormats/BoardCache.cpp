@@ -0,0 +1,434 @@
+#include "BoardCache.h"
+
+#include "Board.h"
+#include "StringPool.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string.h>
+
+static const char cache_magic[8]   = {'O', 'B', 'V', 'C', 'A', 'C', 'H', 'E'};
+static const uint32_t no_string    = UINT32_MAX; // Offset of a null string
+static const uint64_t string_limit = UINT32_MAX;
+
+struct CacheHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t strings_size;
+	uint64_t source_hash;
+	uint64_t source_size;
+	uint32_t format_count, part_count, pin_count, nail_count;  // Records in the snapshot
+	uint32_t num_format, num_parts, num_pins, num_nails;       // Counts declared by the source file
+	uint32_t analysed_count, hull_point_count, diameter_count; // Analysis records, one per component and pin of the board
+	float pin_diameter;                                        // Passed to AnalyseParts()
+};
+
+// A component of the board as AnalyseParts() left it, hulls are ranges of the hull points
+struct CacheAnalysedPart {
+	outline_pt outline[4];
+	outline_pt centerpoint;
+	double expanse;
+	uint32_t hull_first;
+	uint32_t hull_count;
+	uint32_t component_type;
+	uint32_t outline_done;
+};
+
+// Strings are offsets in to the string pool
+struct CachePin {
+	double radius;
+	int32_t x, y;
+	int32_t probe;
+	uint32_t part;
+	uint32_t side;
+	uint32_t net;
+	uint32_t snum;
+	uint32_t reserved;
+};
+
+struct CachePart {
+	uint32_t name;
+	uint32_t mfgcode;
+	uint32_t type;
+	uint32_t end_of_pins;
+	int32_t x1, y1, x2, y2;
+};
+
+struct CacheNail {
+	uint32_t probe;
+	int32_t x, y;
+	uint32_t side;
+	uint32_t net;
+};
+
+struct CachePoint {
+	int32_t x, y;
+};
+
+// Sections follow each other in this order without padding, sizes keep every one aligned
+static_assert(sizeof(CacheHeader) == 80, "snapshot header layout");
+static_assert(sizeof(CacheAnalysedPart) == 104, "snapshot analysed part layout");
+static_assert(sizeof(outline_pt) == 16, "snapshot hull point layout");
+static_assert(sizeof(CachePin) == 40, "snapshot pin layout");
+static_assert(sizeof(CachePart) == 32, "snapshot part layout");
+static_assert(sizeof(CacheNail) == 20, "snapshot nail layout");
+static_assert(sizeof(CachePoint) == 8, "snapshot point layout");
+
+BoardCacheFile::BoardCacheFile(MappedFile &&snapshot, uint64_t source_hash, uint64_t source_size) {
+	file_map         = std::move(snapshot);
+	const char *data = file_map.data();
+	size_t size      = file_map.size();
+	if (size < sizeof(CacheHeader)) return;
+
+	const CacheHeader *header = reinterpret_cast<const CacheHeader *>(data);
+	if (memcmp(header->magic, cache_magic, sizeof(cache_magic)) || header->version != version) return;
+	if (header->source_hash != source_hash || header->source_size != source_size) return; // Stale
+
+	uint64_t expected_size = sizeof(CacheHeader) + uint64_t(header->analysed_count) * sizeof(CacheAnalysedPart) +
+	                         uint64_t(header->hull_point_count) * sizeof(outline_pt) +
+	                         uint64_t(header->pin_count) * sizeof(CachePin) + uint64_t(header->part_count) * sizeof(CachePart) +
+	                         uint64_t(header->nail_count) * sizeof(CacheNail) +
+	                         uint64_t(header->format_count) * sizeof(CachePoint) +
+	                         uint64_t(header->diameter_count) * sizeof(float) + header->strings_size;
+	if (expected_size != size) return;
+
+	auto cache_analysed  = reinterpret_cast<const CacheAnalysedPart *>(header + 1);
+	auto cache_hull      = reinterpret_cast<const outline_pt *>(cache_analysed + header->analysed_count);
+	auto cache_pins      = reinterpret_cast<const CachePin *>(cache_hull + header->hull_point_count);
+	auto cache_parts     = reinterpret_cast<const CachePart *>(cache_pins + header->pin_count);
+	auto cache_nails     = reinterpret_cast<const CacheNail *>(cache_parts + header->part_count);
+	auto cache_points    = reinterpret_cast<const CachePoint *>(cache_nails + header->nail_count);
+	auto cache_diameters = reinterpret_cast<const float *>(cache_points + header->format_count);
+	auto strings         = reinterpret_cast<const char *>(cache_diameters + header->diameter_count);
+	if (header->strings_size && strings[header->strings_size - 1]) return; // Every string must be terminated
+
+	bool intact      = true;
+	auto read_string = [&](uint32_t offset) -> const char * {
+		if (offset == no_string) return nullptr;
+		if (offset >= header->strings_size) {
+			intact = false;
+			return nullptr;
+		}
+		return strings + offset;
+	};
+
+	num_format = header->num_format;
+	num_parts  = header->num_parts;
+	num_pins   = header->num_pins;
+	num_nails  = header->num_nails;
+
+	format.resize(header->format_count);
+	for (size_t i = 0; i < format.size(); i++) {
+		format[i].x = cache_points[i].x;
+		format[i].y = cache_points[i].y;
+	}
+
+	parts.resize(header->part_count);
+	for (size_t i = 0; i < parts.size(); i++) {
+		const CachePart &cached   = cache_parts[i];
+		BRDPart &part             = parts[i];
+		part.name                 = read_string(cached.name);
+		const char *mfgcode       = read_string(cached.mfgcode);
+		if (mfgcode) part.mfgcode = mfgcode;
+		part.type                 = cached.type;
+		part.end_of_pins          = cached.end_of_pins;
+		part.p1                   = {cached.x1, cached.y1};
+		part.p2                   = {cached.x2, cached.y2};
+		if (!part.name) intact    = false;
+	}
+
+	pins.resize(header->pin_count);
+	for (size_t i = 0; i < pins.size(); i++) {
+		const CachePin &cached = cache_pins[i];
+		BRDPin &pin            = pins[i];
+		pin.pos                = {cached.x, cached.y};
+		pin.probe              = cached.probe;
+		pin.part               = cached.part;
+		pin.side               = cached.side;
+		pin.net                = read_string(cached.net);
+		pin.radius             = cached.radius;
+		pin.snum               = read_string(cached.snum);
+
+		if (!pin.net || pin.part > parts.size()) intact = false;
+	}
+
+	nails.resize(header->nail_count);
+	for (size_t i = 0; i < nails.size(); i++) {
+		const CacheNail &cached = cache_nails[i];
+		BRDNail &nail           = nails[i];
+		nail.probe              = cached.probe;
+		nail.pos                = {cached.x, cached.y};
+		nail.side               = cached.side;
+		nail.net                = read_string(cached.net);
+		if (!nail.net) intact   = false;
+	}
+
+	for (uint32_t i = 0; i < header->analysed_count; i++) {
+		const CacheAnalysedPart &cached = cache_analysed[i];
+		if (cached.hull_first > header->hull_point_count || cached.hull_count > header->hull_point_count - cached.hull_first)
+			intact = false;
+	}
+
+	valid = intact;
+	if (valid) {
+		m_header    = header;
+		m_analysed  = cache_analysed;
+		m_hull      = cache_hull;
+		m_diameters = cache_diameters;
+	}
+}
+
+bool BoardCacheFile::RestoreAnalysis(Board &board, float pin_diameter) const {
+	if (!m_header || m_header->pin_diameter != pin_diameter) return false;
+
+	auto parts = board.ComponentSpan();
+	auto pins  = board.PinSpan();
+	if (m_header->analysed_count != parts.size() || m_header->diameter_count != pins.size()) return false;
+
+	for (size_t i = 0; i < parts.size(); i++) {
+		const CacheAnalysedPart &cached = m_analysed[i];
+		Component &part                 = parts[i];
+		memcpy(part.outline, cached.outline, sizeof(part.outline));
+		part.centerpoint    = cached.centerpoint;
+		part.expanse        = cached.expanse;
+		part.component_type = static_cast<Component::EComponentType>(cached.component_type);
+		part.outline_done   = cached.outline_done != 0;
+		part.hull_count     = cached.hull_count;
+		part.hull           = NULL;
+		if (cached.hull_count) {
+			part.hull = board.Memory().alloc<outline_pt>(cached.hull_count);
+			memcpy(part.hull, m_hull + cached.hull_first, cached.hull_count * sizeof(outline_pt));
+		}
+	}
+	for (size_t i = 0; i < pins.size(); i++) board.SetPinDiameter(&pins[i], m_diameters[i]);
+	return true;
+}
+
+std::string BoardCacheFile::filename(uint64_t source_hash) {
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.obvcache", static_cast<unsigned long long>(source_hash));
+	return name;
+}
+
+// Strings of a snapshot, each distinct one is stored once
+class SnapshotStrings {
+  public:
+	uint32_t add(const char *s) {
+		if (!s) return no_string;
+		size_t len    = strlen(s);
+		Symbol symbol = m_pool.intern(s, len);
+		if (symbol == m_offsets.size()) { // Symbols are numbered in interning order
+			m_offsets.push_back(m_data.size());
+			m_data.append(s, len + 1);
+		}
+		return m_offsets[symbol];
+	}
+
+	const std::string &data() const {
+		return m_data;
+	}
+
+  private:
+	Arena m_chars;
+	StringPool m_pool{m_chars};
+	std::vector<uint32_t> m_offsets; // Indexed by symbol
+	std::string m_data;
+};
+
+bool BoardCacheFile::write(
+    const BRDFile &file, Board &board, float pin_diameter, uint64_t source_hash, uint64_t source_size, const std::string &path) {
+	SnapshotStrings pool;
+
+	auto parts = board.ComponentSpan();
+	std::vector<CacheAnalysedPart> cache_analysed(parts.size());
+	std::vector<outline_pt> cache_hull;
+	for (size_t i = 0; i < parts.size(); i++) {
+		const Component &part     = parts[i];
+		CacheAnalysedPart &cached = cache_analysed[i];
+		memcpy(cached.outline, part.outline, sizeof(cached.outline));
+		cached.centerpoint    = part.centerpoint;
+		cached.expanse        = part.expanse;
+		cached.hull_first     = cache_hull.size();
+		cached.hull_count     = part.hull ? part.hull_count : 0;
+		cached.component_type = part.component_type;
+		cached.outline_done   = part.outline_done;
+		cache_hull.insert(cache_hull.end(), part.hull, part.hull + cached.hull_count);
+	}
+
+	auto pins = board.PinSpan();
+	std::vector<float> cache_diameters(pins.size());
+	for (size_t i = 0; i < pins.size(); i++) cache_diameters[i] = pins[i].diameter;
+
+	std::vector<CachePin> cache_pins(file.pins.size());
+	for (size_t i = 0; i < file.pins.size(); i++) {
+		const BRDPin &pin = file.pins[i];
+		CachePin &cached  = cache_pins[i];
+		cached.radius     = pin.radius;
+		cached.x          = pin.pos.x;
+		cached.y          = pin.pos.y;
+		cached.probe      = pin.probe;
+		cached.part       = pin.part;
+		cached.side       = pin.side;
+		cached.net        = pool.add(pin.net);
+		cached.snum       = pool.add(pin.snum);
+		cached.reserved   = 0;
+	}
+
+	std::vector<CachePart> cache_parts(file.parts.size());
+	for (size_t i = 0; i < file.parts.size(); i++) {
+		const BRDPart &part = file.parts[i];
+		CachePart &cached   = cache_parts[i];
+		cached.name         = pool.add(part.name);
+		cached.mfgcode      = pool.add(part.mfgcode.c_str());
+		cached.type         = part.type;
+		cached.end_of_pins  = part.end_of_pins;
+		cached.x1           = part.p1.x;
+		cached.y1           = part.p1.y;
+		cached.x2           = part.p2.x;
+		cached.y2           = part.p2.y;
+	}
+
+	std::vector<CacheNail> cache_nails(file.nails.size());
+	for (size_t i = 0; i < file.nails.size(); i++) {
+		const BRDNail &nail = file.nails[i];
+		CacheNail &cached   = cache_nails[i];
+		cached.probe        = nail.probe;
+		cached.x            = nail.pos.x;
+		cached.y            = nail.pos.y;
+		cached.side         = nail.side;
+		cached.net          = pool.add(nail.net);
+	}
+
+	std::vector<CachePoint> cache_points(file.format.size());
+	for (size_t i = 0; i < file.format.size(); i++) {
+		cache_points[i].x = file.format[i].x;
+		cache_points[i].y = file.format[i].y;
+	}
+
+	if (pool.data().size() >= string_limit) return false;
+
+	CacheHeader header;
+	memcpy(header.magic, cache_magic, sizeof(cache_magic));
+	header.version          = version;
+	header.strings_size     = pool.data().size();
+	header.source_hash      = source_hash;
+	header.source_size      = source_size;
+	header.format_count     = cache_points.size();
+	header.part_count       = cache_parts.size();
+	header.pin_count        = cache_pins.size();
+	header.nail_count       = cache_nails.size();
+	header.num_format       = file.num_format;
+	header.num_parts        = file.num_parts;
+	header.num_pins         = file.num_pins;
+	header.num_nails        = file.num_nails;
+	header.analysed_count   = cache_analysed.size();
+	header.hull_point_count = cache_hull.size();
+	header.diameter_count   = cache_diameters.size();
+	header.pin_diameter     = pin_diameter;
+
+	// Write to a temporary file first so a snapshot is either complete or absent
+	std::string tmp_path = path + ".tmp";
+	{
+		std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char *>(cache_analysed.data()), cache_analysed.size() * sizeof(CacheAnalysedPart));
+		out.write(reinterpret_cast<const char *>(cache_hull.data()), cache_hull.size() * sizeof(outline_pt));
+		out.write(reinterpret_cast<const char *>(cache_pins.data()), cache_pins.size() * sizeof(CachePin));
+		out.write(reinterpret_cast<const char *>(cache_parts.data()), cache_parts.size() * sizeof(CachePart));
+		out.write(reinterpret_cast<const char *>(cache_nails.data()), cache_nails.size() * sizeof(CacheNail));
+		out.write(reinterpret_cast<const char *>(cache_points.data()), cache_points.size() * sizeof(CachePoint));
+		out.write(reinterpret_cast<const char *>(cache_diameters.data()), cache_diameters.size() * sizeof(float));
+		out.write(pool.data().data(), pool.data().size());
+		if (!out.good()) {
+			out.close();
+			std::remove(tmp_path.c_str());
+			std::cerr << "Error writing board cache " << tmp_path << std::endl;
+			return false;
+		}
+	}
+	std::remove(path.c_str()); // rename() does not replace existing files everywhere
+	if (std::rename(tmp_path.c_str(), path.c_str())) {
+		std::remove(tmp_path.c_str());
+		return false;
+	}
+	return true;
+}
+
+/*
+ * XXH64, four independent lanes over 32-byte stripes. Fast enough that hashing
+ * a board file costs a fraction of reading it.
+ */
+static const uint64_t prime64_1 = 11400714785074694791ULL;
+static const uint64_t prime64_2 = 14029467366897019727ULL;
+static const uint64_t prime64_3 = 1609587929392839161ULL;
+static const uint64_t prime64_4 = 9650029242287828579ULL;
+static const uint64_t prime64_5 = 2870177450012600261ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const char *p) {
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t read32(const char *p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t input) {
+	acc += input * prime64_2;
+	acc = rotl64(acc, 31);
+	return acc * prime64_1;
+}
+
+static inline uint64_t hash_merge(uint64_t acc, uint64_t lane) {
+	acc ^= hash_round(0, lane);
+	return acc * prime64_1 + prime64_4;
+}
+
+uint64_t content_hash(const char *buf, size_t size, uint64_t seed) {
+	const char *p   = buf;
+	const char *end = buf + size;
+	uint64_t h;
+
+	if (size >= 32) {
+		uint64_t v1 = seed + prime64_1 + prime64_2;
+		uint64_t v2 = seed + prime64_2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - prime64_1;
+		for (; end - p >= 32; p += 32) {
+			v1 = hash_round(v1, read64(p));
+			v2 = hash_round(v2, read64(p + 8));
+			v3 = hash_round(v3, read64(p + 16));
+			v4 = hash_round(v4, read64(p + 24));
+		}
+		h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+		h = hash_merge(h, v1);
+		h = hash_merge(h, v2);
+		h = hash_merge(h, v3);
+		h = hash_merge(h, v4);
+	} else {
+		h = seed + prime64_5;
+	}
+	h += size;
+
+	for (; end - p >= 8; p += 8) h = rotl64(h ^ hash_round(0, read64(p)), 27) * prime64_1 + prime64_4;
+	if (end - p >= 4) {
+		h = rotl64(h ^ (read32(p) * prime64_1), 23) * prime64_2 + prime64_3;
+		p += 4;
+	}
+	for (; p < end; p++) h = rotl64(h ^ (static_cast<uint8_t>(*p) * prime64_5), 11) * prime64_1;
+
+	h ^= h >> 33;
+	h *= prime64_2;
+	h ^= h >> 29;
+	h *= prime64_3;
+	h ^= h >> 32;
+	return h;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "BRDFile.h"
+#include <stdint.h>
+#include <string>
+
+class Board;
+struct CacheHeader;
+struct CacheAnalysedPart;
+
+/*
+ * Binary snapshot of a parsed board, stored next to the configuration so
+ * opening the same file again skips decoding and parsing altogether.
+ *
+ * A snapshot is a header followed by fixed-size records (pins, parts, nails,
+ * outline) and a pool of NUL-terminated strings the records refer to by
+ * offset. Everything is naturally aligned so the snapshot is used straight
+ * from its mapping: strings are never copied out of it.
+ *
+ * It also holds what AnalyseParts() worked out for the board built from those
+ * records (part outlines, hulls and pin diameters), so a board loaded from a
+ * snapshot does not need analysing again.
+ *
+ * Snapshots are named after the hash of the source file. One is only used if
+ * the hash, the size of the source and the snapshot version all match.
+ */
+struct BoardCacheFile : public BRDFile {
+	// Bump whenever the layout or the content of a snapshot changes
+	static constexpr uint32_t version = 2;
+
+	// snapshot must be a read-only mapping of a file written by write()
+	BoardCacheFile(MappedFile &&snapshot, uint64_t source_hash, uint64_t source_size);
+
+	/*
+	 * Gives board, built from this file, the part analysis of the snapshot.
+	 * False if the analysis was done with another pin_diameter or does not fit
+	 * the board, which then still needs AnalyseParts().
+	 */
+	bool RestoreAnalysis(Board &board, float pin_diameter) const;
+
+	// Name of the snapshot for a source file with the given hash
+	static std::string filename(uint64_t source_hash);
+
+	// Writes a snapshot of file and the analysed board built from it to path, returns false on failure
+	static bool write(const BRDFile &file,
+	                  Board &board,
+	                  float pin_diameter,
+	                  uint64_t source_hash,
+	                  uint64_t source_size,
+	                  const std::string &path);
+
+  private:
+	// In the mapping, set once the snapshot is found valid
+	const CacheHeader *m_header         = nullptr;
+	const CacheAnalysedPart *m_analysed = nullptr;
+	const outline_pt *m_hull            = nullptr;
+	const float *m_diameters            = nullptr;
+};
+
+// Fast non-cryptographic 64-bit hash of size bytes (XXH64)
+uint64_t content_hash(const char *buf, size_t size, uint64_t seed = 0);
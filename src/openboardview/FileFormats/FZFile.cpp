@@ -1,9 +1,12 @@
 #include "FZFile.h"
+#include "BoardBuilder.h"
+#include "parallel.h"
+#include "simd.h"
 #include "utils.h"
 
 #include <assert.h>
 #include <ctype.h>
-#include <locale.h>
+#include <limits.h>
 #include <stdint.h>
 #include <string.h>
 #include <unordered_map>
@@ -14,70 +17,123 @@
 
 // Looking at the paper the algo is straight forward, not sure about endianness.
 // This will put out some .bin file you would decompress using zlib.
-// constexpr uint32_t FZFile::key[44];
-uint32_t FZFile::key[44];
+static inline uint32_t rotl32(uint32_t a, uint32_t b) {
+	b &= 31; // RC6 rotates by the low 5 bits
+	return (a << b) | (a >> ((32 - b) & 31));
+}
 
-static inline uint32_t rotl32(uint32_t a, int32_t b) {
-	return (a << b) | (a >> (32 - b));
+static inline uint32_t le32(const uint8_t *p) {
+	return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
 }
 
 /*
- * Decrypt an RC6 encrypted buffer using key
+ * Returns the byte to xor with the ciphertext byte following the 16 bytes at in.
+ * (A, B, C, D) are loaded from those 16 ciphertext bytes and encrypted with RC6,
+ * the low byte of A is the result.
  */
-void FZFile::decode(char *source, size_t size) {
+static inline uint8_t keystream_byte(const uint8_t *in, const uint32_t *key) {
 	// Along the lines of http://people.csail.mit.edu/rivest/pubs/RRSY98.pdf
 	// (page 3, 2.2)
-	int32_t logw = 5;
-	uint32_t r   = 20;
-
-	uint32_t A = 0;
-	uint32_t B = 0;
-	uint32_t C = 0;
-	uint32_t D = 0;
+	const int32_t logw = 5;
+	const uint32_t r   = 20;
 
-	uint8_t currentByte;
-	uint8_t ibuf[16] = {0}; // you'll see
+	// align 4 consequent int32s to that buffer
+	// (A, B, C, D) = (buf[0], buf[1], buf[2], buf[3])
+	uint32_t A = le32(in);
+	uint32_t B = le32(in + 4);
+	uint32_t C = le32(in + 8);
+	uint32_t D = le32(in + 12);
 
 	// RC6 algo from the paper, basically 1:1
-	for (size_t pos = 0; pos < size; ++pos) {
-		B = B + key[0];
-		D = D + key[1];
-		for (uint32_t i = 1; i < (r + 1); ++i) { // loop offset by 1
-			uint32_t t = rotl32(B * (2 * B + 1), logw);
-			uint32_t u = rotl32(D * (2 * D + 1), logw);
-			A          = rotl32(A ^ t, u) + key[2 * i];
-			C          = rotl32(C ^ u, t) + key[2 * i + 1];
-
-			uint32_t tmp = A;
-			A            = B;
-			B            = C;
-			C            = D;
-			D            = tmp;
-		}
-		A = A + key[2 * r + 2];
-		C = C + key[2 * r + 3]; // not used I guess
-
-		// rolling over the the uint8_t string
-		// buf[pos] xor A -> is our resulting byte
-		currentByte = source[pos];
-		source[pos] = ((uint8_t)(currentByte ^ (A & 0xFF)));
-		//fprintf(stdout,"%c",source[pos]);
-
-		// pushing in a stream of buf[pos] chars 'from the right'
-		// and shift whole array 8 bits to the left
-		for (uint32_t i = 0; i < 15; ++i) {
-			ibuf[i] = ibuf[i + 1];
-		}
-		ibuf[15] = currentByte;
-
-		// align 4 consequent int32s to that buffer
-		// (A, B, C, D) = (buf[0], buf[1], buf[2], buf[3])
-		// byte order?!
-		A = ibuf[0] | ibuf[1] << 8 | ibuf[2] << 16 | ibuf[3] << 24;
-		B = ibuf[4] | ibuf[5] << 8 | ibuf[6] << 16 | ibuf[7] << 24;
-		C = ibuf[8] | ibuf[9] << 8 | ibuf[10] << 16 | ibuf[11] << 24;
-		D = ibuf[12] | ibuf[13] << 8 | ibuf[14] << 16 | ibuf[15] << 24;
+	B = B + key[0];
+	D = D + key[1];
+	for (uint32_t i = 1; i < (r + 1); ++i) { // loop offset by 1
+		uint32_t t = rotl32(B * (2 * B + 1), logw);
+		uint32_t u = rotl32(D * (2 * D + 1), logw);
+		A          = rotl32(A ^ t, u) + key[2 * i];
+		C          = rotl32(C ^ u, t) + key[2 * i + 1];
+
+		uint32_t tmp = A;
+		A            = B;
+		B            = C;
+		C            = D;
+		D            = tmp;
+	}
+	A = A + key[2 * r + 2]; // C is not used
+
+	return A & 0xFF;
+}
+
+#ifdef OBV_AVX2
+OBV_TARGET_AVX2 static inline __m256i rotl32_avx2(__m256i a, __m256i b) {
+	b = _mm256_and_si256(b, _mm256_set1_epi32(31));
+	// Shifting by 32 gives 0
+	return _mm256_or_si256(_mm256_sllv_epi32(a, b), _mm256_srlv_epi32(a, _mm256_sub_epi32(_mm256_set1_epi32(32), b)));
+}
+
+/*
+ * keystream_byte() for the 8 positions following in[0..15], in[1..16], ... in[7..22]
+ */
+OBV_TARGET_AVX2 static void keystream_avx2(const uint8_t *in, const uint32_t *key, uint8_t *out) {
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); // One byte apart
+	const __m256i one   = _mm256_set1_epi32(1);
+
+	__m256i A = _mm256_i32gather_epi32(reinterpret_cast<const int *>(in), lanes, 1);
+	__m256i B = _mm256_i32gather_epi32(reinterpret_cast<const int *>(in + 4), lanes, 1);
+	__m256i C = _mm256_i32gather_epi32(reinterpret_cast<const int *>(in + 8), lanes, 1);
+	__m256i D = _mm256_i32gather_epi32(reinterpret_cast<const int *>(in + 12), lanes, 1);
+
+	B = _mm256_add_epi32(B, _mm256_set1_epi32(key[0]));
+	D = _mm256_add_epi32(D, _mm256_set1_epi32(key[1]));
+	for (uint32_t i = 1; i < 21; ++i) { // r = 20 rounds, as above
+		__m256i t = _mm256_mullo_epi32(B, _mm256_add_epi32(_mm256_add_epi32(B, B), one));
+		__m256i u = _mm256_mullo_epi32(D, _mm256_add_epi32(_mm256_add_epi32(D, D), one));
+		t         = _mm256_or_si256(_mm256_slli_epi32(t, 5), _mm256_srli_epi32(t, 27));
+		u         = _mm256_or_si256(_mm256_slli_epi32(u, 5), _mm256_srli_epi32(u, 27));
+		A         = _mm256_add_epi32(rotl32_avx2(_mm256_xor_si256(A, t), u), _mm256_set1_epi32(key[2 * i]));
+		C         = _mm256_add_epi32(rotl32_avx2(_mm256_xor_si256(C, u), t), _mm256_set1_epi32(key[2 * i + 1]));
+
+		__m256i tmp = A;
+		A           = B;
+		B           = C;
+		C           = D;
+		D           = tmp;
 	}
+	A = _mm256_add_epi32(A, _mm256_set1_epi32(key[42]));
+
+	uint32_t words[8];
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(words), A);
+	for (int i = 0; i < 8; i++) out[i] = words[i] & 0xFF;
+}
+#endif
+
+/*
+ * Decrypt an RC6 encrypted buffer using key
+ *
+ * Every byte is xored with the RC6 encryption of the 16 ciphertext bytes
+ * preceding it (zeros before the start). As the ciphertext is known up front,
+ * all bytes are independent: the buffer is split across threads, reading from
+ * a copy of the ciphertext, and 8 bytes are done at once with AVX2.
+ */
+void FZFile::decode(char *source, size_t size, const uint32_t *key) {
+	if (size == 0) return;
+	uint8_t *buf = reinterpret_cast<uint8_t *>(source);
+
+	std::vector<uint8_t> cipher(16 + size); // The ciphertext, shifted so the 16 bytes before buf[pos] start at cipher[pos]
+	memcpy(cipher.data() + 16, buf, size);
+
+	parallel_for(size, 1 << 16, [&](size_t begin, size_t end) {
+		size_t pos = begin;
+#ifdef OBV_AVX2
+		if (cpu_has_avx2())
+			for (; end - pos >= 8; pos += 8) {
+				uint8_t stream[8];
+				keystream_avx2(&cipher[pos], key, stream);
+				for (int i = 0; i < 8; i++) buf[pos + i] ^= stream[i];
+			}
+#endif
+		for (; pos < end; ++pos) buf[pos] ^= keystream_byte(&cipher[pos], key);
+	});
 }
 
 /*
@@ -97,12 +153,17 @@ char *FZFile::split(char *file_buf, size_t buffer_size, size_t &content_size, ch
 
 /*
  * Inflates the zlib compressed data from buffer
+ * Output space starts at a typical compression ratio and doubles when full, so
+ * inflated data is moved at most a couple of times on average.
+ * The output is NUL-terminated, output_size is set to the inflated length
  */
 char *FZFile::decompress(char *file_buf, size_t buffer_size, size_t &output_size) {
-	output_size = buffer_size;
+	output_size = 0;
 	if (buffer_size == 0) return nullptr;
 
-	char *output = (char *)calloc(output_size, sizeof(char));
+	size_t capacity = 4 * buffer_size + 1; // + 1 for the terminating NUL
+	char *output    = (char *)malloc(capacity);
+	if (!output) return nullptr;
 
 	z_stream zst;
 	zst.next_in   = (Bytef *)file_buf;
@@ -110,6 +171,7 @@ char *FZFile::decompress(char *file_buf, size_t buffer_size, size_t &output_size
 	zst.total_out = 0;
 	zst.zalloc    = Z_NULL;
 	zst.zfree     = Z_NULL;
+	zst.opaque    = Z_NULL;
 
 	if (inflateInit(&zst) != Z_OK) {
 		free(output);
@@ -118,18 +180,20 @@ char *FZFile::decompress(char *file_buf, size_t buffer_size, size_t &output_size
 
 	int ret;
 	do {
-		// If our output buffer is too small
-		if (zst.total_out >= output_size) {
-			// Increase size of output buffer
-			char *buf = (char *)calloc(output_size + buffer_size / 2, sizeof(char));
-			memcpy(buf, output, output_size);
-			output_size += buffer_size / 2;
-			free(output);
+		// If our output buffer is full
+		if (zst.total_out + 1 >= capacity) {
+			char *buf = (char *)realloc(output, 2 * capacity);
+			if (!buf) {
+				inflateEnd(&zst);
+				free(output);
+				return nullptr;
+			}
 			output = buf;
+			capacity *= 2;
 		}
 
 		zst.next_out  = (Bytef *)(output + zst.total_out);
-		zst.avail_out = output_size - zst.total_out;
+		zst.avail_out = capacity - 1 - zst.total_out;
 	} while ((ret = inflate(&zst, Z_SYNC_FLUSH)) == Z_OK);
 
 	if (ret != Z_STREAM_END) printf("Error %d: %s\n", ret, zst.msg);
@@ -138,24 +202,23 @@ char *FZFile::decompress(char *file_buf, size_t buffer_size, size_t &output_size
 		free(output);
 		return nullptr;
 	}
+	output_size         = zst.total_out;
+	output[output_size] = 0;
 
 	return output;
 }
 
 /*
  * Creates fake points for outline using outermost pins plus some margin.
+ * low and high are the least and greatest coordinates of the pins.
  */
 #define OUTLINE_MARGIN 20
-void FZFile::gen_outline() {
+void FZFile::gen_outline(BRDPoint low, BRDPoint high) {
 	// Determine board outline
-	int minx =
-	    std::min_element(pins.begin(), pins.end(), [](BRDPin a, BRDPin b) { return a.pos.x < b.pos.x; })->pos.x - OUTLINE_MARGIN;
-	int maxx =
-	    std::max_element(pins.begin(), pins.end(), [](BRDPin a, BRDPin b) { return a.pos.x < b.pos.x; })->pos.x + OUTLINE_MARGIN;
-	int miny =
-	    std::min_element(pins.begin(), pins.end(), [](BRDPin a, BRDPin b) { return a.pos.y < b.pos.y; })->pos.y - OUTLINE_MARGIN;
-	int maxy =
-	    std::max_element(pins.begin(), pins.end(), [](BRDPin a, BRDPin b) { return a.pos.y < b.pos.y; })->pos.y + OUTLINE_MARGIN;
+	int minx = low.x - OUTLINE_MARGIN;
+	int maxx = high.x + OUTLINE_MARGIN;
+	int miny = low.y - OUTLINE_MARGIN;
+	int maxy = high.y + OUTLINE_MARGIN;
 	format.push_back({minx, miny});
 	format.push_back({maxx, miny});
 	format.push_back({maxx, maxy});
@@ -174,26 +237,18 @@ void FZFile::update_counts() {
 	num_nails  = nails.size();
 }
 
-FZFile::FZFile(std::vector<char> &buf, uint32_t *fzkey) {
-	auto buffer_size = buf.size();
-	char *saved_locale;
+FZFile::FZFile(MappedFile &&file, uint32_t *fzkey, BoardBuilder *builder) {
+	file_map         = std::move(file);
+	streamed         = builder != nullptr;
+	auto buffer_size = file_map.size();
 	float multiplier = 1.0f;
-	saved_locale = setlocale(LC_NUMERIC, "C"); // Use '.' as delimiter for strtod
 
 	memcpy(key, fzkey, sizeof(key));
 
 	ENSURE(buffer_size > 4);
-	size_t file_buf_size = 3 * (1 + buffer_size);
-	file_buf             = (char *)calloc(1, file_buf_size);
+	file_buf = file_map.data(); // Already NUL-terminated
 	ENSURE(file_buf != nullptr);
 
-	std::copy(buf.begin(), buf.end(), file_buf);
-	file_buf[buffer_size] = 0;
-	// This is for fixing degenerate utf8
-	char *arena     = &file_buf[buffer_size + 1];
-	char *arena_end = file_buf + file_buf_size - 1;
-	*arena_end      = 0;
-
 	/*
 	 * Some non-encrypted, but zip-encoded files are popping up now and then.
 	 *
@@ -212,7 +267,7 @@ FZFile::FZFile(std::vector<char> &buf, uint32_t *fzkey) {
 		 *
 		 * 1 in ~2^16 chance of a false hit.
 		 */
-		FZFile::decode(file_buf, buffer_size); // RC6 decryption
+		FZFile::decode(file_buf, buffer_size, key); // RC6 decryption
 	}
 
 	size_t content_size = 0;
@@ -231,31 +286,59 @@ FZFile::FZFile(std::vector<char> &buf, uint32_t *fzkey) {
 
 	ENSURE(content != nullptr);
 	ENSURE(content_size > 0);
-	content = FZFile::decompress(content, content_size, content_size); // decompress zlib content data
-	ENSURE(content != nullptr);
+	content_buf = FZFile::decompress(content, content_size, content_size); // decompress zlib content data
+	ENSURE(content_buf != nullptr);
 	ENSURE(content_size > 0);
 
 	ENSURE(content != descr);
 	ENSURE(descr_size > 0);
-	descr = FZFile::decompress(descr, descr_size, descr_size);
-	ENSURE(descr != nullptr);
+	descr_buf = FZFile::decompress(descr, descr_size, descr_size);
+	ENSURE(descr_buf != nullptr);
 	ENSURE(descr_size > 0);
 
+	report_load_stage(LoadStage::Parse);
+	if (load_cancelled()) return;
+
 	int current_block = 0;
 	std::unordered_map<std::string, int> parts_id; // map between part name and part number
 
-	char **lines_content = stringfile(content);
-	ENSURE(lines_content);
-
-	char **lines_descr = stringfile(descr);
-	ENSURE(lines_descr);
+	/*
+	 * Pins are sorted before they are used. Streamed, only where each one is
+	 * and what it is sorted by are kept, and it is parsed again from its line
+	 * once sorted, which parsing strings in place leaves readable.
+	 */
+	struct PinLine {
+		char *line;
+		const char *snum;
+		unsigned int part;
+		float multiplier;
+	};
+	std::vector<PinLine> pin_lines;
+	unsigned int nail_count = 0;
+	BRDPoint low{INT_MAX, INT_MAX}, high{INT_MIN, INT_MIN}; // Bounds of the pins
+
+	auto parse_pin = [&](char *p, float multiplier, BRDPin &pin) {
+		char *s;
+		pin.net    = READ_STR();
+		char *part = READ_STR();
+		pin.part   = parts_id.at(part);
+		pin.snum   = READ_STR();
+		/*char *name =*/READ_STR();
+		double posx   = READ_DOUBLE();
+		pin.pos.x     = posx * multiplier;
+		double posy   = READ_DOUBLE();
+		pin.pos.y     = posy * multiplier;
+		pin.probe     = READ_UINT();
+		double radius = READ_DOUBLE() / 100;
+		pin.radius    = std::max(radius, 0.5) * multiplier;
+	};
+
+	LineReader lines_content(content_buf, content_size);
+	LineReader lines_descr(descr_buf, descr_size);
 
 	// Parse the content part (parts, pins, nails)
 	
-	while (*lines_content) {
-		char *line = *lines_content;
-		++lines_content;
-
+	while (char *line = lines_content.next()) {
 		//fprintf(stdout,"%s\n", line);
 
 		while (isspace((uint8_t)*line)) line++;
@@ -307,21 +390,13 @@ FZFile::FZFile(std::vector<char> &buf, uint32_t *fzkey) {
 			} break;
 			case 2: { // Pins
 				BRDPin pin;
-				pin.net = READ_STR();
-				char *part = READ_STR();
-				pin.part = parts_id.at(part);
-				pin.snum = READ_STR();
-				/*char *name =*/ READ_STR();
-				double posx = READ_DOUBLE();
-				pin.pos.x = posx *multiplier;
-				double posy = READ_DOUBLE();
-				pin.pos.y = posy *multiplier;
-				pin.probe = READ_UINT();
-				double radius = READ_DOUBLE();
-				radius /= 100;
-				if (radius < 0.5f) radius = 0.5f;
-				pin.radius                = radius *multiplier;
-				pins.push_back(pin);
+				parse_pin(p, multiplier, pin);
+				low  = {std::min(low.x, pin.pos.x), std::min(low.y, pin.pos.y)};
+				high = {std::max(high.x, pin.pos.x), std::max(high.y, pin.pos.y)};
+				if (builder)
+					pin_lines.push_back({p, pin.snum, pin.part, multiplier});
+				else
+					pins.push_back(pin);
 			} break;
 			case 3: {   // Nails
 				p += 2; // Skip "Y!"
@@ -341,18 +416,19 @@ FZFile::FZFile(std::vector<char> &buf, uint32_t *fzkey) {
 				else
 					nail.side = 2; // on bottom
 				/*double radius =*/ READ_DOUBLE();
-				nails.push_back(nail);
+				if (builder)
+					builder->addNail(nail);
+				else
+					nails.push_back(nail);
+				nail_count++;
 			} break;
 		}
 	}
 
 
 	// Parse the descr part (parts info)
-	lines_descr += 2; // Discard first 2 lines (board description, currently unused and table columns name)
-	while (*lines_descr) {
-		char *line = *lines_descr;
-		++lines_descr;
-
+	lines_descr.skip(2); // Discard first 2 lines (board description, currently unused and table columns name)
+	while (char *line = lines_descr.next()) {
 		while (isspace((uint8_t)*line)) line++;
 		if (!line[0]) continue;
 
@@ -380,17 +456,39 @@ FZFile::FZFile(std::vector<char> &buf, uint32_t *fzkey) {
 	}
 
 
-	std::sort(pins.begin(), pins.end()); // sort vector by part num then pin num
-	for (std::vector<int>::size_type i = 0; i < pins.size(); i++) {
-		// update end_of_pins field
-		if (pins[i].part > 0) parts[pins[i].part - 1].end_of_pins = i;
+	if (builder) {
+		// The same order as BRDPin's, by part num then pin num
+		std::sort(pin_lines.begin(), pin_lines.end(), [](const PinLine &a, const PinLine &b) {
+			return a.part == b.part ? strcmp(a.snum, b.snum) < 0 : a.part < b.part;
+		});
+		for (std::vector<int>::size_type i = 0; i < pin_lines.size(); i++) {
+			// update end_of_pins field
+			if (pin_lines[i].part > 0) parts[pin_lines[i].part - 1].end_of_pins = i;
+		}
+	} else {
+		std::sort(pins.begin(), pins.end()); // sort vector by part num then pin num
+		for (std::vector<int>::size_type i = 0; i < pins.size(); i++) {
+			// update end_of_pins field
+			if (pins[i].part > 0) parts[pins[i].part - 1].end_of_pins = i;
+		}
 	}
 
-	gen_outline();
+	gen_outline(low, high);
 
 	update_counts();
 
-	setlocale(LC_NUMERIC, saved_locale); // Restore locale
+	if (builder) {
+		num_pins  = pin_lines.size(); // Not in the vectors, which were left empty
+		num_nails = nail_count;
+
+		for (auto &point : format) builder->addOutlinePoint(point);
+		for (auto &part : parts) builder->beginPart(part);
+		for (auto &pin_line : pin_lines) {
+			BRDPin pin;
+			parse_pin(pin_line.line, pin_line.multiplier, pin);
+			builder->addPin(pin);
+		}
+	}
 
 	valid = current_block != 0;
 }
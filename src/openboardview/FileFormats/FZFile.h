@@ -8,19 +8,19 @@
 #undef READ_STR
 /* '!' is the delimiter for the content part */
 #define READ_INT [&]() {                                     \
-		int value = strtol(p, &p, 10);               \
+		int value = scan_long(p, &p);                \
 		if (*p == '!') p++;                          \
 		return value;                                \
 	}
 // Warning: read as int then cast to uint if positive
 #define READ_UINT [&]() {                                    \
-		int value = strtol(p, &p, 10);               \
+		int value = scan_long(p, &p);                \
 		if (*p == '!') p++;                          \
 		ENSURE(value >= 0);                          \
 		return static_cast<unsigned int>(value);     \
 	}
 #define READ_DOUBLE [&]() {                                  \
-		double val = strtod(p, &p);                  \
+		double val = scan_double(p, &p);             \
 		if (*p == '!') p++;                          \
 		return val;                                  \
 	}
@@ -30,13 +30,13 @@
 		while ((*p) && (*p != '!')) ++p;             \
 		*p = 0;                                      \
 		p++;                                         \
-		return fix_to_utf8(s, &arena, arena_end);    \
+		return fix_to_utf8(s, p - 1 - s, arena);     \
 	}
 
 
 /* '\t' is the delimiter for the descr part */
 #define READ_DESCR_UINT [&]() {                                    \
-		int value = strtol(p, &p, 10);               \
+		int value = scan_long(p, &p);                \
 		if (*p == '\t') p++;                          \
 		ENSURE(value >= 0);                          \
 		return static_cast<unsigned int>(value);     \
@@ -47,7 +47,7 @@
 		while ((*p) && (*p != '\t')) ++p;             \
 		*p = 0;                                      \
 		p++;                                         \
-		return fix_to_utf8(s, &arena, arena_end);    \
+		return fix_to_utf8(s, p - 1 - s, arena);     \
 	}
 
 
@@ -61,25 +61,29 @@ struct FZPartDesc {
 
 class FZFile : public BRDFile {
   public:
-	FZFile(std::vector<char> &buf, uint32_t *fzkey);
+	FZFile(MappedFile &&file, uint32_t *fzkey, BoardBuilder *builder = nullptr);
 	~FZFile() {
-		free(file_buf);
+		free(content_buf);
+		free(descr_buf);
 	}
 
 	void SetKey(char *keytext);
 
+	// RC6 decryption of size bytes of source in place, with the 44 words of key
+	static void decode(char *source, size_t size, const uint32_t *key);
+
   private:
 	std::vector<FZPartDesc> partsDesc;
+	char *content_buf = nullptr; // Inflated content part, parsed strings point in to it
+	char *descr_buf   = nullptr; // Inflated descr part
 
-	static void decode(char *source, size_t size);
 	static char *split(char *file_buf, size_t buffer_size, size_t &content_size, char *&descr, size_t &descr_size);
 	static char *decompress(char *file_buf, size_t buffer_size, size_t &output_size);
-	void gen_outline();
+	void gen_outline(BRDPoint low, BRDPoint high);
 	void update_counts();
 
 	// Put your key here.
 	// uint32_t keylength = 2*r + 4; // i.e. buf[0..2r+3]
-	// static constexpr uint32_t key[44] = {0};
-	// static uint32_t key[44] = {0};
-	static uint32_t key[44];
+	// Copied per file: a cancelled load may still be decoding with its own while the next one starts
+	uint32_t key[44];
 };
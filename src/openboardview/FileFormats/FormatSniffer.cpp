@@ -0,0 +1,130 @@
+#include "FormatSniffer.h"
+
+#include "BRDFile.h"
+#include <algorithm>
+#include <array>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+enum Marker { kStrLength, kVarData, kBrdOut, kNets, kBdvKey, kFormatAsc, kPinsAsc, kBvRaw, kMarkerCount };
+
+static const char *const marker_text[kMarkerCount] = {
+    "str_length:", "var_data:", "BRDOUT:", "NETS:", "dd:1.3?,r?-=bb", "<<format.asc>>", "<<pins.asc>>", "BVRAW_FORMAT_1"};
+
+typedef uint16_t MarkerSet;
+static constexpr MarkerSet marker_bit(int m) {
+	return MarkerSet(1 << m);
+}
+
+// A format is recognised when all markers of one of its rules were seen, rules are in priority order
+struct FormatRule {
+	BoardFormat format;
+	MarkerSet required;
+};
+static const FormatRule format_rules[] = {
+    {BoardFormat::BRD, marker_bit(kStrLength) | marker_bit(kVarData)},
+    {BoardFormat::BRD2, marker_bit(kBrdOut) | marker_bit(kNets)},
+    {BoardFormat::BDV, marker_bit(kBdvKey)},
+    {BoardFormat::BDV, marker_bit(kFormatAsc) | marker_bit(kPinsAsc)},
+    {BoardFormat::BVR, marker_bit(kBvRaw)},
+};
+
+/*
+ * Deterministic automaton matching all markers at once: one table lookup per
+ * byte. The markers are short so states fit in a byte.
+ */
+class MarkerAutomaton {
+  public:
+	MarkerAutomaton() {
+		// Trie of the markers
+		add_state();
+		for (int m = 0; m < kMarkerCount; m++) {
+			uint8_t state = 0;
+			for (const char *c = marker_text[m]; *c; c++) {
+				uint8_t c8 = static_cast<uint8_t>(*c);
+				if (!m_next[state][c8]) {
+					uint8_t added     = add_state(); // May move m_next
+					m_next[state][c8] = added;
+				}
+				state = m_next[state][c8];
+			}
+			m_found[state] |= marker_bit(m);
+		}
+
+		// Breadth-first, complete the transitions with those of the longest proper suffix (failure link)
+		std::vector<uint8_t> fail(m_next.size(), 0);
+		std::vector<uint8_t> queue;
+		for (int c = 0; c < 256; c++)
+			if (m_next[0][c]) queue.push_back(m_next[0][c]);
+		for (size_t i = 0; i < queue.size(); i++) {
+			uint8_t state = queue[i];
+			m_found[state] |= m_found[fail[state]];
+			for (int c = 0; c < 256; c++) {
+				uint8_t &next = m_next[state][c];
+				if (next) {
+					fail[next] = m_next[fail[state]][c];
+					queue.push_back(next);
+				} else {
+					next = m_next[fail[state]][c];
+				}
+			}
+		}
+	}
+
+	// Feeds [p, end) to the automaton, adding the markers that end in it to seen
+	void scan(const char *p, const char *end, uint8_t &state, MarkerSet &seen) const {
+		for (; p < end; p++) {
+			state = m_next[state][static_cast<uint8_t>(*p)];
+			seen |= m_found[state];
+		}
+	}
+
+  private:
+	uint8_t add_state() {
+		m_next.emplace_back();
+		m_next.back().fill(0);
+		m_found.push_back(0);
+		return static_cast<uint8_t>(m_next.size() - 1);
+	}
+
+	std::vector<std::array<uint8_t, 256>> m_next;
+	std::vector<MarkerSet> m_found; // Markers ending at each state
+};
+
+static BoardFormat matching_format(MarkerSet seen) {
+	for (auto &rule : format_rules)
+		if ((seen & rule.required) == rule.required) return rule.format;
+	return BoardFormat::Unknown;
+}
+
+FormatGuess sniff_format(const char *buf, size_t size) {
+	static const MarkerAutomaton automaton;
+	FormatGuess guess;
+
+	if (size >= signature.size() && !memcmp(buf, signature.data(), signature.size())) { // Encoded BRD
+		guess.format     = BoardFormat::BRD;
+		guess.confidence = 1.0f;
+		return guess;
+	}
+
+	uint8_t state    = 0;
+	MarkerSet seen   = 0;
+	const char *end  = buf + size;
+	const char *head = buf + std::min(size, sniff_window);
+	automaton.scan(buf, head, state, seen);
+
+	guess.format = matching_format(seen);
+	if (guess.format != BoardFormat::Unknown) {
+		guess.confidence = 1.0f;
+		return guess;
+	}
+	if (!seen) return guess; // Nothing looking like a board file
+
+	// Only some of the markers, look through the rest of the file so priorities apply as above
+	automaton.scan(head, end, state, seen);
+	guess.format = matching_format(seen);
+
+	if (guess.format != BoardFormat::Unknown) guess.confidence = 0.5f;
+	return guess;
+}
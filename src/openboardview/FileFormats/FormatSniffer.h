@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+
+enum class BoardFormat { Unknown, BRD, BRD2, BDV, BVR };
+
+struct FormatGuess {
+	BoardFormat format = BoardFormat::Unknown;
+	float confidence   = 0.0f; // 1 when identified from the header alone, lower when markers were found further in
+};
+
+/*
+ * Identifies the board file format from the markers each one contains
+ * ("str_length:", "BRDOUT:", "BVRAW_FORMAT_1"...).
+ *
+ * All markers are matched in a single pass (Aho-Corasick automaton) over the
+ * first sniff_window bytes. If that only finds part of the markers a format
+ * needs, the pass goes on through the rest of the file. A header without any
+ * marker is not scanned further.
+ * When several formats match, BRD wins over BRD2, BDV then BVR.
+ */
+FormatGuess sniff_format(const char *buf, size_t size);
+
+static constexpr size_t sniff_window = 64 * 1024;
@@ -0,0 +1,91 @@
+#include "LineReader.h"
+
+#include "simd.h"
+
+/*
+ * Returns the first '\0', '\r' or '\n' at or after p.
+ * The vector versions only load whole blocks before end and finish with the
+ * scalar loop, which is bounded by the NUL at *end.
+ */
+static char *find_break_scalar(char *p) {
+	while (*p && *p != '\r' && *p != '\n') p++;
+	return p;
+}
+
+#ifdef OBV_SSE2
+static char *find_break_sse2(char *p, char *end) {
+	const __m128i cr  = _mm_set1_epi8('\r');
+	const __m128i lf  = _mm_set1_epi8('\n');
+	const __m128i nul = _mm_setzero_si128();
+	for (; end - p >= 16; p += 16) {
+		__m128i v     = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		__m128i hits  = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)), _mm_cmpeq_epi8(v, nul));
+		uint32_t mask = _mm_movemask_epi8(hits);
+		if (mask) return p + ctz32(mask);
+	}
+	return find_break_scalar(p);
+}
+#endif
+
+#ifdef OBV_AVX2
+OBV_TARGET_AVX2 static char *find_break_avx2(char *p, char *end) {
+	const __m256i cr  = _mm256_set1_epi8('\r');
+	const __m256i lf  = _mm256_set1_epi8('\n');
+	const __m256i nul = _mm256_setzero_si256();
+	for (; end - p >= 32; p += 32) {
+		__m256i v     = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		__m256i hits  = _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, lf));
+		hits          = _mm256_or_si256(hits, _mm256_cmpeq_epi8(v, nul));
+		uint32_t mask = _mm256_movemask_epi8(hits);
+		if (mask) return p + ctz32(mask);
+	}
+	return find_break_sse2(p, end);
+}
+#endif
+
+static char *find_break(char *p, char *end) {
+#ifdef OBV_AVX2
+	if (cpu_has_avx2()) return find_break_avx2(p, end);
+#endif
+#ifdef OBV_SSE2
+	if (cpu_has_sse2()) return find_break_sse2(p, end);
+#endif
+	(void)end;
+	return find_break_scalar(p);
+}
+
+LineReader::LineReader(char *buf, size_t size)
+    : m_end(buf + size) {
+	m_pending = split(buf, true);
+}
+
+char *LineReader::next() {
+	char *line          = m_pending;
+	if (line) m_pending = m_rest ? split(m_rest, false) : nullptr;
+	return line;
+}
+
+/*
+ * Terminates the line beginning at start and records where the next one begins.
+ * As in stringfile(), the first char of a line other than the first one is
+ * never taken as a line break.
+ */
+char *LineReader::split(char *start, bool first) {
+	char *brk = find_break(first ? start : start + 1, m_end);
+
+	m_rest = nullptr;
+	while (*brk) {
+		*brk    = 0;
+		char *p = brk + 1;
+		if (*p == '\r' || *p == '\n') p++; // CRLF combo
+		if (*p) {                          // It's not over yet
+			m_rest = p;
+			break;
+		}
+		if (p == m_end) break;
+
+		// A NUL right after a line break is stepped over along with the rest of its line
+		brk = find_break(p + 1, m_end);
+	}
+	return start;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Splits a NUL-terminated buffer in to lines as they are requested.
+ *
+ * Each line is terminated in place at its first '\r' or '\n'. A CRLF (or any
+ * other pair of line break chars) counts as a single break, so blank lines in
+ * CRLF files come out as whitespace-only lines, like stb's stringfile() did.
+ * Splitting stops at buf[size] (which must be 0) or at a NUL byte inside a
+ * line. A NUL right after a line break drops the rest of that line instead.
+ *
+ * The line following the one handed out is always split already, so a parser
+ * running past the end of a short line cannot hide the next line break.
+ */
+class LineReader {
+  public:
+	LineReader(char *buf, size_t size);
+
+	// Returns the next line or nullptr once the buffer is exhausted
+	char *next();
+
+	// Discards the next count lines
+	void skip(size_t count) {
+		while (count-- && next())
+			;
+	}
+
+  private:
+	char *split(char *start, bool first);
+
+	char *m_end;               // The terminating NUL of the buffer
+	char *m_pending = nullptr; // Next line to return, already terminated
+	char *m_rest    = nullptr; // Start of the line after that, nullptr if none
+};
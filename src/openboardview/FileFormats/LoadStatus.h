@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+// Stages a board goes through while being loaded, in order
+enum class LoadStage { Read, Decode, Parse, Build, Analyse, Done };
+static constexpr int load_stage_count = static_cast<int>(LoadStage::Done) + 1;
+
+/*
+ * Progress of a board being loaded in the background, polled by the UI thread.
+ *
+ * The loading thread registers its status with thread_load_status() so the
+ * parsers can report the end of decoding and give up early once cancelled
+ * without having it passed down to them.
+ */
+struct LoadStatus {
+	std::atomic<int> stage{0};
+	std::atomic<bool> cancelled{false};
+
+	// When each stage was entered, only valid for stages up to the current one
+	std::chrono::steady_clock::time_point entered[load_stage_count];
+
+	// Moves on to stage, stages skipped over take no time
+	void Enter(LoadStage next) {
+		auto now = std::chrono::steady_clock::now();
+
+		for (int s = stage + 1; s <= static_cast<int>(next); s++) entered[s] = now;
+
+		stage = static_cast<int>(next);
+	}
+
+	LoadStage Stage() const {
+		return static_cast<LoadStage>(stage.load());
+	}
+};
+
+inline LoadStatus *&thread_load_status() {
+	static thread_local LoadStatus *status = nullptr;
+	return status;
+}
+
+// Called by parsers once the file is decoded
+inline void report_load_stage(LoadStage stage) {
+	if (thread_load_status()) thread_load_status()->Enter(stage);
+}
+
+inline bool load_cancelled() {
+	return thread_load_status() && thread_load_status()->cancelled;
+}
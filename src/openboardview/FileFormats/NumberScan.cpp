@@ -0,0 +1,105 @@
+#include "NumberScan.h"
+
+#include <clocale>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+// Every power of ten up to 1e22 is exactly representable as a double
+static const double pow10_exact[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/*
+ * Hands the number that was scanned between start and stop to strtod(), with
+ * '.' replaced by the decimal point of the current locale.
+ * Only reached for numbers the fast path cannot round exactly (more than 19
+ * significant digits or a large exponent), which board files don't use.
+ */
+static double scan_double_slow(const char *start, char *stop, char **end) {
+	const char *point = localeconv()->decimal_point;
+	std::string number;
+	for (const char *c = start; c < stop; c++) {
+		if (*c == '.')
+			number += point;
+		else
+			number += *c;
+	}
+	*end = stop;
+	return strtod(number.c_str(), nullptr);
+}
+
+/*
+ * Clinger's fast path: when the decimal mantissa fits in 53 bits and the power
+ * of ten is exact, a single IEEE multiplication or division gives the
+ * correctly rounded result.
+ */
+double scan_double(char *p, char **end) {
+	char *s = p;
+	while (scan_isspace(*s)) s++;
+
+	const char *start                    = s;
+	bool negative                        = false;
+	if (*s == '+' || *s == '-') negative = *s++ == '-';
+
+	// Hexadecimal, infinity and NaN don't come up in board files
+	if ((s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) || *s == 'i' || *s == 'I' || *s == 'n' || *s == 'N') return strtod(p, end);
+
+	uint64_t mantissa = 0;
+	int digits        = 0; // Significant digits in mantissa
+	int exponent      = 0;
+	bool any_digit    = false;
+	bool truncated    = false; // Non-zero digits did not fit in mantissa
+
+	for (; *s >= '0' && *s <= '9'; s++) {
+		any_digit = true;
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (*s - '0');
+			if (mantissa) digits++;
+		} else {
+			exponent++;
+			if (*s != '0') truncated = true;
+		}
+	}
+	if (*s == '.') {
+		for (s++; *s >= '0' && *s <= '9'; s++) {
+			any_digit = true;
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*s - '0');
+				if (mantissa) digits++;
+				exponent--;
+			} else if (*s != '0') {
+				truncated = true;
+			}
+		}
+	}
+
+	if (!any_digit) { // No conversion
+		*end = p;
+		return 0.0;
+	}
+
+	if (*s == 'e' || *s == 'E') { // Exponent only counts if digits follow
+		char *e                                  = s + 1;
+		bool exp_negative                        = false;
+		if (*e == '+' || *e == '-') exp_negative = *e++ == '-';
+		if (*e >= '0' && *e <= '9') {
+			int exp_value = 0;
+			for (; *e >= '0' && *e <= '9'; e++)
+				if (exp_value < 100000) exp_value = exp_value * 10 + (*e - '0');
+			exponent += exp_negative ? -exp_value : exp_value;
+			s = e;
+		}
+	}
+
+	if (!truncated && mantissa == 0) {
+		*end = s;
+		return negative ? -0.0 : 0.0;
+	}
+	if (!truncated && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22) {
+		*end         = s;
+		double value = static_cast<double>(mantissa);
+		value        = exponent < 0 ? value / pow10_exact[-exponent] : value * pow10_exact[exponent];
+		return negative ? -value : value;
+	}
+	return scan_double_slow(start, s, end);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <limits.h>
+
+/*
+ * Locale-independent replacements for strtol(p, &end, 10) and strtod(p, &end).
+ *
+ * They accept the same input (leading whitespace, sign, '.' as the decimal
+ * separator whatever LC_NUMERIC says) and leave *end where strtol/strtod
+ * would, so parsers no longer need to switch the process locale and can run
+ * on several threads at once.
+ */
+
+inline bool scan_isspace(char c) {
+	return c == ' ' || (c >= '\t' && c <= '\r'); // " \t\n\v\f\r", isspace() in the "C" locale
+}
+
+// Base 10 strtol(), saturating at LONG_MIN/LONG_MAX like it does
+inline long scan_long(char *p, char **end) {
+	char *s = p;
+	while (scan_isspace(*s)) s++;
+
+	bool negative                        = false;
+	if (*s == '+' || *s == '-') negative = *s++ == '-';
+
+	if (*s < '0' || *s > '9') { // No conversion
+		*end = p;
+		return 0;
+	}
+
+	unsigned long limit = negative ? static_cast<unsigned long>(LONG_MAX) + 1 : LONG_MAX;
+	unsigned long value = 0;
+	bool overflow       = false;
+	for (; *s >= '0' && *s <= '9'; s++) {
+		unsigned digit = *s - '0';
+		if (value > (limit - digit) / 10)
+			overflow = true;
+		else
+			value = value * 10 + digit;
+	}
+	*end = s;
+
+	if (overflow) return negative ? LONG_MIN : LONG_MAX;
+	return negative ? static_cast<long>(0 - value) : static_cast<long>(value);
+}
+
+// strtod(), correctly rounded
+double scan_double(char *p, char **end);
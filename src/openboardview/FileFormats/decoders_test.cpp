@@ -0,0 +1,225 @@
+/*
+ * Checks the file decoders that run on several threads and with vector
+ * instructions against straightforward serial versions of them: every mix of
+ * scalar or vector code and one or several threads must give the same bytes.
+ *
+ * Buffers are random, with lengths around the block and thread boundaries
+ * the decoders split work at and not multiples of the vector width.
+ * Usage: decoders_test [seed]
+ */
+#include "BDVFile.h"
+#include "BRDFile.h"
+#include "FZFile.h"
+#include "parallel.h"
+#include "simd.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+// xorshift64*, the same sequence for a given seed everywhere
+static uint32_t Random() {
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return (rng_state * 0x2545f4914f6cdd1dULL) >> 32;
+}
+
+static std::vector<char> RandomBytes(size_t size) {
+	std::vector<char> bytes(size);
+	for (auto &b : bytes) b = Random();
+	return bytes;
+}
+
+// Ways the decoders can split the work, each must match the serial reference
+struct Variant {
+	const char *name;
+	SimdLevel level;
+	size_t threads;
+};
+
+static const Variant variants[] = {
+    {"scalar, 1 thread", SimdLevel::Scalar, 1},
+    {"scalar, 5 threads", SimdLevel::Scalar, 5},
+    {"SSE2, 1 thread", SimdLevel::SSE2, 1},
+    {"SSE2, 5 threads", SimdLevel::SSE2, 5},
+    {"AVX2, 1 thread", SimdLevel::AVX2, 1},
+    {"AVX2, 5 threads", SimdLevel::AVX2, 5},
+};
+
+static int failures = 0;
+
+static void Check(const char *decoder,
+                  const Variant &variant,
+                  size_t size,
+                  const std::vector<char> &expected,
+                  const std::vector<char> &got) {
+	if (got == expected) return;
+	size_t at = 0;
+	while (got[at] == expected[at]) at++;
+	printf("FAIL %s, %s, %zu bytes: first difference at %zu\n", decoder, variant.name, size, at);
+	failures++;
+}
+
+/*
+ * FZ: the RC6 decryption as FZFile::decode() did it before it was split up,
+ * keeping the last 16 ciphertext bytes as it goes.
+ */
+static uint32_t rotl32(uint32_t a, uint32_t b) {
+	b &= 31;
+	return (a << b) | (a >> ((32 - b) & 31));
+}
+
+static void SerialFZDecode(char *source, size_t size, const uint32_t *key) {
+	const uint32_t r = 20;
+	uint8_t ibuf[16] = {0};
+
+	uint32_t A = 0, B = 0, C = 0, D = 0;
+
+	for (size_t pos = 0; pos < size; ++pos) {
+		B = B + key[0];
+		D = D + key[1];
+		for (uint32_t i = 1; i < (r + 1); ++i) {
+			uint32_t t = rotl32(B * (2 * B + 1), 5);
+			uint32_t u = rotl32(D * (2 * D + 1), 5);
+			A          = rotl32(A ^ t, u) + key[2 * i];
+			C          = rotl32(C ^ u, t) + key[2 * i + 1];
+
+			uint32_t tmp = A;
+			A            = B;
+			B            = C;
+			C            = D;
+			D            = tmp;
+		}
+		A = A + key[2 * r + 2];
+
+		uint8_t currentByte = source[pos];
+		source[pos]         = currentByte ^ (A & 0xFF);
+
+		memmove(ibuf, ibuf + 1, 15);
+		ibuf[15] = currentByte;
+
+		A = ibuf[0] | ibuf[1] << 8 | ibuf[2] << 16 | static_cast<uint32_t>(ibuf[3]) << 24;
+		B = ibuf[4] | ibuf[5] << 8 | ibuf[6] << 16 | static_cast<uint32_t>(ibuf[7]) << 24;
+		C = ibuf[8] | ibuf[9] << 8 | ibuf[10] << 16 | static_cast<uint32_t>(ibuf[11]) << 24;
+		D = ibuf[12] | ibuf[13] << 8 | ibuf[14] << 16 | static_cast<uint32_t>(ibuf[15]) << 24;
+	}
+}
+
+static void TestFZ() {
+	// FZFile::decode() gives threads at least 64 KiB, these split unevenly across 5 of them
+	static const size_t sizes[] = {0, 1, 7, 8, 9, 15, 16, 17, 23, 31, 33, 1021, 65535, 65536, 65537, 2 * 65536 + 3, 5 * 65536 + 13};
+
+	for (size_t size : sizes) {
+		uint32_t key[44];
+		for (auto &k : key) k    = Random();
+		std::vector<char> cipher = RandomBytes(size);
+
+		std::vector<char> expected = cipher;
+		SerialFZDecode(expected.data(), size, key);
+
+		for (const Variant &variant : variants) {
+			set_simd_level(variant.level);
+			set_parallel_threads(variant.threads);
+			std::vector<char> got = cipher;
+			FZFile::decode(got.data(), size, key);
+			Check("FZ", variant, size, expected, got);
+		}
+	}
+}
+
+/*
+ * Encoded BRD and BDV leave '\r', '\n' and NUL as they are, buffers get lots of
+ * them, in runs, so line breaks fall on every vector and block boundary.
+ */
+static std::vector<char> RandomText(size_t size) {
+	static const char breaks[] = {'\r', '\n', '\0', '\r', '\n'};
+	std::vector<char> text(size + 1, 0); // BDV decoding looks one past the end, where files have a NUL
+	for (size_t i = 0; i < size; i++) {
+		uint32_t r = Random();
+		text[i]    = (r & 3) == 0 ? breaks[(r >> 8) % sizeof(breaks)] : static_cast<char>(r >> 16);
+	}
+	return text;
+}
+
+// BRD: every other byte rotated left by 2 bits and inverted, as BRDFile did it byte by byte
+static void SerialBRDDecode(char *buf, size_t size) {
+	for (size_t i = 0; i < size; i++) {
+		char x = buf[i];
+		if (!(x == '\r' || x == '\n' || !x)) {
+			uint8_t c = x;
+			x         = ~((c >> 6) | (c << 2));
+		}
+		buf[i] = x;
+	}
+}
+
+// BDV: key - byte, the key going up after each CRLF, as decode_bdv() did it byte by byte
+static void SerialBDVDecode(char *buf, size_t size) {
+	int count = 0xa0; // First key
+	for (size_t i = 0; i < size; i++) {
+		if (buf[i] == '\r' && buf[i + 1] == '\n') count++;
+		char x                                 = buf[i];
+		if (!(x == '\r' || x == '\n' || !x)) x = count - x;
+		if (count > 285) count                 = 159;
+		buf[i]                                 = x;
+	}
+}
+
+template <typename Reference, typename Decoder>
+static void TestText(const char *name, const size_t *sizes, size_t count, Reference reference, Decoder decoder) {
+	for (size_t s = 0; s < count; s++) {
+		size_t size            = sizes[s];
+		std::vector<char> text = RandomText(size);
+
+		// CRLFs ending at, straddling and starting at the 64 KiB BDV block boundaries in turn
+		size_t shift = 0;
+		for (size_t at = 65536; at + 1 < size; at += 65536, shift = (shift + 1) % 3) {
+			text[at - 2 + shift] = '\r';
+			text[at - 1 + shift] = '\n';
+		}
+
+		std::vector<char> expected = text;
+		reference(expected.data(), size);
+
+		for (const Variant &variant : variants) {
+			set_simd_level(variant.level);
+			set_parallel_threads(variant.threads);
+			std::vector<char> got = text;
+			decoder(got.data(), size);
+			Check(name, variant, size, expected, got);
+		}
+	}
+}
+
+static void TestBRD() {
+	// decode_brd() gives threads at least 1 MiB
+	static const size_t sizes[] = {0, 1, 15, 16, 17, 31, 32, 33, 63, 1000, (1 << 20) + 7, 5 * (1 << 20) + 13};
+	TestText("BRD", sizes, sizeof(sizes) / sizeof(sizes[0]), SerialBRDDecode, decode_brd);
+}
+
+static void TestBDV() {
+	// decode_bdv() works in 64 KiB blocks and gives threads at least 16 of them, the key wraps every 127 CRLFs
+	static const size_t sizes[] = {
+	    0, 1, 2, 15, 16, 17, 31, 32, 33, 47, 1000, 65535, 65536, 65537, 3 * 65536 + 1, 2 * 16 * 65536 + 5, 5 * 16 * 65536 + 13};
+	TestText("BDV", sizes, sizeof(sizes) / sizeof(sizes[0]), SerialBDVDecode, decode_bdv);
+}
+
+int main(int argc, char **argv) {
+	if (argc > 1) rng_state = strtoull(argv[1], nullptr, 0) | 1;
+	if (!cpu_has_avx2()) printf("No AVX2 on this CPU, AVX2 variants run the scalar code\n");
+
+	TestFZ();
+	TestBRD();
+	TestBDV();
+
+	if (failures) {
+		printf("%d failures\n", failures);
+		return 1;
+	}
+	printf("All decoders match\n");
+	return 0;
+}
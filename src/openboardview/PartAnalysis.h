@@ -0,0 +1,13 @@
+#pragma once
+
+#include "Board.h"
+
+/*
+ * Works out the outline, convex hull and pin sizes of every part from the
+ * layout of its pins, so drawing and picking find them ready in the model.
+ *
+ * Pins not recognised as a known footprint keep their diameter, the outlines
+ * are padded by pin_diameter / 2. Parts are split across threads; hulls go in
+ * the board's arena. Run once after the board is built, before it is shown.
+ */
+void AnalyseParts(Board *board, float pin_diameter);
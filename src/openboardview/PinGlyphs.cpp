@@ -0,0 +1,120 @@
+#include "PinGlyphs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+// Signed distance from p to the shape of radius r centred on the origin, negative inside
+static float ShapeDistance(PinGlyph glyph, float x, float y, float r) {
+	if (glyph == kPinGlyphCircle) return sqrtf(x * x + y * y) - r;
+
+	// Corners as DrawBox(), DrawDiamond() and DrawHex() place them
+	ImVec2 corners[6];
+	int count = 0;
+	switch (glyph) {
+		case kPinGlyphSquare:
+			corners[count++] = ImVec2(-r, -r);
+			corners[count++] = ImVec2(r, -r);
+			corners[count++] = ImVec2(r, r);
+			corners[count++] = ImVec2(-r, r);
+			break;
+		case kPinGlyphDiamond:
+			corners[count++] = ImVec2(0, -r);
+			corners[count++] = ImVec2(r, 0);
+			corners[count++] = ImVec2(0, r);
+			corners[count++] = ImVec2(-r, 0);
+			break;
+		default:
+			corners[count++] = ImVec2(-r, 0);
+			corners[count++] = ImVec2(-r * 0.5f, -r * 0.866025404f);
+			corners[count++] = ImVec2(r * 0.5f, -r * 0.866025404f);
+			corners[count++] = ImVec2(r, 0);
+			corners[count++] = ImVec2(r * 0.5f, r * 0.866025404f);
+			corners[count++] = ImVec2(-r * 0.5f, r * 0.866025404f);
+			break;
+	}
+
+	// Nearest edge, inside when on the inner side of all of them (corners go clockwise on screen)
+	float nearest = INFINITY;
+	bool inside   = true;
+	for (int i = 0; i < count; i++) {
+		ImVec2 a = corners[i], b = corners[(i + 1) % count];
+		float ex = b.x - a.x, ey = b.y - a.y;
+		float px = x - a.x, py = y - a.y;
+		float t = std::min(1.0f, std::max(0.0f, (px * ex + py * ey) / (ex * ex + ey * ey)));
+		float dx = px - ex * t, dy = py - ey * t;
+		nearest                           = std::min(nearest, dx * dx + dy * dy);
+		if (ex * py - ey * px < 0) inside = false;
+	}
+	return inside ? -sqrtf(nearest) : sqrtf(nearest);
+}
+
+bool PinGlyphAtlas::Bake(ImFontAtlas *atlas) {
+	unsigned char *pixels;
+	int width, height;
+	atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
+	if (width < NUM_PIN_GLYPHS * cell) return false;
+
+	// Fonts are packed from the top, rows left empty at the bottom are free
+	int used = height;
+	while (used > 0) {
+		const unsigned char *row = pixels + (used - 1) * width;
+		if (std::any_of(row, row + width, [](unsigned char a) { return a != 0; })) break;
+		used--;
+	}
+	int top = used + 1;
+
+	if (top + 2 * cell > height) {
+		// Grown by powers of two, some renderers want them; what is there already moves up in V
+		int grown_height = height;
+		while (top + 2 * cell > grown_height) grown_height *= 2;
+
+		unsigned char *grown = (unsigned char *)ImGui::MemAlloc(width * grown_height);
+		memcpy(grown, pixels, width * height);
+		memset(grown + width * height, 0, width * (grown_height - height));
+		ImGui::MemFree(atlas->TexPixelsAlpha8);
+		atlas->TexPixelsAlpha8 = grown;
+		atlas->TexHeight       = grown_height;
+
+		float v = (float)height / grown_height;
+		for (ImFont *font : atlas->Fonts) {
+			for (auto &glyph : font->Glyphs) {
+				glyph.V0 *= v;
+				glyph.V1 *= v;
+			}
+		}
+		atlas->TexUvWhitePixel.y *= v;
+
+		pixels = grown;
+		height = grown_height;
+	}
+
+	// Built again from the alpha texture when the renderer asks for it
+	if (atlas->TexPixelsRGBA32) {
+		ImGui::MemFree(atlas->TexPixelsRGBA32);
+		atlas->TexPixelsRGBA32 = NULL;
+	}
+
+	// Both bands hold the same field, texels sampled at their centres
+	for (int band = 0; band < 2; band++) {
+		int y0 = top + band * cell;
+		for (int g = 0; g < NUM_PIN_GLYPHS; g++) {
+			int x0 = g * cell;
+			for (int y = 0; y < cell; y++) {
+				for (int x = 0; x < cell; x++) {
+					float cx = x + 0.5f - cell / 2.0f, cy = y + 0.5f - cell / 2.0f;
+					float d                           = ShapeDistance((PinGlyph)g, cx, cy, shape_radius);
+					float value                       = std::min(1.0f, std::max(0.0f, 0.5f - d / (2 * spread)));
+					pixels[(y0 + y) * width + x0 + x] = (unsigned char)lroundf(value * 255);
+				}
+			}
+			m_uv[band][g][0] = ImVec2((float)x0 / width, (float)y0 / height);
+			m_uv[band][g][1] = ImVec2((float)(x0 + cell) / width, (float)(y0 + cell) / height);
+		}
+	}
+
+	filled_top   = (float)top / height;
+	outlined_top = (float)(top + cell) / height;
+	baked        = true;
+	return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "imgui/imgui.h"
+#include <stdint.h>
+
+enum PinGlyph { kPinGlyphCircle = 0, kPinGlyphSquare, kPinGlyphDiamond, kPinGlyphHex, NUM_PIN_GLYPHS };
+
+/*
+ * Pin shapes baked into the ImGui font texture as signed distance fields, so
+ * a pin is one textured quad of 4 vertices rather than a tessellated circle,
+ * and its edge stays sharp however far in the view is zoomed.
+ *
+ * Each shape is there twice, in a band of filled glyphs and a band of
+ * outlined ones holding the same field: the renderer's fragment shader turns
+ * the field into an edge a pixel wide, filling inside it in the first band and
+ * leaving it a line in the second. Renderers without such a shader get no
+ * glyphs, and the board is drawn as before.
+ */
+class PinGlyphAtlas {
+  public:
+	/*
+	 * Adds the glyphs to the atlas, below what is packed there, growing the
+	 * texture if needed. Call once the fonts are added and before the renderer
+	 * creates its font texture; false if the atlas is too narrow.
+	 */
+	bool Bake(ImFontAtlas *atlas);
+
+	// Draws glyph over a square of half side radius at centre
+	void Add(ImDrawList *draw, ImVec2 centre, float radius, PinGlyph glyph, bool filled, uint32_t col) const {
+		float e = radius * extent;
+		draw->PrimReserve(6, 4);
+		draw->PrimRectUV(ImVec2(centre.x - e, centre.y - e),
+		                 ImVec2(centre.x + e, centre.y + e),
+		                 m_uv[filled ? 0 : 1][glyph][0],
+		                 m_uv[filled ? 0 : 1][glyph][1],
+		                 col);
+	}
+
+	bool baked = false;
+
+	// Texture V where the filled, then outlined glyphs start, for the renderer's shader
+	float filled_top   = 2.0f;
+	float outlined_top = 2.0f;
+
+	static const int cell         = 40; // Texels a side
+	static const int shape_radius = 16; // Of the shapes in a cell, leaving room for the field around them
+	static const int spread       = 4;  // Texels the field runs from 0 to 1 over, centred on the edge
+	static constexpr float extent = (float)cell / 2 / shape_radius;
+
+  private:
+	ImVec2 m_uv[2][NUM_PIN_GLYPHS][2]; // Filled or outlined, glyph, corners
+};
@@ -0,0 +1,70 @@
+#include "StreamBuffer.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include <glad/glad.h>
+
+void StreamBuffer::Create(unsigned int target, bool map) {
+	m_target     = target;
+	m_map        = map;
+	m_capacity   = 0;
+	m_head       = 0;
+	m_high_water = 0;
+	glGenBuffers(1, &handle);
+}
+
+void StreamBuffer::Destroy() {
+	if (handle) glDeleteBuffers(1, &handle);
+	handle       = 0;
+	m_capacity   = 0;
+	m_head       = 0;
+	m_high_water = 0;
+}
+
+void StreamBuffer::BeginFrame(size_t size, StreamStats &stats) {
+	m_stats      = &stats;
+	m_high_water = std::max(size, m_high_water - m_high_water / 32);
+
+	glBindBuffer(m_target, handle);
+
+	size_t wanted = std::max(min_capacity, m_high_water * frames);
+	if (size > m_capacity || m_capacity > wanted * 4) {
+		// Too small for this frame, or far larger than frames have needed for a while
+		m_capacity = wanted;
+		m_head     = 0;
+		glBufferData(m_target, m_capacity, NULL, GL_STREAM_DRAW);
+		stats.reallocations++;
+	} else if (m_head + size > m_capacity) {
+		m_head = 0;
+		glBufferData(m_target, m_capacity, NULL, GL_STREAM_DRAW);
+		stats.orphans++;
+	}
+	stats.capacity += m_capacity;
+
+	// Nothing drawn since the last orphaning used this part, so there is nothing to wait for
+	m_frame_start = m_head;
+	m_mapped      = nullptr;
+	if (m_map && size > 0)
+		m_mapped = (uint8_t *)glMapBufferRange(
+		    m_target, m_head, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+size_t StreamBuffer::Write(const void *data, size_t size) {
+	size_t offset = m_head;
+
+	if (m_mapped)
+		memcpy(m_mapped + (offset - m_frame_start), data, size);
+	else if (size > 0)
+		glBufferSubData(m_target, offset, size, data); // Also when mapping failed
+
+	m_head += Aligned(size);
+	m_stats->bytes_uploaded += size;
+	return offset;
+}
+
+void StreamBuffer::EndFrame() {
+	// Must be done before drawing from it
+	if (m_mapped) glUnmapBuffer(m_target);
+	m_mapped = nullptr;
+}
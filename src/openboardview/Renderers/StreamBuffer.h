@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// What streaming draw data cost on the last frame, summed over a renderer's buffers
+struct StreamStats {
+	size_t bytes_uploaded  = 0;
+	uint32_t reallocations = 0; // Buffers given storage of a new size
+	uint32_t orphans       = 0; // Buffers given fresh storage of the same size as they filled up
+	size_t capacity        = 0; // Of all buffers, in bytes
+
+	void Clear() {
+		*this = StreamStats();
+	}
+};
+
+/*
+ * GL buffer object draw data is streamed through, frame after frame, in
+ * place of a glBufferData() per draw list. A frame's data goes in after the
+ * last frame's so nothing the GPU may still be reading is written over; once
+ * the buffer is full its storage is orphaned and writing starts again at the
+ * front, the driver keeping the old storage until drawing from it is done.
+ *
+ * Capacity follows the largest frame seen lately: it grows to a few such
+ * frames when one does not fit, and shrinks back once frames stay much
+ * smaller, e.g. after closing a large board.
+ *
+ * With map, writes go through an unsynchronized mapping of the frame's part
+ * of the buffer (GL 3); otherwise through glBufferSubData() (GLES 2).
+ */
+class StreamBuffer {
+  public:
+	// target is GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER
+	void Create(unsigned int target, bool map);
+	void Destroy();
+
+	// Binds the buffer and makes room for size bytes of writes this frame, aligned as Write() does
+	void BeginFrame(size_t size, StreamStats &stats);
+	// Copies data in after this frame's other writes, returning its offset in the buffer
+	size_t Write(const void *data, size_t size);
+	void EndFrame();
+
+	// Room a write of size bytes takes
+	static size_t Aligned(size_t size) {
+		return (size + alignment - 1) & ~(alignment - 1);
+	}
+
+	unsigned int handle = 0;
+
+  private:
+	static const size_t alignment    = 4; // For any index or attribute type
+	static const size_t min_capacity = 64 * 1024;
+	static const size_t frames       = 3; // Capacity, in frames of the high water mark
+
+	unsigned int m_target = 0;
+	bool m_map            = false;
+	size_t m_capacity     = 0;
+	size_t m_head         = 0; // Where this frame's writes go
+	size_t m_high_water   = 0; // Largest frame lately, falling slowly
+	uint8_t *m_mapped     = nullptr;
+	size_t m_frame_start  = 0;
+	StreamStats *m_stats  = nullptr;
+};
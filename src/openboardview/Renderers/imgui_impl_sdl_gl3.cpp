@@ -14,6 +14,9 @@
 #include "imgui.h"
 #include "imgui_impl_sdl_gl3.h"
 
+#include "BoardMesh.h"
+#include "StreamBuffer.h"
+
 // SDL, glad
 #ifdef _MSC_VER
 #include <SDL.h>
@@ -30,9 +33,46 @@ static bool g_MousePressed[3] = {false, false, false};
 static float g_MouseWheel     = 0.0f;
 static GLuint g_FontTexture   = 0;
 static int g_ShaderHandle = 0, g_VertHandle = 0, g_FragHandle = 0;
-static int g_AttribLocationTex = 0, g_AttribLocationProjMtx = 0;
+static int g_AttribLocationTex = 0, g_AttribLocationProjMtx = 0, g_AttribLocationDistanceFields = 0;
 static int g_AttribLocationPosition = 0, g_AttribLocationUV = 0, g_AttribLocationColor = 0;
-static unsigned int g_VboHandle = 0, g_VaoHandle = 0, g_ElementsHandle = 0;
+static unsigned int g_VaoHandle = 0;
+
+// Font texture V of the pin glyphs, none until ImGui_ImplSdlGL3_SetDistanceFields()
+static float g_DistanceFields[2] = {2.0f, 2.0f};
+
+// Draw lists are streamed through these, see StreamBuffer.h
+static StreamBuffer g_VboStream, g_ElementsStream;
+static StreamStats g_StreamStats;
+static ImVector<size_t> g_ListOffsets; // Of each list's vertices and indices in the streams
+
+// Board geometry drawn from its own buffer, see BoardMesh.h
+static int g_MeshShaderHandle = 0, g_MeshVertHandle = 0, g_MeshFragHandle = 0;
+static int g_MeshLocationOrigin = 0, g_MeshLocationAxisX = 0, g_MeshLocationAxisY = 0;
+static int g_MeshLocationDisplay = 0, g_MeshLocationScale = 0, g_MeshLocationMinSize = 0;
+static int g_MeshLocationAndMask = 0, g_MeshLocationOrMask = 0;
+static int g_MeshLocationLineWidth = 0, g_MeshLocationPad = 0, g_MeshLocationStripes = 0;
+
+// Buffers of the meshes drawn lately, the board's and its overlay's, the least recently used one taking a mesh not in either
+struct MeshBuffer {
+	unsigned int vbo    = 0;
+	unsigned int vao    = 0;
+	uint32_t generation = 0; // Of the vertices in vbo
+	uint32_t used       = 0; // Draw it was last used by
+};
+static MeshBuffer g_MeshBuffers[2];
+static uint32_t g_MeshDraws = 0;
+
+// Points ImGui's attributes at the vertices from offset on in g_VboStream, bound to GL_ARRAY_BUFFER
+static void ImGui_ImplSdlGL3_SetupAttributes(size_t offset) {
+#define OFFSETOF(TYPE, ELEMENT) ((size_t) & (((TYPE *)0)->ELEMENT))
+	glVertexAttribPointer(
+	    g_AttribLocationPosition, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid *)(offset + OFFSETOF(ImDrawVert, pos)));
+	glVertexAttribPointer(
+	    g_AttribLocationUV, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid *)(offset + OFFSETOF(ImDrawVert, uv)));
+	glVertexAttribPointer(
+	    g_AttribLocationColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid *)(offset + OFFSETOF(ImDrawVert, col)));
+#undef OFFSETOF
+}
 
 // This is the main rendering function that you have to implement and provide to
 // ImGui (via setting up 'RenderDrawListsFn' in the ImGuiIO structure)
@@ -96,24 +136,36 @@ void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData *draw_data) {
 	};
 	glUseProgram(g_ShaderHandle);
 	glUniform1i(g_AttribLocationTex, 0);
+	glUniform2f(g_AttribLocationDistanceFields, g_DistanceFields[0], g_DistanceFields[1]);
 	glUniformMatrix4fv(g_AttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0]);
 	glBindVertexArray(g_VaoHandle);
 
+	// All lists go into the streams before drawing, so each is mapped once a frame
+	size_t vtx_size = 0, idx_size = 0;
 	for (int n = 0; n < draw_data->CmdListsCount; n++) {
-		const ImDrawList *cmd_list         = draw_data->CmdLists[n];
-		const ImDrawIdx *idx_buffer_offset = 0;
+		vtx_size += StreamBuffer::Aligned(draw_data->CmdLists[n]->VtxBuffer.size() * sizeof(ImDrawVert));
+		idx_size += StreamBuffer::Aligned(draw_data->CmdLists[n]->IdxBuffer.size() * sizeof(ImDrawIdx));
+	}
 
-		glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
-		glBufferData(GL_ARRAY_BUFFER,
-		             (GLsizeiptr)cmd_list->VtxBuffer.size() * sizeof(ImDrawVert),
-		             (GLvoid *)&cmd_list->VtxBuffer.front(),
-		             GL_STREAM_DRAW);
+	g_StreamStats.Clear();
+	g_VboStream.BeginFrame(vtx_size, g_StreamStats);
+	g_ElementsStream.BeginFrame(idx_size, g_StreamStats);
+	g_ListOffsets.resize(draw_data->CmdListsCount * 2);
+	for (int n = 0; n < draw_data->CmdListsCount; n++) {
+		const ImDrawList *cmd_list = draw_data->CmdLists[n];
+		size_t vtx_bytes           = cmd_list->VtxBuffer.size() * sizeof(ImDrawVert);
+		size_t idx_bytes           = cmd_list->IdxBuffer.size() * sizeof(ImDrawIdx);
+		g_ListOffsets[n * 2]       = g_VboStream.Write(cmd_list->VtxBuffer.Data, vtx_bytes);
+		g_ListOffsets[n * 2 + 1]   = g_ElementsStream.Write(cmd_list->IdxBuffer.Data, idx_bytes);
+	}
+	g_VboStream.EndFrame();
+	g_ElementsStream.EndFrame();
+
+	for (int n = 0; n < draw_data->CmdListsCount; n++) {
+		const ImDrawList *cmd_list         = draw_data->CmdLists[n];
+		const ImDrawIdx *idx_buffer_offset = (const ImDrawIdx *)g_ListOffsets[n * 2 + 1];
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ElementsHandle);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-		             (GLsizeiptr)cmd_list->IdxBuffer.size() * sizeof(ImDrawIdx),
-		             (GLvoid *)&cmd_list->IdxBuffer.front(),
-		             GL_STREAM_DRAW);
+		ImGui_ImplSdlGL3_SetupAttributes(g_ListOffsets[n * 2]);
 
 		for (const ImDrawCmd *pcmd = cmd_list->CmdBuffer.begin(); pcmd != cmd_list->CmdBuffer.end(); pcmd++) {
 			if (pcmd->UserCallback) {
@@ -161,6 +213,71 @@ void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData *draw_data) {
 	glViewport(last_viewport[0], last_viewport[1], (GLsizei)last_viewport[2], (GLsizei)last_viewport[3]);
 }
 
+// Draws its BoardMeshRange in place of the command, then binds ImGui's program and buffers again
+void ImGui_ImplSdlGL3_RenderBoardMesh(const ImDrawList *, const ImDrawCmd *cmd) {
+	const BoardMeshRange *range = (const BoardMeshRange *)cmd->UserCallbackData;
+	const BoardMesh *mesh       = range->mesh;
+	if (!mesh || range->count == 0 || !g_MeshShaderHandle) return;
+
+	ImGuiIO &io   = ImGui::GetIO();
+	int fb_height = (int)(io.DisplaySize.y * io.DisplayFramebufferScale.y);
+
+	// The vertices only go up when the board view built them again
+	MeshBuffer *buffer = nullptr;
+	for (auto &b : g_MeshBuffers)
+		if (b.generation == mesh->generation) buffer = &b;
+	if (!buffer) {
+		buffer = &g_MeshBuffers[0];
+		for (auto &b : g_MeshBuffers)
+			if (b.used < buffer->used) buffer = &b;
+	}
+	glBindVertexArray(buffer->vao);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer->vbo);
+	if (buffer->generation != mesh->generation) {
+		glBufferData(GL_ARRAY_BUFFER,
+		             (GLsizeiptr)mesh->vertices.size() * sizeof(BoardVertex),
+		             (GLvoid *)mesh->vertices.data(),
+		             GL_STATIC_DRAW);
+		buffer->generation = mesh->generation;
+	}
+	buffer->used = ++g_MeshDraws;
+
+	glUseProgram(g_MeshShaderHandle);
+	glUniform2f(g_MeshLocationOrigin, mesh->origin.x, mesh->origin.y);
+	glUniform2f(g_MeshLocationAxisX, mesh->axis_x.x, mesh->axis_x.y);
+	glUniform2f(g_MeshLocationAxisY, mesh->axis_y.x, mesh->axis_y.y);
+	glUniform2f(g_MeshLocationDisplay, io.DisplaySize.x, io.DisplaySize.y);
+	glUniform1f(g_MeshLocationScale, mesh->scale);
+	glUniform1f(g_MeshLocationMinSize, mesh->min_size);
+	glUniform4fv(g_MeshLocationAndMask, BoardVertex::kMaskCount, &mesh->and_masks[0][0]);
+	glUniform4fv(g_MeshLocationOrMask, BoardVertex::kMaskCount, &mesh->or_masks[0][0]);
+	glUniform1f(g_MeshLocationLineWidth, range->line_width);
+	glUniform1f(g_MeshLocationPad, range->pad);
+	glUniform1f(g_MeshLocationStripes, range->stripes);
+	glScissor((int)cmd->ClipRect.x,
+	          (int)(fb_height - cmd->ClipRect.w),
+	          (int)(cmd->ClipRect.z - cmd->ClipRect.x),
+	          (int)(cmd->ClipRect.w - cmd->ClipRect.y));
+	glDrawArrays(GL_TRIANGLES, range->first, range->count);
+
+	glUseProgram(g_ShaderHandle);
+	glBindVertexArray(g_VaoHandle);
+	glBindBuffer(GL_ARRAY_BUFFER, g_VboStream.handle);
+}
+
+bool ImGui_ImplSdlGL3_HasBoardMesh() {
+	return g_MeshShaderHandle != 0;
+}
+
+void ImGui_ImplSdlGL3_SetDistanceFields(float filled_top, float outlined_top) {
+	g_DistanceFields[0] = filled_top;
+	g_DistanceFields[1] = outlined_top;
+}
+
+const StreamStats &ImGui_ImplSdlGL3_GetStreamStats() {
+	return g_StreamStats;
+}
+
 static const char *ImGui_ImplSdlGL3_GetClipboardText() {
 	return SDL_GetClipboardText();
 }
@@ -256,12 +373,20 @@ bool ImGui_ImplSdlGL3_CreateDeviceObjects() {
 	const GLchar *fragment_shader =
 	    "#version 330\n"
 	    "uniform sampler2D Texture;\n"
+	    "uniform vec2 DistanceFields;\n"
 	    "in vec2 Frag_UV;\n"
 	    "in vec4 Frag_Color;\n"
 	    "out vec4 Out_Color;\n"
 	    "void main()\n"
 	    "{\n"
-	    "	Out_Color = Frag_Color * texture( Texture, Frag_UV.st);\n"
+	    "	vec4 texel = texture( Texture, Frag_UV.st);\n"
+	    // Pin glyphs, a pixel wide edge filled in or not, see PinGlyphs.h
+	    "	float edge = max(fwidth(texel.a), 0.0001);\n"
+	    "	if (Frag_UV.t >= DistanceFields.y)\n"
+	    "		texel.a = clamp(1.0 - abs(texel.a - 0.5) / edge, 0.0, 1.0);\n"
+	    "	else if (Frag_UV.t >= DistanceFields.x)\n"
+	    "		texel.a = clamp((texel.a - 0.5) / edge + 0.5, 0.0, 1.0);\n"
+	    "	Out_Color = Frag_Color * texel;\n"
 	    "}\n";
 
 	g_ShaderHandle = glCreateProgram();
@@ -275,28 +400,96 @@ bool ImGui_ImplSdlGL3_CreateDeviceObjects() {
 	glAttachShader(g_ShaderHandle, g_FragHandle);
 	glLinkProgram(g_ShaderHandle);
 
-	g_AttribLocationTex      = glGetUniformLocation(g_ShaderHandle, "Texture");
-	g_AttribLocationProjMtx  = glGetUniformLocation(g_ShaderHandle, "ProjMtx");
-	g_AttribLocationPosition = glGetAttribLocation(g_ShaderHandle, "Position");
-	g_AttribLocationUV       = glGetAttribLocation(g_ShaderHandle, "UV");
-	g_AttribLocationColor    = glGetAttribLocation(g_ShaderHandle, "Color");
+	g_AttribLocationTex            = glGetUniformLocation(g_ShaderHandle, "Texture");
+	g_AttribLocationDistanceFields = glGetUniformLocation(g_ShaderHandle, "DistanceFields");
+	g_AttribLocationProjMtx        = glGetUniformLocation(g_ShaderHandle, "ProjMtx");
+	g_AttribLocationPosition       = glGetAttribLocation(g_ShaderHandle, "Position");
+	g_AttribLocationUV             = glGetAttribLocation(g_ShaderHandle, "UV");
+	g_AttribLocationColor          = glGetAttribLocation(g_ShaderHandle, "Color");
 
-	glGenBuffers(1, &g_VboHandle);
-	glGenBuffers(1, &g_ElementsHandle);
+	g_VboStream.Create(GL_ARRAY_BUFFER, true);
+	g_ElementsStream.Create(GL_ELEMENT_ARRAY_BUFFER, true);
 
 	glGenVertexArrays(1, &g_VaoHandle);
 	glBindVertexArray(g_VaoHandle);
-	glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
+	glBindBuffer(GL_ARRAY_BUFFER, g_VboStream.handle);
 	glEnableVertexAttribArray(g_AttribLocationPosition);
 	glEnableVertexAttribArray(g_AttribLocationUV);
 	glEnableVertexAttribArray(g_AttribLocationColor);
+	ImGui_ImplSdlGL3_SetupAttributes(0);
+
+	// The board mesh shaders are written for GLSL ES 1.00
+	const GLchar *mesh_vertex_shader[] = {"#version 330\n"
+	                                      "#define attribute in\n"
+	                                      "#define varying out\n",
+	                                      BoardMesh::vertex_shader};
+	const GLchar *mesh_fragment_shader[] = {"#version 330\n"
+	                                        "#define varying in\n"
+	                                        "#define FRAG_COLOR Out_Color\n"
+	                                        "out vec4 Out_Color;\n",
+	                                        BoardMesh::fragment_shader};
+
+	g_MeshShaderHandle = glCreateProgram();
+	g_MeshVertHandle   = glCreateShader(GL_VERTEX_SHADER);
+	g_MeshFragHandle   = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(g_MeshVertHandle, 2, mesh_vertex_shader, 0);
+	glShaderSource(g_MeshFragHandle, 2, mesh_fragment_shader, 0);
+	glCompileShader(g_MeshVertHandle);
+	glCompileShader(g_MeshFragHandle);
+	glAttachShader(g_MeshShaderHandle, g_MeshVertHandle);
+	glAttachShader(g_MeshShaderHandle, g_MeshFragHandle);
+	glLinkProgram(g_MeshShaderHandle);
+
+	GLint linked;
+	glGetProgramiv(g_MeshShaderHandle, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		// The board view then draws through ImDrawList, see ImGui_ImplSdlGL3_HasBoardMesh()
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Board mesh shaders failed to build");
+		glDeleteProgram(g_MeshShaderHandle);
+		g_MeshShaderHandle = 0;
+	} else {
+		g_MeshLocationOrigin    = glGetUniformLocation(g_MeshShaderHandle, "Origin");
+		g_MeshLocationAxisX     = glGetUniformLocation(g_MeshShaderHandle, "AxisX");
+		g_MeshLocationAxisY     = glGetUniformLocation(g_MeshShaderHandle, "AxisY");
+		g_MeshLocationDisplay   = glGetUniformLocation(g_MeshShaderHandle, "Display");
+		g_MeshLocationScale     = glGetUniformLocation(g_MeshShaderHandle, "Scale");
+		g_MeshLocationMinSize   = glGetUniformLocation(g_MeshShaderHandle, "MinSize");
+		g_MeshLocationAndMask   = glGetUniformLocation(g_MeshShaderHandle, "AndMask");
+		g_MeshLocationOrMask    = glGetUniformLocation(g_MeshShaderHandle, "OrMask");
+		g_MeshLocationLineWidth = glGetUniformLocation(g_MeshShaderHandle, "LineWidth");
+		g_MeshLocationPad       = glGetUniformLocation(g_MeshShaderHandle, "Pad");
+		g_MeshLocationStripes   = glGetUniformLocation(g_MeshShaderHandle, "Stripes");
+
+		GLint position  = glGetAttribLocation(g_MeshShaderHandle, "Position");
+		GLint size      = glGetAttribLocation(g_MeshShaderHandle, "Size");
+		GLint direction = glGetAttribLocation(g_MeshShaderHandle, "Direction");
+		GLint shape     = glGetAttribLocation(g_MeshShaderHandle, "Shape");
+		GLint color     = glGetAttribLocation(g_MeshShaderHandle, "Color");
+		GLint mask      = glGetAttribLocation(g_MeshShaderHandle, "Mask");
+
+		for (auto &b : g_MeshBuffers) {
+			glGenBuffers(1, &b.vbo);
+			glGenVertexArrays(1, &b.vao);
+			glBindVertexArray(b.vao);
+			glBindBuffer(GL_ARRAY_BUFFER, b.vbo);
+			glEnableVertexAttribArray(position);
+			glEnableVertexAttribArray(size);
+			glEnableVertexAttribArray(direction);
+			glEnableVertexAttribArray(shape);
+			glEnableVertexAttribArray(color);
+			glEnableVertexAttribArray(mask);
 
 #define OFFSETOF(TYPE, ELEMENT) ((size_t) & (((TYPE *)0)->ELEMENT))
-	glVertexAttribPointer(g_AttribLocationPosition, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid *)OFFSETOF(ImDrawVert, pos));
-	glVertexAttribPointer(g_AttribLocationUV, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid *)OFFSETOF(ImDrawVert, uv));
-	glVertexAttribPointer(
-	    g_AttribLocationColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid *)OFFSETOF(ImDrawVert, col));
+			const GLsizei stride = sizeof(BoardVertex);
+			glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid *)OFFSETOF(BoardVertex, x));
+			glVertexAttribPointer(size, 1, GL_FLOAT, GL_FALSE, stride, (GLvoid *)OFFSETOF(BoardVertex, size));
+			glVertexAttribPointer(direction, 2, GL_BYTE, GL_TRUE, stride, (GLvoid *)OFFSETOF(BoardVertex, dx));
+			glVertexAttribPointer(shape, 1, GL_UNSIGNED_BYTE, GL_FALSE, stride, (GLvoid *)OFFSETOF(BoardVertex, shape));
+			glVertexAttribPointer(color, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (GLvoid *)OFFSETOF(BoardVertex, col));
+			glVertexAttribPointer(mask, 1, GL_UNSIGNED_BYTE, GL_FALSE, stride, (GLvoid *)OFFSETOF(BoardVertex, mask));
 #undef OFFSETOF
+		}
+	}
 
 	ImGui_ImplSdlGL3_CreateFontsTexture();
 
@@ -310,9 +503,9 @@ bool ImGui_ImplSdlGL3_CreateDeviceObjects() {
 
 void ImGui_ImplSdlGL3_InvalidateDeviceObjects() {
 	if (g_VaoHandle) glDeleteVertexArrays(1, &g_VaoHandle);
-	if (g_VboHandle) glDeleteBuffers(1, &g_VboHandle);
-	if (g_ElementsHandle) glDeleteBuffers(1, &g_ElementsHandle);
-	g_VaoHandle = g_VboHandle = g_ElementsHandle = 0;
+	g_VboStream.Destroy();
+	g_ElementsStream.Destroy();
+	g_VaoHandle = 0;
 
 	glDetachShader(g_ShaderHandle, g_VertHandle);
 	glDeleteShader(g_VertHandle);
@@ -325,6 +518,17 @@ void ImGui_ImplSdlGL3_InvalidateDeviceObjects() {
 	glDeleteProgram(g_ShaderHandle);
 	g_ShaderHandle = 0;
 
+	for (auto &b : g_MeshBuffers) {
+		if (b.vao) glDeleteVertexArrays(1, &b.vao);
+		if (b.vbo) glDeleteBuffers(1, &b.vbo);
+		b = MeshBuffer();
+	}
+
+	glDeleteShader(g_MeshVertHandle);
+	glDeleteShader(g_MeshFragHandle);
+	glDeleteProgram(g_MeshShaderHandle);
+	g_MeshShaderHandle = g_MeshVertHandle = g_MeshFragHandle = 0;
+
 	if (g_FontTexture) {
 		glDeleteTextures(1, &g_FontTexture);
 		ImGui::GetIO().Fonts->TexID = 0;
@@ -13,12 +13,25 @@
 
 struct SDL_Window;
 typedef union SDL_Event SDL_Event;
+struct StreamStats;
 
 IMGUI_API bool ImGui_ImplSdlGL3_Init(SDL_Window *window);
 IMGUI_API void ImGui_ImplSdlGL3_Shutdown();
 IMGUI_API void ImGui_ImplSdlGL3_NewFrame(SDL_Window *window);
 IMGUI_API bool ImGui_ImplSdlGL3_ProcessEvent(SDL_Event *event);
 
+// ImDrawCallback drawing a BoardMeshRange, see BoardMesh.h
+IMGUI_API void ImGui_ImplSdlGL3_RenderBoardMesh(const ImDrawList *parent_list, const ImDrawCmd *cmd);
+
+// Whether its program built, known once the device objects are created; RenderBoardMesh draws nothing without it
+IMGUI_API bool ImGui_ImplSdlGL3_HasBoardMesh();
+
+// What streaming the last frame's draw lists cost
+IMGUI_API const StreamStats &ImGui_ImplSdlGL3_GetStreamStats();
+
+// Font texture V from which pin glyphs are filled, then outlined distance fields, see PinGlyphs.h
+IMGUI_API void ImGui_ImplSdlGL3_SetDistanceFields(float filled_top, float outlined_top);
+
 // Use if you want to reset your rendering device without losing ImGui state.
 IMGUI_API void ImGui_ImplSdlGL3_InvalidateDeviceObjects();
 IMGUI_API bool ImGui_ImplSdlGL3_CreateDeviceObjects();
@@ -8,6 +8,9 @@
 #include "imgui/imgui.h"
 #include "imgui_impl_sdl_gles2.h"
 
+#include "BoardMesh.h"
+#include "StreamBuffer.h"
+
 // SDL, glad
 #ifdef _MSC_VER
 #include <SDL.h>
@@ -23,11 +26,87 @@ static bool g_MousePressed[3] = {false, false, false};
 static float g_MouseWheel     = 0.0f;
 static GLuint g_FontTexture   = 0;
 static int g_ShaderHandle = 0, g_VertHandle = 0, g_FragHandle = 0;
-static int g_AttribLocationTex = 0, g_AttribLocationProjMtx = 0;
+static int g_AttribLocationTex = 0, g_AttribLocationProjMtx = 0, g_AttribLocationDistanceFields = 0;
 static int g_AttribLocationPosition = 0, g_AttribLocationUV = 0, g_AttribLocationColor = 0;
-static unsigned int g_VboHandle = 0, g_ElementsHandle = 0;
 static bool g_DrawElemWorkaround = false;
 
+// Font texture V of the pin glyphs, none until ImGui_ImplSdlGLES2_SetDistanceFields()
+static float g_DistanceFields[2] = {2.0f, 2.0f};
+
+// Draw lists are streamed through these, see StreamBuffer.h
+static StreamBuffer g_VboStream, g_ElementsStream;
+static StreamStats g_StreamStats;
+static ImVector<size_t> g_ListOffsets;   // Of each list's vertices and indices in the streams
+static ImVector<ImDrawVert> g_Unindexed; // Vertices of a list drawn without indices
+static size_t g_VtxOffset = 0;           // Of the list being drawn
+
+// Board geometry drawn from its own buffer, see BoardMesh.h
+static int g_MeshShaderHandle = 0, g_MeshVertHandle = 0, g_MeshFragHandle = 0;
+static int g_MeshLocationOrigin = 0, g_MeshLocationAxisX = 0, g_MeshLocationAxisY = 0;
+static int g_MeshLocationDisplay = 0, g_MeshLocationScale = 0, g_MeshLocationMinSize = 0;
+static int g_MeshLocationAndMask = 0, g_MeshLocationOrMask = 0;
+static int g_MeshLocationLineWidth = 0, g_MeshLocationPad = 0, g_MeshLocationStripes = 0;
+static int g_MeshLocationPosition = 0, g_MeshLocationSize = 0, g_MeshLocationDirection = 0;
+static int g_MeshLocationShape = 0, g_MeshLocationColor = 0, g_MeshLocationMask = 0;
+
+// Buffers of the meshes drawn lately, the board's and its overlay's, the least recently used one taking a mesh not in either
+struct MeshBuffer {
+	unsigned int vbo    = 0;
+	uint32_t generation = 0; // Of the vertices in vbo
+	uint32_t used       = 0; // Draw it was last used by
+};
+static MeshBuffer g_MeshBuffers[2];
+static uint32_t g_MeshDraws = 0;
+
+#define OFFSETOF(TYPE, ELEMENT) ((size_t) & (((TYPE *)0)->ELEMENT))
+
+// Points ImGui's attributes at the vertices from g_VtxOffset on, there being no vertex array objects to keep them in
+static void ImGui_ImplSdlGLES2_SetupAttributes() {
+	glBindBuffer(GL_ARRAY_BUFFER, g_VboStream.handle);
+	glEnableVertexAttribArray(g_AttribLocationPosition);
+	glEnableVertexAttribArray(g_AttribLocationUV);
+	glEnableVertexAttribArray(g_AttribLocationColor);
+
+	glVertexAttribPointer(
+	    g_AttribLocationPosition, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid *)(g_VtxOffset + OFFSETOF(ImDrawVert, pos)));
+	glVertexAttribPointer(
+	    g_AttribLocationUV, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid *)(g_VtxOffset + OFFSETOF(ImDrawVert, uv)));
+	glVertexAttribPointer(g_AttribLocationColor,
+	                      4,
+	                      GL_UNSIGNED_BYTE,
+	                      GL_TRUE,
+	                      sizeof(ImDrawVert),
+	                      (GLvoid *)(g_VtxOffset + OFFSETOF(ImDrawVert, col)));
+}
+
+static void ImGui_ImplSdlGLES2_SetupMeshAttributes(const MeshBuffer *buffer) {
+	if (!buffer) {
+		glDisableVertexAttribArray(g_MeshLocationPosition);
+		glDisableVertexAttribArray(g_MeshLocationSize);
+		glDisableVertexAttribArray(g_MeshLocationDirection);
+		glDisableVertexAttribArray(g_MeshLocationShape);
+		glDisableVertexAttribArray(g_MeshLocationColor);
+		glDisableVertexAttribArray(g_MeshLocationMask);
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer->vbo);
+	glEnableVertexAttribArray(g_MeshLocationPosition);
+	glEnableVertexAttribArray(g_MeshLocationSize);
+	glEnableVertexAttribArray(g_MeshLocationDirection);
+	glEnableVertexAttribArray(g_MeshLocationShape);
+	glEnableVertexAttribArray(g_MeshLocationColor);
+	glEnableVertexAttribArray(g_MeshLocationMask);
+
+	const GLsizei stride = sizeof(BoardVertex);
+	glVertexAttribPointer(g_MeshLocationPosition, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid *)OFFSETOF(BoardVertex, x));
+	glVertexAttribPointer(g_MeshLocationSize, 1, GL_FLOAT, GL_FALSE, stride, (GLvoid *)OFFSETOF(BoardVertex, size));
+	glVertexAttribPointer(g_MeshLocationDirection, 2, GL_BYTE, GL_TRUE, stride, (GLvoid *)OFFSETOF(BoardVertex, dx));
+	glVertexAttribPointer(g_MeshLocationShape, 1, GL_UNSIGNED_BYTE, GL_FALSE, stride, (GLvoid *)OFFSETOF(BoardVertex, shape));
+	glVertexAttribPointer(g_MeshLocationColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (GLvoid *)OFFSETOF(BoardVertex, col));
+	glVertexAttribPointer(g_MeshLocationMask, 1, GL_UNSIGNED_BYTE, GL_FALSE, stride, (GLvoid *)OFFSETOF(BoardVertex, mask));
+}
+
 // This is the main rendering function that you have to implement and provide to ImGui (via setting up 'RenderDrawListsFn' in the
 // ImGuiIO structure)
 // If text or lines are blurry when integrating ImGui in your engine:
@@ -80,35 +159,54 @@ void ImGui_ImplSdlGLES2_RenderDrawLists(ImDrawData *draw_data) {
 
 	glUseProgram(g_ShaderHandle);
 	glUniform1i(g_AttribLocationTex, 0);
+	glUniform2f(g_AttribLocationDistanceFields, g_DistanceFields[0], g_DistanceFields[1]);
 	glUniformMatrix4fv(g_AttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0]);
 
+	// All lists go into the streams before drawing, each list's vertices one after the
+	// other for every index under the workaround
+	size_t vtx_size = 0, idx_size = 0;
 	for (int n = 0; n < draw_data->CmdListsCount; n++) {
-		const ImDrawList *cmd_list         = draw_data->CmdLists[n];
-		const ImDrawIdx *idx_buffer_offset = 0;
-		GLint vtx_buffer_offset            = 0;
+		const ImDrawList *cmd_list = draw_data->CmdLists[n];
+		if (g_DrawElemWorkaround) {
+			vtx_size += StreamBuffer::Aligned(cmd_list->IdxBuffer.size() * sizeof(ImDrawVert));
+		} else {
+			vtx_size += StreamBuffer::Aligned(cmd_list->VtxBuffer.size() * sizeof(ImDrawVert));
+			idx_size += StreamBuffer::Aligned(cmd_list->IdxBuffer.size() * sizeof(ImDrawIdx));
+		}
+	}
 
-		glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
+	g_StreamStats.Clear();
+	g_VboStream.BeginFrame(vtx_size, g_StreamStats);
+	if (!g_DrawElemWorkaround) g_ElementsStream.BeginFrame(idx_size, g_StreamStats);
+	g_ListOffsets.resize(draw_data->CmdListsCount * 2);
+	for (int n = 0; n < draw_data->CmdListsCount; n++) {
+		const ImDrawList *cmd_list = draw_data->CmdLists[n];
 
 		if (g_DrawElemWorkaround) {
-			ImVector<ImDrawVert> vertices;
-			vertices.reserve(cmd_list->IdxBuffer.size());
+			g_Unindexed.resize(0);
+			g_Unindexed.reserve(cmd_list->IdxBuffer.size());
 
-			for (auto &id : cmd_list->IdxBuffer) vertices.push_back(cmd_list->VtxBuffer[id]);
+			for (auto &id : cmd_list->IdxBuffer) g_Unindexed.push_back(cmd_list->VtxBuffer[id]);
 
-			glBufferData(
-			    GL_ARRAY_BUFFER, (GLsizeiptr)vertices.size() * sizeof(ImDrawVert), (GLvoid *)&vertices.front(), GL_STREAM_DRAW);
+			g_ListOffsets[n * 2]     = g_VboStream.Write(g_Unindexed.Data, g_Unindexed.size() * sizeof(ImDrawVert));
+			g_ListOffsets[n * 2 + 1] = 0;
 		} else {
-			glBufferData(GL_ARRAY_BUFFER,
-			             (GLsizeiptr)cmd_list->VtxBuffer.size() * sizeof(ImDrawVert),
-			             (GLvoid *)&cmd_list->VtxBuffer.front(),
-			             GL_STREAM_DRAW);
-
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ElementsHandle);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-			             (GLsizeiptr)cmd_list->IdxBuffer.size() * sizeof(ImDrawIdx),
-			             (GLvoid *)&cmd_list->IdxBuffer.front(),
-			             GL_STREAM_DRAW);
+			size_t vtx_bytes         = cmd_list->VtxBuffer.size() * sizeof(ImDrawVert);
+			size_t idx_bytes         = cmd_list->IdxBuffer.size() * sizeof(ImDrawIdx);
+			g_ListOffsets[n * 2]     = g_VboStream.Write(cmd_list->VtxBuffer.Data, vtx_bytes);
+			g_ListOffsets[n * 2 + 1] = g_ElementsStream.Write(cmd_list->IdxBuffer.Data, idx_bytes);
 		}
+	}
+	g_VboStream.EndFrame();
+	if (!g_DrawElemWorkaround) g_ElementsStream.EndFrame();
+
+	for (int n = 0; n < draw_data->CmdListsCount; n++) {
+		const ImDrawList *cmd_list         = draw_data->CmdLists[n];
+		const ImDrawIdx *idx_buffer_offset = (const ImDrawIdx *)g_ListOffsets[n * 2 + 1];
+		GLint vtx_buffer_offset            = 0;
+
+		g_VtxOffset = g_ListOffsets[n * 2];
+		ImGui_ImplSdlGLES2_SetupAttributes();
 
 		for (const ImDrawCmd *pcmd = cmd_list->CmdBuffer.begin(); pcmd != cmd_list->CmdBuffer.end(); pcmd++) {
 			if (pcmd->UserCallback) {
@@ -167,6 +265,74 @@ void ImGui_ImplSdlGLES2_RenderDrawLists(ImDrawData *draw_data) {
 	glViewport(last_viewport[0], last_viewport[1], (GLsizei)last_viewport[2], (GLsizei)last_viewport[3]);
 }
 
+// Draws its BoardMeshRange in place of the command, then sets ImGui's program and attributes up again
+void ImGui_ImplSdlGLES2_RenderBoardMesh(const ImDrawList *, const ImDrawCmd *cmd) {
+	const BoardMeshRange *range = (const BoardMeshRange *)cmd->UserCallbackData;
+	const BoardMesh *mesh       = range->mesh;
+	if (!mesh || range->count == 0 || !g_MeshShaderHandle) return;
+
+	ImGuiIO &io     = ImGui::GetIO();
+	float fb_height = io.DisplaySize.y * io.DisplayFramebufferScale.y;
+
+	glDisableVertexAttribArray(g_AttribLocationPosition);
+	glDisableVertexAttribArray(g_AttribLocationUV);
+	glDisableVertexAttribArray(g_AttribLocationColor);
+
+	// The vertices only go up when the board view built them again
+	MeshBuffer *buffer = nullptr;
+	for (auto &b : g_MeshBuffers)
+		if (b.generation == mesh->generation) buffer = &b;
+	if (!buffer) {
+		buffer = &g_MeshBuffers[0];
+		for (auto &b : g_MeshBuffers)
+			if (b.used < buffer->used) buffer = &b;
+	}
+	ImGui_ImplSdlGLES2_SetupMeshAttributes(buffer);
+	if (buffer->generation != mesh->generation) {
+		glBufferData(GL_ARRAY_BUFFER,
+		             (GLsizeiptr)mesh->vertices.size() * sizeof(BoardVertex),
+		             (GLvoid *)mesh->vertices.data(),
+		             GL_STATIC_DRAW);
+		buffer->generation = mesh->generation;
+	}
+	buffer->used = ++g_MeshDraws;
+
+	glUseProgram(g_MeshShaderHandle);
+	glUniform2f(g_MeshLocationOrigin, mesh->origin.x, mesh->origin.y);
+	glUniform2f(g_MeshLocationAxisX, mesh->axis_x.x, mesh->axis_x.y);
+	glUniform2f(g_MeshLocationAxisY, mesh->axis_y.x, mesh->axis_y.y);
+	glUniform2f(g_MeshLocationDisplay, io.DisplaySize.x, io.DisplaySize.y);
+	glUniform1f(g_MeshLocationScale, mesh->scale);
+	glUniform1f(g_MeshLocationMinSize, mesh->min_size);
+	glUniform4fv(g_MeshLocationAndMask, BoardVertex::kMaskCount, &mesh->and_masks[0][0]);
+	glUniform4fv(g_MeshLocationOrMask, BoardVertex::kMaskCount, &mesh->or_masks[0][0]);
+	glUniform1f(g_MeshLocationLineWidth, range->line_width);
+	glUniform1f(g_MeshLocationPad, range->pad);
+	glUniform1f(g_MeshLocationStripes, range->stripes);
+	glScissor((int)cmd->ClipRect.x,
+	          (int)(fb_height - cmd->ClipRect.w),
+	          (int)(cmd->ClipRect.z - cmd->ClipRect.x),
+	          (int)(cmd->ClipRect.w - cmd->ClipRect.y));
+	glDrawArrays(GL_TRIANGLES, range->first, range->count);
+
+	ImGui_ImplSdlGLES2_SetupMeshAttributes(nullptr);
+	ImGui_ImplSdlGLES2_SetupAttributes();
+	glUseProgram(g_ShaderHandle);
+}
+
+bool ImGui_ImplSdlGLES2_HasBoardMesh() {
+	return g_MeshShaderHandle != 0;
+}
+
+void ImGui_ImplSdlGLES2_SetDistanceFields(float filled_top, float outlined_top) {
+	g_DistanceFields[0] = filled_top;
+	g_DistanceFields[1] = outlined_top;
+}
+
+const StreamStats &ImGui_ImplSdlGLES2_GetStreamStats() {
+	return g_StreamStats;
+}
+
 static const char *ImGui_ImplSdlGLES2_GetClipboardText() {
 	return SDL_GetClipboardText();
 }
@@ -269,13 +435,28 @@ bool ImGui_ImplSdlGLES2_CreateDeviceObjects() {
 	    "}\n";
 
 	const GLchar *fragment_shader =
+	    "#ifdef GL_OES_standard_derivatives\n"
+	    "#extension GL_OES_standard_derivatives : enable\n"
+	    "#endif\n"
 	    "precision mediump float;\n"
 	    "varying vec2 Frag_UV;\n"
 	    "varying vec4 Frag_Color;\n"
 	    "uniform sampler2D Texture;\n"
+	    "uniform vec2 DistanceFields;\n"
 	    "void main()\n"
 	    "{\n"
-	    "	gl_FragColor = Frag_Color * texture2D( Texture, Frag_UV.st);\n"
+	    "	vec4 texel = texture2D( Texture, Frag_UV.st);\n"
+	    // Pin glyphs, a pixel wide edge filled in or not, see PinGlyphs.h; soft without derivatives
+	    "#ifdef GL_OES_standard_derivatives\n"
+	    "	float edge = max(fwidth(texel.a), 0.0001);\n"
+	    "#else\n"
+	    "	float edge = 0.125;\n"
+	    "#endif\n"
+	    "	if (Frag_UV.t >= DistanceFields.y)\n"
+	    "		texel.a = clamp(1.0 - abs(texel.a - 0.5) / edge, 0.0, 1.0);\n"
+	    "	else if (Frag_UV.t >= DistanceFields.x)\n"
+	    "		texel.a = clamp((texel.a - 0.5) / edge + 0.5, 0.0, 1.0);\n"
+	    "	gl_FragColor = Frag_Color * texel;\n"
 	    "}\n";
 
 	g_ShaderHandle = glCreateProgram();
@@ -308,26 +489,73 @@ bool ImGui_ImplSdlGLES2_CreateDeviceObjects() {
 	glAttachShader(g_ShaderHandle, g_FragHandle);
 	glLinkProgram(g_ShaderHandle);
 
-	g_AttribLocationTex      = glGetUniformLocation(g_ShaderHandle, "Texture");
-	g_AttribLocationProjMtx  = glGetUniformLocation(g_ShaderHandle, "ProjMtx");
-	g_AttribLocationPosition = glGetAttribLocation(g_ShaderHandle, "Position");
-	g_AttribLocationUV       = glGetAttribLocation(g_ShaderHandle, "UV");
-	g_AttribLocationColor    = glGetAttribLocation(g_ShaderHandle, "Color");
-
-	glGenBuffers(1, &g_VboHandle);
-	glGenBuffers(1, &g_ElementsHandle);
-
-	glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
-	glEnableVertexAttribArray(g_AttribLocationPosition);
-	glEnableVertexAttribArray(g_AttribLocationUV);
-	glEnableVertexAttribArray(g_AttribLocationColor);
-
-#define OFFSETOF(TYPE, ELEMENT) ((size_t) & (((TYPE *)0)->ELEMENT))
-	glVertexAttribPointer(g_AttribLocationPosition, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid *)OFFSETOF(ImDrawVert, pos));
-	glVertexAttribPointer(g_AttribLocationUV, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid *)OFFSETOF(ImDrawVert, uv));
-	glVertexAttribPointer(
-	    g_AttribLocationColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid *)OFFSETOF(ImDrawVert, col));
-#undef OFFSETOF
+	g_AttribLocationTex            = glGetUniformLocation(g_ShaderHandle, "Texture");
+	g_AttribLocationDistanceFields = glGetUniformLocation(g_ShaderHandle, "DistanceFields");
+	g_AttribLocationProjMtx        = glGetUniformLocation(g_ShaderHandle, "ProjMtx");
+	g_AttribLocationPosition       = glGetAttribLocation(g_ShaderHandle, "Position");
+	g_AttribLocationUV             = glGetAttribLocation(g_ShaderHandle, "UV");
+	g_AttribLocationColor          = glGetAttribLocation(g_ShaderHandle, "Color");
+
+	g_VboStream.Create(GL_ARRAY_BUFFER, false);
+	g_ElementsStream.Create(GL_ELEMENT_ARRAY_BUFFER, false);
+
+	g_VtxOffset = 0;
+	ImGui_ImplSdlGLES2_SetupAttributes();
+
+	// The board mesh shaders are written for GLSL ES 1.00 already
+	const GLchar *mesh_vertex_shader[]   = {"precision highp float;\n", BoardMesh::vertex_shader};
+	const GLchar *mesh_fragment_shader[] = {"#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+	                                        "precision highp float;\n"
+	                                        "#else\n"
+	                                        "precision mediump float;\n"
+	                                        "#endif\n"
+	                                        "#define FRAG_COLOR gl_FragColor\n",
+	                                        BoardMesh::fragment_shader};
+
+	g_MeshShaderHandle = glCreateProgram();
+	g_MeshVertHandle   = glCreateShader(GL_VERTEX_SHADER);
+	g_MeshFragHandle   = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(g_MeshVertHandle, 2, mesh_vertex_shader, 0);
+	glShaderSource(g_MeshFragHandle, 2, mesh_fragment_shader, 0);
+	glCompileShader(g_MeshVertHandle);
+	glCompileShader(g_MeshFragHandle);
+	glAttachShader(g_MeshShaderHandle, g_MeshVertHandle);
+	glAttachShader(g_MeshShaderHandle, g_MeshFragHandle);
+	glLinkProgram(g_MeshShaderHandle);
+
+	GLint linked;
+	glGetProgramiv(g_MeshShaderHandle, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		// The board view then draws through ImDrawList, see ImGui_ImplSdlGLES2_HasBoardMesh()
+		glGetProgramiv(g_MeshShaderHandle, GL_INFO_LOG_LENGTH, &logLength);
+		if (logLength > 1) {
+			GLchar *log = (GLchar *)malloc(logLength);
+			glGetProgramInfoLog(g_MeshShaderHandle, logLength, &logLength, log);
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Board mesh program link log:\n%s", log);
+			free(log);
+		}
+		glDeleteProgram(g_MeshShaderHandle);
+		g_MeshShaderHandle = 0;
+	} else {
+		g_MeshLocationOrigin    = glGetUniformLocation(g_MeshShaderHandle, "Origin");
+		g_MeshLocationAxisX     = glGetUniformLocation(g_MeshShaderHandle, "AxisX");
+		g_MeshLocationAxisY     = glGetUniformLocation(g_MeshShaderHandle, "AxisY");
+		g_MeshLocationDisplay   = glGetUniformLocation(g_MeshShaderHandle, "Display");
+		g_MeshLocationScale     = glGetUniformLocation(g_MeshShaderHandle, "Scale");
+		g_MeshLocationMinSize   = glGetUniformLocation(g_MeshShaderHandle, "MinSize");
+		g_MeshLocationAndMask   = glGetUniformLocation(g_MeshShaderHandle, "AndMask");
+		g_MeshLocationOrMask    = glGetUniformLocation(g_MeshShaderHandle, "OrMask");
+		g_MeshLocationLineWidth = glGetUniformLocation(g_MeshShaderHandle, "LineWidth");
+		g_MeshLocationPad       = glGetUniformLocation(g_MeshShaderHandle, "Pad");
+		g_MeshLocationStripes   = glGetUniformLocation(g_MeshShaderHandle, "Stripes");
+		g_MeshLocationPosition  = glGetAttribLocation(g_MeshShaderHandle, "Position");
+		g_MeshLocationSize      = glGetAttribLocation(g_MeshShaderHandle, "Size");
+		g_MeshLocationDirection = glGetAttribLocation(g_MeshShaderHandle, "Direction");
+		g_MeshLocationShape     = glGetAttribLocation(g_MeshShaderHandle, "Shape");
+		g_MeshLocationColor     = glGetAttribLocation(g_MeshShaderHandle, "Color");
+		g_MeshLocationMask      = glGetAttribLocation(g_MeshShaderHandle, "Mask");
+		for (auto &b : g_MeshBuffers) glGenBuffers(1, &b.vbo);
+	}
 
 	ImGui_ImplSdlGLES2_CreateFontsTexture();
 
@@ -339,9 +567,8 @@ bool ImGui_ImplSdlGLES2_CreateDeviceObjects() {
 }
 
 void ImGui_ImplSdlGLES2_InvalidateDeviceObjects() {
-	if (g_VboHandle) glDeleteBuffers(1, &g_VboHandle);
-	if (g_ElementsHandle) glDeleteBuffers(1, &g_ElementsHandle);
-	g_VboHandle = g_ElementsHandle = 0;
+	g_VboStream.Destroy();
+	g_ElementsStream.Destroy();
 
 	glDetachShader(g_ShaderHandle, g_VertHandle);
 	glDeleteShader(g_VertHandle);
@@ -354,6 +581,16 @@ void ImGui_ImplSdlGLES2_InvalidateDeviceObjects() {
 	glDeleteProgram(g_ShaderHandle);
 	g_ShaderHandle = 0;
 
+	for (auto &b : g_MeshBuffers) {
+		if (b.vbo) glDeleteBuffers(1, &b.vbo);
+		b = MeshBuffer();
+	}
+
+	glDeleteShader(g_MeshVertHandle);
+	glDeleteShader(g_MeshFragHandle);
+	glDeleteProgram(g_MeshShaderHandle);
+	g_MeshShaderHandle = g_MeshVertHandle = g_MeshFragHandle = 0;
+
 	if (g_FontTexture) {
 		glDeleteTextures(1, &g_FontTexture);
 		ImGui::GetIO().Fonts->TexID = 0;
@@ -10,12 +10,25 @@
 
 struct SDL_Window;
 typedef union SDL_Event SDL_Event;
+struct StreamStats;
 
 IMGUI_API bool ImGui_ImplSdlGLES2_Init(SDL_Window *window);
 IMGUI_API void ImGui_ImplSdlGLES2_Shutdown();
 IMGUI_API void ImGui_ImplSdlGLES2_NewFrame();
 IMGUI_API bool ImGui_ImplSdlGLES2_ProcessEvent(SDL_Event *event);
 
+// ImDrawCallback drawing a BoardMeshRange, see BoardMesh.h
+IMGUI_API void ImGui_ImplSdlGLES2_RenderBoardMesh(const ImDrawList *parent_list, const ImDrawCmd *cmd);
+
+// Whether its program built, known once the device objects are created; RenderBoardMesh draws nothing without it
+IMGUI_API bool ImGui_ImplSdlGLES2_HasBoardMesh();
+
+// What streaming the last frame's draw lists cost
+IMGUI_API const StreamStats &ImGui_ImplSdlGLES2_GetStreamStats();
+
+// Font texture V from which pin glyphs are filled, then outlined distance fields, see PinGlyphs.h
+IMGUI_API void ImGui_ImplSdlGLES2_SetDistanceFields(float filled_top, float outlined_top);
+
 // Use if you want to reset your rendering device without losing ImGui state.
 IMGUI_API void ImGui_ImplSdlGLES2_InvalidateDeviceObjects();
 IMGUI_API bool ImGui_ImplSdlGLES2_CreateDeviceObjects();
@@ -0,0 +1,64 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+void SpatialGrid::Build(const std::vector<GridBox> &boxes) {
+	m_cell_first.clear();
+	m_items.clear();
+	m_columns = m_rows = 0;
+
+	// Bounds of everything indexed
+	GridBox bounds = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+	size_t count   = 0;
+	for (auto &box : boxes) {
+		if (box.empty()) continue;
+		bounds.min_x = std::min(bounds.min_x, box.min_x);
+		bounds.min_y = std::min(bounds.min_y, box.min_y);
+		bounds.max_x = std::max(bounds.max_x, box.max_x);
+		bounds.max_y = std::max(bounds.max_y, box.max_y);
+		count++;
+	}
+	if (count == 0) return;
+
+	// Square cells, sized for a few items each if they were spread evenly
+	double width = bounds.max_x - bounds.min_x, height = bounds.max_y - bounds.min_y;
+	double cells          = std::max<double>(1, count / items_per_cell);
+	double cell           = std::sqrt(width * height / cells);
+	if (!(cell > 0)) cell = std::max(width, height) / cells; // All in a line
+
+	// but no smaller than most boxes, or each of them would be listed in many cells
+	std::vector<float> sides;
+	for (auto &box : boxes)
+		if (!box.empty()) sides.push_back(std::max(box.max_x - box.min_x, box.max_y - box.min_y));
+	std::nth_element(sides.begin(), sides.begin() + sides.size() / 2, sides.end());
+	cell                  = std::max<double>(cell, sides[sides.size() / 2]);
+	if (!(cell > 0)) cell = 1; // All at one point
+
+	m_x        = bounds.min_x;
+	m_y        = bounds.min_y;
+	m_inv_cell = 1 / cell;
+	m_columns  = std::min<double>(max_cells_side, std::floor(width / cell) + 1);
+	m_rows     = std::min<double>(max_cells_side, std::floor(height / cell) + 1);
+
+	// Count the items of each cell, then lay the cells out one after the other
+	m_cell_first.assign(m_columns * m_rows + 1, 0);
+	for (auto &box : boxes) {
+		if (box.empty()) continue;
+		int c0 = Column(box.min_x), c1 = Column(box.max_x), r1 = Row(box.max_y);
+		for (int r = Row(box.min_y); r <= r1; r++)
+			for (int c = c0; c <= c1; c++) m_cell_first[r * m_columns + c + 1]++;
+	}
+	for (size_t c = 1; c < m_cell_first.size(); c++) m_cell_first[c] += m_cell_first[c - 1];
+
+	// Items go in in order, so each cell lists them by number
+	m_items.resize(m_cell_first.back());
+	std::vector<uint32_t> next(m_cell_first.begin(), m_cell_first.end() - 1);
+	for (uint32_t item = 0; item < boxes.size(); item++) {
+		const GridBox &box = boxes[item];
+		if (box.empty()) continue;
+		int c0 = Column(box.min_x), c1 = Column(box.max_x), r1 = Row(box.max_y);
+		for (int r = Row(box.min_y); r <= r1; r++)
+			for (int c = c0; c <= c1; c++) m_items[next[r * m_columns + c]++] = item;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Axis aligned box in board coordinates, a point has min == max
+struct GridBox {
+	float min_x, min_y, max_x, max_y;
+
+	bool empty() const {
+		return min_x > max_x || min_y > max_y;
+	}
+};
+
+/*
+ * Uniform grid over the boxes of a set of items, answering "what is near
+ * here" in time proportional to the number of items around rather than on the
+ * whole board. Built in one go; items are numbered by their position in the
+ * vector given to Build().
+ *
+ * Queries give candidates: every item whose box shares a cell with the query
+ * area, which callers test exactly. An item is reported once for each cell it
+ * shares with the query, so points come up once and large boxes may repeat.
+ */
+class SpatialGrid {
+  public:
+	// Indexes boxes, replacing anything indexed before. Empty boxes are left out
+	void Build(const std::vector<GridBox> &boxes);
+
+	// Calls fn(item) for the candidates overlapping [min, max]
+	template <typename F>
+	void Query(float min_x, float min_y, float max_x, float max_y, F fn) const;
+
+	template <typename F>
+	void QueryPoint(float x, float y, F fn) const {
+		Query(x, y, x, y, fn);
+	}
+
+	template <typename F>
+	void QueryRadius(float x, float y, float radius, F fn) const {
+		Query(x - radius, y - radius, x + radius, y + radius, fn);
+	}
+
+	// Bytes used by the cells and item lists
+	size_t memory() const {
+		return m_cell_first.capacity() * sizeof(uint32_t) + m_items.capacity() * sizeof(uint32_t);
+	}
+
+  private:
+	static const int items_per_cell = 4;
+	static const int max_cells_side = 4096;
+
+	// Cell column or row of a coordinate, clamped to the grid
+	int Column(float x) const;
+	int Row(float y) const;
+
+	float m_x = 0, m_y = 0;       // Lower corner of the grid
+	float m_inv_cell = 1;         // Cells per board unit
+	int m_columns = 0, m_rows = 0;
+	std::vector<uint32_t> m_cell_first; // Items of cell c are m_items[first[c], first[c + 1])
+	std::vector<uint32_t> m_items;
+};
+
+inline int SpatialGrid::Column(float x) const {
+	float c = (x - m_x) * m_inv_cell;
+	if (!(c >= 0)) return 0; // Also catches NaN
+	return c >= m_columns ? m_columns - 1 : int(c);
+}
+
+inline int SpatialGrid::Row(float y) const {
+	float r = (y - m_y) * m_inv_cell;
+	if (!(r >= 0)) return 0;
+	return r >= m_rows ? m_rows - 1 : int(r);
+}
+
+template <typename F>
+void SpatialGrid::Query(float min_x, float min_y, float max_x, float max_y, F fn) const {
+	if (m_items.empty()) return;
+
+	int c0 = Column(min_x), c1 = Column(max_x);
+	int r1 = Row(max_y);
+	for (int r = Row(min_y); r <= r1; r++) {
+		const uint32_t *first = &m_cell_first[r * m_columns];
+		for (uint32_t i = first[c0]; i < first[c1 + 1]; i++) fn(m_items[i]); // Cells of a row are consecutive
+	}
+}
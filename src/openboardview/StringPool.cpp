@@ -0,0 +1,73 @@
+#include "StringPool.h"
+
+// FNV-1a, with a final mix so the low bits used for the slot index depend on every character
+uint32_t StringPool::hash(const char *str, size_t len) {
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < len; i++) {
+		h ^= static_cast<unsigned char>(str[i]);
+		h *= 16777619u;
+	}
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	return h;
+}
+
+Symbol StringPool::find(const char *str, size_t len) const {
+	if (m_slots.empty()) return no_symbol;
+
+	uint32_t h    = hash(str, len);
+	uint32_t mask = m_slots.size() - 1;
+	for (uint32_t i = h & mask;; i = (i + 1) & mask) {
+		const Slot &slot = m_slots[i];
+		if (slot.symbol == no_symbol) return no_symbol;
+		if (slot.hash == h && m_lengths[slot.symbol] == len && memcmp(m_strings[slot.symbol], str, len) == 0)
+			return slot.symbol;
+	}
+}
+
+Symbol StringPool::intern(const char *str, size_t len) {
+	if ((m_strings.size() + 1) * 2 > m_slots.size()) grow();
+
+	uint32_t h    = hash(str, len);
+	uint32_t mask = m_slots.size() - 1;
+	uint32_t i    = h & mask;
+	for (;; i = (i + 1) & mask) {
+		const Slot &slot = m_slots[i];
+		if (slot.symbol == no_symbol) break;
+		if (slot.hash == h && m_lengths[slot.symbol] == len && memcmp(m_strings[slot.symbol], str, len) == 0)
+			return slot.symbol;
+	}
+
+	char *copy = m_chars.alloc<char>(len + 1);
+	memcpy(copy, str, len);
+	copy[len] = '\0';
+	m_chars_size += len + 1;
+
+	Symbol symbol = m_strings.size();
+	m_strings.push_back(copy);
+	m_lengths.push_back(len);
+	m_slots[i] = Slot{h, symbol};
+	return symbol;
+}
+
+// Doubles the table, slots keep their hash so strings are not hashed again
+void StringPool::grow() {
+	std::vector<Slot> old(m_slots.empty() ? 64 : m_slots.size() * 2, Slot{0, no_symbol});
+	old.swap(m_slots);
+
+	uint32_t mask = m_slots.size() - 1;
+	for (const Slot &slot : old) {
+		if (slot.symbol == no_symbol) continue;
+		uint32_t i = slot.hash & mask;
+
+		while (m_slots[i].symbol != no_symbol) i = (i + 1) & mask;
+
+		m_slots[i] = slot;
+	}
+}
+
+size_t StringPool::memory() const {
+	return m_chars_size + m_strings.capacity() * sizeof(const char *) + m_lengths.capacity() * sizeof(uint32_t) +
+	       m_slots.capacity() * sizeof(Slot);
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Arena.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Identifies a string interned in a StringPool, they are numbered from 0 in interning order
+typedef uint32_t Symbol;
+static const Symbol no_symbol = UINT32_MAX;
+
+// An interned string. Names compare by symbol, so only names from the same pool may be compared
+class Name {
+  public:
+	Name() {}
+	Name(const char *str, Symbol symbol)
+	    : m_str(str)
+	    , m_symbol(symbol) {}
+
+	const char *c_str() const {
+		return m_str;
+	}
+	size_t size() const {
+		return strlen(m_str);
+	}
+	bool empty() const {
+		return m_str[0] == '\0';
+	}
+	char operator[](size_t i) const {
+		return m_str[i];
+	}
+	Symbol symbol() const {
+		return m_symbol;
+	}
+	operator std::string() const {
+		return m_str;
+	}
+
+  private:
+	const char *m_str = "";
+	Symbol m_symbol   = no_symbol;
+};
+
+// Names of a board all come from its pool, so the symbols alone tell whether the strings match.
+// A default constructed name is in no pool, it compares by its (empty) string.
+inline bool operator==(const Name &lhs, const Name &rhs) {
+	if (lhs.symbol() == no_symbol || rhs.symbol() == no_symbol) return strcmp(lhs.c_str(), rhs.c_str()) == 0;
+	assert((lhs.symbol() == rhs.symbol()) == (strcmp(lhs.c_str(), rhs.c_str()) == 0)); // Not from different pools
+	return lhs.symbol() == rhs.symbol();
+}
+inline bool operator==(const Name &lhs, const char *rhs) {
+	return strcmp(lhs.c_str(), rhs) == 0;
+}
+inline bool operator==(const Name &lhs, const std::string &rhs) {
+	return lhs == rhs.c_str();
+}
+inline bool operator!=(const Name &lhs, const Name &rhs) {
+	return !(lhs == rhs);
+}
+inline bool operator!=(const Name &lhs, const char *rhs) {
+	return !(lhs == rhs);
+}
+inline bool operator!=(const Name &lhs, const std::string &rhs) {
+	return !(lhs == rhs);
+}
+inline bool operator<(const Name &lhs, const Name &rhs) {
+	return strcmp(lhs.c_str(), rhs.c_str()) < 0;
+}
+
+/*
+ * Keeps a single copy of each distinct string and numbers them, so a board
+ * stores every part, net and pin name once and tells them apart by symbol.
+ *
+ * Strings are looked up in a flat open-addressing table (linear probing, at
+ * most half full) holding their hash next to the symbol, so a probe rarely
+ * needs to touch the characters. Strings are copied in to an arena and never
+ * move: pointers and Names stay valid for the lifetime of the arena.
+ */
+class StringPool {
+  public:
+	StringPool(Arena &chars)
+	    : m_chars(chars) {}
+	StringPool(const StringPool &) = delete;
+	StringPool &operator=(const StringPool &) = delete;
+
+	// Symbol of str, which is added if it was not in the pool yet
+	Symbol intern(const char *str, size_t len);
+	Symbol intern(const char *str) {
+		return intern(str, strlen(str));
+	}
+
+	// Symbol of str, no_symbol if it is not in the pool
+	Symbol find(const char *str, size_t len) const;
+	Symbol find(const std::string &str) const {
+		return find(str.data(), str.size());
+	}
+
+	const char *str(Symbol symbol) const {
+		return m_strings[symbol];
+	}
+	Name name(Symbol symbol) const {
+		return Name(m_strings[symbol], symbol);
+	}
+
+	// Number of distinct strings
+	size_t size() const {
+		return m_strings.size();
+	}
+
+	// Bytes used by the strings and the table
+	size_t memory() const;
+
+  private:
+	struct Slot {
+		uint32_t hash;
+		Symbol symbol; // no_symbol if the slot is free
+	};
+
+	static uint32_t hash(const char *str, size_t len);
+	void grow();
+
+	Arena &m_chars;
+	size_t m_chars_size = 0;
+	std::vector<const char *> m_strings; // Indexed by symbol
+	std::vector<uint32_t> m_lengths;
+	std::vector<Slot> m_slots; // Power of two sized
+};
@@ -311,12 +311,14 @@ int main(int argc, char **argv) {
 #endif
 #ifdef ENABLE_GL3
 	if (g.renderer == Renderer::OPENGL3) {
-		initialized = ImGui_ImplSdlGL3_Init(window);
+		initialized       = ImGui_ImplSdlGL3_Init(window);
+		app.m_streamStats = &ImGui_ImplSdlGL3_GetStreamStats();
 	}
 #endif
 #ifdef ENABLE_GLES2
 	if (g.renderer == Renderer::OPENGLES2) {
-		initialized = ImGui_ImplSdlGLES2_Init(window);
+		initialized       = ImGui_ImplSdlGLES2_Init(window);
+		app.m_streamStats = &ImGui_ImplSdlGLES2_GetStreamStats();
 	}
 #endif
 
@@ -393,6 +395,34 @@ int main(int argc, char **argv) {
 #endif
 	}
 
+	// Pin glyphs go in the font texture for the renderers whose shaders can draw them
+#ifdef ENABLE_GL3
+	if (g.renderer == Renderer::OPENGL3 && app.m_pinGlyphs.Bake(io.Fonts)) {
+		ImGui_ImplSdlGL3_SetDistanceFields(app.m_pinGlyphs.filled_top, app.m_pinGlyphs.outlined_top);
+	}
+#endif
+#ifdef ENABLE_GLES2
+	if (g.renderer == Renderer::OPENGLES2 && app.m_pinGlyphs.Bake(io.Fonts)) {
+		ImGui_ImplSdlGLES2_SetDistanceFields(app.m_pinGlyphs.filled_top, app.m_pinGlyphs.outlined_top);
+	}
+#endif
+
+	/*
+	 * The fonts are done, so the device objects can be made now rather than on
+	 * the first frame, to know whether the renderer can draw the board as a mesh.
+	 * If it can't, the board view draws it through ImDrawList.
+	 */
+#ifdef ENABLE_GL3
+	if (g.renderer == Renderer::OPENGL3 && ImGui_ImplSdlGL3_CreateDeviceObjects() && ImGui_ImplSdlGL3_HasBoardMesh()) {
+		app.m_boardMeshCallback = ImGui_ImplSdlGL3_RenderBoardMesh;
+	}
+#endif
+#ifdef ENABLE_GLES2
+	if (g.renderer == Renderer::OPENGLES2 && ImGui_ImplSdlGLES2_CreateDeviceObjects() && ImGui_ImplSdlGLES2_HasBoardMesh()) {
+		app.m_boardMeshCallback = ImGui_ImplSdlGLES2_RenderBoardMesh;
+	}
+#endif
+
 	// ImVec4 clear_color = ImColor(20, 20, 30);
 	ImVec4 clear_color = ImColor(app.m_colors.backgroundColor);
 
@@ -456,6 +486,8 @@ int main(int argc, char **argv) {
 			clear_color = ImColor(app.m_colors.backgroundColor);
 		}
 
+		if (app.IsLoading()) sleepout = 3; // Keep drawing the progress until the board is in
+
 		if (!(sleepout--)) {
 #ifdef _WIN32
 			Sleep(50);
@@ -0,0 +1,161 @@
+#include "platform.h" // Should be kept first
+#include "mappedfile.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef MAP_ANONYMOUS // OS X
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string &utf8_filename, Mode mode) {
+	int wlen = MultiByteToWideChar(CP_UTF8, 0, utf8_filename.c_str(), -1, NULL, 0);
+	std::wstring wfilename(wlen, L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, utf8_filename.c_str(), -1, &wfilename[0], wlen);
+
+	HANDLE file = CreateFileW(wfilename.c_str(),
+	                          GENERIC_READ,
+	                          FILE_SHARE_READ,
+	                          NULL,
+	                          OPEN_EXISTING,
+	                          FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+	                          NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		std::cerr << "Error opening " << utf8_filename << ": error " << GetLastError() << std::endl;
+		return;
+	}
+
+	LARGE_INTEGER fsize;
+	if (!GetFileSizeEx(file, &fsize) || fsize.QuadPart == 0 || static_cast<unsigned long long>(fsize.QuadPart) >= SIZE_MAX) {
+		CloseHandle(file);
+		return;
+	}
+	size_t size = static_cast<size_t>(fsize.QuadPart);
+
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+
+	// The bytes following EOF up to the end of the last page read as zero, but when the file
+	// ends exactly on a page boundary there is no room left for the terminator.
+	if (size % si.dwPageSize != 0) {
+		HANDLE mapping = CreateFileMappingW(file, NULL, mode == Mode::CopyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+		if (mapping) {
+			DWORD access = mode == Mode::CopyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ;
+			m_data       = static_cast<char *>(MapViewOfFile(mapping, access, 0, 0, 0));
+			CloseHandle(mapping); // The view keeps the mapping alive
+		}
+	}
+
+	if (!m_data) {
+		m_data      = static_cast<char *>(malloc(size + 1));
+		DWORD nread = 0;
+		for (size_t pos = 0; m_data && pos < size; pos += nread) {
+			DWORD chunk = static_cast<DWORD>(std::min<size_t>(size - pos, 1 << 30));
+			if (!ReadFile(file, m_data + pos, chunk, &nread, NULL) || nread == 0) {
+				free(m_data);
+				m_data = nullptr;
+			}
+		}
+		if (m_data) m_data[size] = 0;
+		m_heap                   = true;
+	}
+	CloseHandle(file);
+
+	if (!m_data) {
+		std::cerr << "Error mapping " << utf8_filename << ": error " << GetLastError() << std::endl;
+		return;
+	}
+	m_size        = size;
+	m_mapped_size = size + 1;
+}
+
+void MappedFile::unmap() {
+	if (!m_data) return;
+	if (m_heap)
+		free(m_data);
+	else
+		UnmapViewOfFile(m_data);
+}
+#else
+MappedFile::MappedFile(const std::string &utf8_filename, Mode mode) {
+	int fd = open(utf8_filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cerr << "Error opening " << utf8_filename << ": " << strerror(errno) << std::endl;
+		return;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+		close(fd);
+		return;
+	}
+	size_t size = static_cast<size_t>(st.st_size);
+
+	// Reserve one page more than the file needs with an anonymous (zero-filled) mapping,
+	// then map the file over the start of it. Whatever follows EOF reads as NUL.
+	size_t page      = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t mapped    = (size / page + 1) * page;
+	int prot         = PROT_READ | (mode == Mode::CopyOnWrite ? PROT_WRITE : 0);
+	void *base       = mmap(nullptr, mapped, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	void *file_start = MAP_FAILED;
+	if (base != MAP_FAILED) {
+		file_start = mmap(base, size, prot, MAP_PRIVATE | MAP_FIXED, fd, 0);
+		if (file_start == MAP_FAILED) munmap(base, mapped);
+	}
+	int err = errno;
+	close(fd); // The mapping holds its own reference to the file
+
+	if (file_start == MAP_FAILED) {
+		std::cerr << "Error mapping " << utf8_filename << ": " << strerror(err) << std::endl;
+		return;
+	}
+	posix_madvise(file_start, size, POSIX_MADV_SEQUENTIAL); // Parsers walk the file front to back
+
+	m_data        = static_cast<char *>(file_start);
+	m_size        = size;
+	m_mapped_size = mapped;
+}
+
+void MappedFile::unmap() {
+	if (m_data) munmap(m_data, m_mapped_size);
+}
+#endif
+
+MappedFile::MappedFile(MappedFile &&other)
+    : m_data(other.m_data)
+    , m_size(other.m_size)
+    , m_mapped_size(other.m_mapped_size)
+    , m_heap(other.m_heap) {
+	other.m_data        = nullptr;
+	other.m_size        = 0;
+	other.m_mapped_size = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) {
+	if (this != &other) {
+		unmap();
+		m_data              = other.m_data;
+		m_size              = other.m_size;
+		m_mapped_size       = other.m_mapped_size;
+		m_heap              = other.m_heap;
+		other.m_data        = nullptr;
+		other.m_size        = 0;
+		other.m_mapped_size = 0;
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile() {
+	unmap();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+/*
+ * Maps an entire file in to memory.
+ *
+ * ReadOnly mappings share the page cache and cannot be written to.
+ * CopyOnWrite mappings are private: parsers can terminate strings in place
+ * and only the pages they touch get copied.
+ *
+ * In both modes data()[size()] is guaranteed to be a NUL byte so the buffer
+ * can be walked as a C string.
+ */
+class MappedFile {
+  public:
+	enum class Mode { ReadOnly, CopyOnWrite };
+
+	MappedFile(){};
+	MappedFile(const std::string &utf8_filename, Mode mode = Mode::ReadOnly);
+	MappedFile(MappedFile &&other);
+	MappedFile &operator=(MappedFile &&other);
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	char *data() {
+		return m_data;
+	}
+	const char *data() const {
+		return m_data;
+	}
+	size_t size() const {
+		return m_size;
+	}
+	bool empty() const {
+		return m_size == 0;
+	}
+
+  private:
+	void unmap();
+
+	char *m_data         = nullptr;
+	size_t m_size        = 0;
+	size_t m_mapped_size = 0;     // Size of the whole reservation, including the terminating page
+	bool m_heap          = false; // Fallback when the file cannot be mapped with room for the terminator
+};
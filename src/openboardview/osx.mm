@@ -41,7 +41,7 @@ const std::string get_font_path(const std::string &name) {
 #endif
 
 // Inspired by https://developer.apple.com/library/mac/documentation/FileManagement/Conceptual/FileSystemProgrammingGuide/ManagingFIlesandDirectories/ManagingFIlesandDirectories.html
-// userdir is ignored for now since common usage puts both config file and history file in ApplicationSupport directory
+// Config and Data are the same since common usage puts both config file and history file in ApplicationSupport directory
 const std::string get_user_dir(const UserDir userdir) {
 	std::string configPath;
 	NSFileManager *fm = [NSFileManager defaultManager];
@@ -53,6 +53,7 @@ const std::string get_user_dir(const UserDir userdir) {
 	if ([appSupportDir count] > 0) {
 		// Append OpenBoardView to the Application Support directory path
 		configURL = [[appSupportDir objectAtIndex:0] URLByAppendingPathComponent:@"OpenBoardView/"];
+		if (userdir == UserDir::Cache) configURL = [configURL URLByAppendingPathComponent:@"cache/"];
 
 		// If the directory does not exist, this method creates it.
 		// This method is only available in OS X v10.7 and iOS 5.0 or later.
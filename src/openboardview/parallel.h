@@ -0,0 +1,55 @@
+#pragma once
+
+/*
+ * Minimal fork/join helper for the file parsers.
+ * There is no thread pool: loading a board is rare enough that spawning a
+ * handful of threads costs nothing next to the work being split.
+ */
+
+#include <algorithm>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+inline size_t &parallel_threads_setting() {
+	static size_t threads = std::max(1u, std::thread::hardware_concurrency());
+	return threads;
+}
+
+// Number of threads parallel_for() splits work in to, the hardware threads by default
+inline size_t parallel_threads() {
+	return parallel_threads_setting();
+}
+
+// Lets tests split work the same way on any machine, set before any parallel_for() runs
+inline void set_parallel_threads(size_t threads) {
+	parallel_threads_setting() = std::max<size_t>(1, threads);
+}
+
+/*
+ * Calls fn(begin, end) on contiguous, disjoint ranges covering [0, count), one
+ * range per thread, and waits for all of them. Ranges hold at least min_chunk
+ * items so small jobs stay on the calling thread, which always takes the last
+ * range. fn must not touch anything outside of its own range.
+ */
+template <typename F>
+void parallel_for(size_t count, size_t min_chunk, F fn) {
+	size_t threads = std::min(parallel_threads(), count / std::max<size_t>(min_chunk, 1));
+	if (threads <= 1) {
+		if (count) fn(size_t(0), count);
+		return;
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve(threads - 1);
+	size_t chunk = count / threads;
+	size_t extra = count % threads; // The first ranges get one more item
+	size_t begin = 0;
+	for (size_t t = 0; t + 1 < threads; t++) {
+		size_t end = begin + chunk + (t < extra);
+		workers.emplace_back([&fn, begin, end]() { fn(begin, end); });
+		begin = end;
+	}
+	fn(begin, count);
+	for (auto &w : workers) w.join();
+}
@@ -72,5 +72,8 @@ const std::string show_file_picker();
 const std::string get_font_path(const std::string &name);
 const std::vector<char> load_font(const std::string &name);
 
-enum class UserDir { Config, Data };
+enum class UserDir { Config, Data, Cache }; // Cache is a subdirectory of Config
 const std::string get_user_dir(const UserDir userdir);
+
+// Resident memory of the process in bytes, 0 if it cannot be told
+size_t get_resident_memory();
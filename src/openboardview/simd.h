@@ -0,0 +1,87 @@
+#pragma once
+
+/*
+ * Helpers for the vectorised paths of the file parsers.
+ * SSE2 is part of x86-64 so it is used unconditionally there. AVX2 paths are
+ * compiled with a target attribute on GCC/Clang and picked at runtime, or
+ * used directly when the whole build targets AVX2 (MSVC /arch:AVX2).
+ * Everything has a scalar fallback for other architectures.
+ *
+ * Tests can lower the level the paths are picked up to with set_simd_level(),
+ * to check the vector paths against the scalar code on the same machine.
+ */
+
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OBV_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(OBV_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define OBV_AVX2 1
+#define OBV_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(OBV_SSE2) && defined(__AVX2__)
+#define OBV_AVX2 1
+#define OBV_TARGET_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit, v must not be 0
+inline int ctz32(uint32_t v) {
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanForward(&i, v);
+	return static_cast<int>(i);
+#else
+	return __builtin_ctz(v);
+#endif
+}
+
+// Number of set bits
+inline int popcount32(uint32_t v) {
+#ifdef _MSC_VER
+	return static_cast<int>(__popcnt(v));
+#else
+	return __builtin_popcount(v);
+#endif
+}
+
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+inline SimdLevel &simd_level_setting() {
+	static SimdLevel level = SimdLevel::AVX2;
+	return level;
+}
+
+// Highest level the vector paths are used up to, set before any parsing starts
+inline void set_simd_level(SimdLevel level) {
+	simd_level_setting() = level;
+}
+
+// True if the SSE2 paths can be used, always on x86-64 unless lowered
+inline bool cpu_has_sse2() {
+#ifdef OBV_SSE2
+	return simd_level_setting() >= SimdLevel::SSE2;
+#else
+	return false;
+#endif
+}
+
+// True if the AVX2 paths can be used on this CPU
+inline bool cpu_has_avx2() {
+	if (simd_level_setting() < SimdLevel::AVX2) return false;
+#if defined(__AVX2__)
+	return true;
+#elif defined(OBV_AVX2)
+	static const bool has_avx2 = __builtin_cpu_supports("avx2");
+	return has_avx2;
+#else
+	return false;
+#endif
+}
@@ -5,8 +5,14 @@
 #include <SDL2/SDL.h>
 #include <assert.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
 
 #ifdef ENABLE_GTK
 #include <gtk/gtk.h>
@@ -216,7 +222,7 @@ const std::string get_user_dir(const UserDir userdir) {
 	std::string path;
 	std::string envVar;
 
-	if (userdir == UserDir::Config)
+	if (userdir == UserDir::Config || userdir == UserDir::Cache)
 		envVar = get_env_var("XDG_CONFIG_HOME");
 	else if (userdir == UserDir::Data)
 		envVar = get_env_var("XDG_DATA_HOME");
@@ -225,7 +231,7 @@ const std::string get_user_dir(const UserDir userdir) {
 		envVar = get_env_var("HOME");
 		if (!envVar.empty()) {
 			path += std::string(envVar);
-			if (userdir == UserDir::Config)
+			if (userdir == UserDir::Config || userdir == UserDir::Cache)
 				path += "/.config";
 			else if (userdir == UserDir::Data)
 				path += "/.local/share";
@@ -233,10 +239,28 @@ const std::string get_user_dir(const UserDir userdir) {
 	}
 	if (!path.empty()) {
 		path += "/openboardview/";
+		if (userdir == UserDir::Cache) path += "cache/";
 		if (create_dirs(path)) return path; // Check if dir already exists and create it otherwise
 	}
 	return "./"; // Something went wrong, use current dir
 }
 #endif
 
+size_t get_resident_memory() {
+#ifdef __APPLE__
+	mach_task_basic_info info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) return 0;
+	return info.resident_size;
+#else
+	// Second field of statm is the resident set size in pages, there is no /proc on the BSDs
+	long size = 0, resident = 0;
+	FILE *statm = fopen("/proc/self/statm", "r");
+	if (!statm) return 0;
+	if (fscanf(statm, "%ld %ld", &size, &resident) != 2) resident = 0;
+	fclose(statm);
+	return resident * sysconf(_SC_PAGESIZE);
+#endif
+}
+
 #endif
@@ -4,7 +4,6 @@
 #include <assert.h>
 #include <cctype>
 #include <cstring>
-#include <fstream>
 #include <iostream>
 #include <iterator>
 #include <sstream>
@@ -14,30 +13,6 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
-// Loads an entire file in to memory
-std::vector<char> file_as_buffer(const std::string &utf8_filename) {
-	std::vector<char> data;
-	std::ifstream file;
-	file.open(utf8_filename, std::ios::in | std::ios::binary | std::ios::ate);
-
-	if (!file.is_open()) {
-		std::cerr << "Error opening " << utf8_filename << ": " << strerror(errno) << std::endl;
-		return data;
-	}
-
-	file.seekg(0, std::ios_base::end);
-	std::streampos sz = file.tellg();
-	assert(sz >= 0);
-	data.reserve(sz);
-	file.seekg(0, std::ios_base::beg);
-	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
-
-	assert(data.size() == static_cast<unsigned int>(sz));
-	file.close();
-
-	return data;
-}
-
 // Extract extension from filename and check against given fileext
 // fileext must be lowercase
 bool check_fileext(const std::string &filename, const std::string fileext) {
@@ -48,8 +23,8 @@ bool check_fileext(const std::string &filename, const std::string fileext) {
 }
 
 // Retunrs true if the given str was found in buf
-bool find_str_in_buf(const std::string str, const std::vector<char> &buf) {
-	return std::search(buf.begin(), buf.end(), str.begin(), str.end()) != buf.end();
+bool find_str_in_buf(const std::string str, const char *buf, size_t buf_size) {
+	return std::search(buf, buf + buf_size, str.begin(), str.end()) != buf + buf_size;
 }
 
 // Case insensitive comparison of std::string
@@ -1,4 +1,6 @@
 #include "imgui/imgui.h"
+#include <algorithm>
+#include <cfloat>
 #include <cmath>
 #include <iostream>
 #include <limits.h>
@@ -194,6 +196,105 @@ int VHConvexHull(ImVec2 hull[], ImVec2 points[], int n) {
 	return hpc;
 }
 
+// Cross product of (a - o) and (b - o), positive if o, a, b turn counterclockwise
+static double VHCross(ImVec2 o, ImVec2 a, ImVec2 b) {
+	return ((double)a.x - o.x) * ((double)b.y - o.y) - ((double)a.y - o.y) * ((double)b.x - o.x);
+}
+
+int VHConvexHullMonotone(ImVec2 hull[], ImVec2 points[], int n) {
+	int hpc = 0;
+
+	// There must be at least 3 points
+	if (n < 3) return 0;
+
+	std::sort(points, points + n, [](const ImVec2 &a, const ImVec2 &b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+
+	/*
+	 * Points above the line from the first to the last point can only be on
+	 * the upper hull, the others only on the lower one. Each point is tried
+	 * for one of them, so the hull never needs more than n entries.
+	 */
+	ImVec2 first = points[0], last = points[n - 1];
+
+	// Lower hull, left to right
+	for (int i = 0; i < n; i++) {
+		if (i > 0 && i < n - 1 && VHCross(first, last, points[i]) > 0) continue;
+		while (hpc >= 2 && VHCross(hull[hpc - 2], hull[hpc - 1], points[i]) <= 0) hpc--;
+		hull[hpc++] = points[i];
+	}
+
+	// Upper hull, right to left, closed by the first point which is not added again
+	int lower = hpc + 1;
+	for (int i = n - 2; i >= 0; i--) {
+		if (i > 0 && VHCross(first, last, points[i]) <= 0) continue;
+		while (hpc >= lower && VHCross(hull[hpc - 2], hull[hpc - 1], points[i]) <= 0) hpc--;
+		if (i > 0) hull[hpc++] = points[i];
+	}
+
+	return hpc;
+}
+
+void VHMBBCalipers(ImVec2 box[], ImVec2 *hull, int n, double psz) {
+	double mbArea = DBL_MAX;
+	double ex = 1, ey = 0;                         // Direction of the box's base
+	double umin = 0, umax = 0, vmin = 0, vmax = 0; // Box extents along the base and its normal
+	int i, j = 0, k = 0, l = 0;                    // Calipers: furthest along the base, normal, and back along the base
+
+	if (n <= 0) return;
+
+	// Work relative to the first point, board coordinates are large next to part sizes
+	ImVec2 origin = hull[0];
+	auto u        = [&](int p, double dx, double dy) {
+		return ((double)hull[p % n].x - origin.x) * dx + ((double)hull[p % n].y - origin.y) * dy;
+	};
+	bool started = false;
+
+	for (i = 0; i < n; i++) {
+		double dx  = (double)hull[(i + 1) % n].x - hull[i].x;
+		double dy  = (double)hull[(i + 1) % n].y - hull[i].y;
+		double len = sqrt(dx * dx + dy * dy);
+		if (len == 0) continue; // Repeated point
+		dx /= len;
+		dy /= len;
+
+		// The calipers only ever move forward, once around the hull in total
+		if (!started) j = k = l = i;
+		started      = true;
+		if (j < i) j = i;
+		while (j < i + n && u(j + 1, dx, dy) > u(j, dx, dy)) j++;
+		if (k < j) k = j;
+		while (k < j + n && u(k + 1, -dy, dx) > u(k, -dy, dx)) k++;
+		if (l < k) l = k;
+		while (l < k + n && u(l + 1, dx, dy) < u(l, dx, dy)) l++;
+
+		double base = u(i, -dy, dx); // The edge itself is on the box
+		double area = (u(j, dx, dy) - u(l, dx, dy)) * (u(k, -dy, dx) - base);
+
+		if (area < mbArea) {
+			mbArea = area;
+			ex     = dx;
+			ey     = dy;
+			umin   = u(l, dx, dy);
+			umax   = u(j, dx, dy);
+			vmin   = base;
+			vmax   = u(k, -dy, dx);
+		}
+	}
+
+	// expand by pin size
+	umin -= psz;
+	vmin -= psz;
+	umax += psz;
+	vmax += psz;
+
+	// Back from the base's frame in to board coordinates, in the order of VHMBBCalculate()
+	auto corner = [&](double cu, double cv) { return ImVec2(origin.x + cu * ex - cv * ey, origin.y + cu * ey + cv * ex); };
+	box[0]      = corner(umin, vmin);
+	box[1]      = corner(umax, vmin);
+	box[2]      = corner(umax, vmax);
+	box[3]      = corner(umin, vmax);
+}
+
 int VHTightenHull(ImVec2 hull[], int n, double threshold) {
 	// theory: circle the hull, compare 3 points at a time, if the mid point is
 	// sub-angular then make it equal the first point and move to the 3rd.
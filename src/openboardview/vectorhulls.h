@@ -10,6 +10,20 @@ int VHConvexHull(ImVec2 hull[], ImVec2 points[], int n);
 int VHTightenHull(ImVec2 hull[], int n, double threshold);
 void VHMBBCalculate(ImVec2 box[], ImVec2 *hull, int n, double psz);
 
+/*
+ * Monotone chain hull, O(n log n) against O(n * h) for VHConvexHull(). The
+ * hull is counterclockwise like VHConvexHull()'s, starts from the lowest of the
+ * leftmost points and has no colinear points. points are sorted in
+ * place.
+ */
+int VHConvexHullMonotone(ImVec2 hull[], ImVec2 points[], int n);
+
+/*
+ * Rotating calipers minimum area box of a counterclockwise convex hull, O(n)
+ * against O(n^2) for VHMBBCalculate(), laid out the same. hull is not modified.
+ */
+void VHMBBCalipers(ImVec2 box[], ImVec2 *hull, int n, double psz);
+
 bool GetIntersection(ImVec2 p0, ImVec2 p1, ImVec2 p2, ImVec2 p3, ImVec2 *i);
 
 #endif
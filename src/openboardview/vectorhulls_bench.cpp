@@ -0,0 +1,101 @@
+/*
+ * Micro-benchmark of the part outline functions in vectorhulls: the Jarvis
+ * march hull and rotation based minimum box used to outline parts, against
+ * their monotone chain and rotating calipers replacements.
+ *
+ * Point sets are synthetic BGA grids and two row connectors at the 1/1000"
+ * pitches found in board files, rotated off the axes like placed parts.
+ * Usage: vectorhulls_bench [repeats]
+ */
+#include "imgui/imgui.h"
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "vectorhulls.h"
+
+struct PointSet {
+	const char *name;
+	std::vector<ImVec2> points;
+};
+
+// cols x rows pins at pitch, rotated by degrees about the first pin, placed far from the origin like on a board
+static PointSet Grid(const char *name, int cols, int rows, float pitch, double degrees) {
+	double angle = degrees * 3.14159265358979323846 / 180;
+	PointSet set{name, {}};
+	for (int y = 0; y < rows; y++) {
+		for (int x = 0; x < cols; x++) {
+			double px = 20000 + x * pitch, py = 15000 + y * pitch;
+			VHRotateV(&px, &py, 20000, 15000, angle);
+			set.points.push_back(ImVec2(px, py));
+		}
+	}
+	return set;
+}
+
+static double Area(const ImVec2 box[4]) {
+	double w = hypot(box[1].x - box[0].x, box[1].y - box[0].y);
+	double h = hypot(box[3].x - box[0].x, box[3].y - box[0].y);
+	return w * h;
+}
+
+// Microseconds per call of fn, averaged over repeats
+template <typename F>
+static double Time(int repeats, F fn) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < repeats; i++) fn();
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeats;
+}
+
+int main(int argc, char **argv) {
+	int repeats              = argc > 1 ? atoi(argv[1]) : 20;
+	if (repeats < 1) repeats = 1;
+
+	std::vector<PointSet> sets;
+	sets.push_back(Grid("BGA 8x8", 8, 8, 31.5f, 0));
+	sets.push_back(Grid("BGA 16x16 @30", 16, 16, 31.5f, 30));
+	sets.push_back(Grid("BGA 32x32 @45", 32, 32, 39.4f, 45));
+	sets.push_back(Grid("BGA 48x48 @10", 48, 48, 39.4f, 10));
+	sets.push_back(Grid("BGA 64x64 @60", 64, 64, 31.5f, 60));
+	sets.push_back(Grid("CN 2x100 @20", 100, 2, 19.7f, 20));
+	sets.push_back(Grid("CN 2x600 @80", 600, 2, 19.7f, 80));
+
+	printf("%-16s %6s %5s | %12s %12s | %12s %12s | %s\n", "set", "pins", "hull", "jarvis us", "monotone us", "rotate us",
+	       "calipers us", "box area old/new");
+
+	for (auto &set : sets) {
+		int n = set.points.size();
+		std::vector<ImVec2> points(n), hull(n), scratch(n);
+		ImVec2 old_box[4], new_box[4];
+
+		int old_hpc = 0, new_hpc = 0;
+		double jarvis = Time(repeats, [&]() {
+			points  = set.points;
+			old_hpc = VHConvexHull(hull.data(), points.data(), n);
+		});
+		std::vector<ImVec2> old_hull(hull.begin(), hull.begin() + old_hpc);
+
+		double monotone = Time(repeats, [&]() {
+			points  = set.points;
+			new_hpc = VHConvexHullMonotone(hull.data(), points.data(), n);
+		});
+		std::vector<ImVec2> new_hull(hull.begin(), hull.begin() + new_hpc);
+
+		// VHMBBCalculate() moves the hull about, so it gets a fresh copy every time
+		double rotate = Time(repeats, [&]() {
+			scratch = old_hull;
+			VHMBBCalculate(old_box, scratch.data(), old_hpc, 0);
+		});
+		double calipers = Time(repeats, [&]() {
+			scratch = new_hull;
+			VHMBBCalipers(new_box, scratch.data(), new_hpc, 0);
+		});
+
+		printf("%-16s %6d %5d | %12.1f %12.1f | %12.1f %12.1f | %.0f/%.0f\n", set.name, n, new_hpc, jarvis, monotone, rotate,
+		       calipers, Area(old_box), Area(new_box));
+	}
+
+	return 0;
+}
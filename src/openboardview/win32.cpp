@@ -7,6 +7,7 @@
 #include <codecvt>
 #include <iostream>
 #include <locale>
+#include <psapi.h>
 #include <shlobj.h>
 #include <shobjidl.h>
 #include <stdint.h>
@@ -141,7 +142,7 @@ const std::string get_user_dir(const UserDir userdir) {
 	int cdret = 0;
 	std::string configPath;
 	PWSTR envVar = nullptr;
-	if (userdir == UserDir::Config)
+	if (userdir == UserDir::Config || userdir == UserDir::Cache)
 		SHGetKnownFolderPath(FOLDERID_RoamingAppData, 0, NULL, &envVar);
 	else if (userdir == UserDir::Data)
 		SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, NULL, &envVar);
@@ -151,6 +152,11 @@ const std::string get_user_dir(const UserDir userdir) {
 		configPath += "\\OpenBoardView\\";
 		auto configPathu16 = utf8_to_utf16(configPath);
 		cdret = CreateDirectoryW(utf16_to_wchar(configPathu16), NULL); // Doesn't work recursively but it's not an issue here
+		if (userdir == UserDir::Cache && (cdret != 0 || GetLastError() == ERROR_ALREADY_EXISTS)) {
+			configPath += "cache\\";
+			configPathu16 = utf8_to_utf16(configPath);
+			cdret         = CreateDirectoryW(utf16_to_wchar(configPathu16), NULL);
+		}
 	}
 	CoTaskMemFree(envVar);
 
@@ -158,4 +164,10 @@ const std::string get_user_dir(const UserDir userdir) {
 	return configPath;
 }
 
+size_t get_resident_memory() {
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return counters.WorkingSetSize;
+}
+
 #endif